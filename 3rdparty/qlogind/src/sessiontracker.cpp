@@ -22,16 +22,20 @@
 
 #include "orgfreedesktoplogin1Manager.h"
 
-SessionTracker::SessionTracker(QObject* parent): QObject(parent)
+SessionTracker::SessionTracker(QObject* parent, const QDBusConnection &connection): QObject(parent),
+    m_connection(connection)
 {
-    m_managerIface = new OrgFreedesktopLogin1ManagerInterface("org.freedesktop.login1", "/org/freedesktop/login1", QDBusConnection::systemBus());
+    m_managerIface = new OrgFreedesktopLogin1ManagerInterface("org.freedesktop.login1", "/org/freedesktop/login1", m_connection, this);
 
     connect(m_managerIface, &OrgFreedesktopLogin1ManagerInterface::SessionNew, this, [=](const QString &, const QDBusObjectPath &objectPath) {
-        PendingSession *ps = Session::sessionFromPath(objectPath);
+        PendingSession *ps = Session::sessionFromPath(objectPath, m_connection);
         connect(ps, &PendingInterfaceInternal::finished, this, [=](){
             emit sessionAdded(ps->interface());
         });
     });
+    connect(m_managerIface, &OrgFreedesktopLogin1ManagerInterface::SessionRemoved, this, [=](const QString &id, const QDBusObjectPath &objectPath) {
+        emit sessionRemoved(id, objectPath);
+    });
 }
 
 
@@ -46,7 +50,7 @@ PendingSessions* SessionTracker::listSessions()
         watcher->deleteLater();
         QList<PendingSession*> sessionsToLoad;
         foreach(const SessionInfo &sessionInfo, reply.value()) {
-            sessionsToLoad << Session::sessionFromPath(sessionInfo.sessionPath);
+            sessionsToLoad << Session::sessionFromPath(sessionInfo.sessionPath, m_connection);
         }
         ps->setPendingItems(sessionsToLoad);
     });
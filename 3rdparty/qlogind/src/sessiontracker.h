@@ -22,6 +22,7 @@
 #define SESSIONTRACKER_H
 
 #include <QObject>
+#include <QDBusConnection>
 
 #include "session.h"
 
@@ -35,14 +36,16 @@ class QLOGIND_EXPORT SessionTracker : public QObject
 {
     Q_OBJECT
 public:
-    SessionTracker(QObject *parent);
+    SessionTracker(QObject *parent, const QDBusConnection &connection = QDBusConnection::systemBus());
     PendingSessions* listSessions();
 
 Q_SIGNALS:
     void sessionAdded(const SessionPtr &session);
+    void sessionRemoved(const QString &id, const QDBusObjectPath &path);
 
 private:
     OrgFreedesktopLogin1ManagerInterface *m_managerIface;
+    QDBusConnection m_connection;
 };
 
 #endif // SESSIONTRACKER_H
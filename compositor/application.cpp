@@ -125,6 +125,9 @@ void Application::startup()
     // Launch autostart applications
     autostart();
 
+    // Warm up frequently used applications
+    m_launcher->startPrelaunch();
+
     m_started = true;
 }
 
@@ -0,0 +1,768 @@
+/****************************************************************************
+ * This file is part of Hawaii.
+ *
+ * Copyright (C) 2016 Pier Luigi Fiorini
+ *
+ * Author(s):
+ *    Pier Luigi Fiorini <pierluigi.fiorini@gmail.com>
+ *
+ * $BEGIN_LICENSE:GPL2+$
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * $END_LICENSE$
+ ***************************************************************************/
+
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QProcess>
+#include <QtCore/QSettings>
+#include <QtCore/QStandardPaths>
+#include <QtCore/QTimer>
+#include <QtCore/qmath.h>
+#include <QtDBus/QDBusConnection>
+#include <QtDBus/QDBusConnectionInterface>
+#include <QtDBus/QDBusPendingCallWatcher>
+#include <QtDBus/QDBusPendingReply>
+#include <QtDBus/QDBusServiceWatcher>
+
+#include <qt5xdg/xdgdesktopfile.h>
+
+#include "prelaunchpool.h"
+#include "processlauncher.h"
+
+#include <algorithm>
+
+#include <errno.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+Q_LOGGING_CATEGORY(PRELAUNCH, "hawaii.launcher.prelaunch")
+
+// Give the session some time to settle before warming up applications
+static const int startupDelay = 15000;
+
+// Delay between two instances, they are started one at a time
+static const int refillDelay = 3000;
+
+// How long an instance has to register its bus name
+static const int readyTimeout = 20000;
+
+// How long an instance has to quit before being killed
+static const int killTimeout = 1000;
+
+// Applications started as a service quit when idle, GApplication
+// after 10 seconds; calls made more often than that keep them busy
+static const int keepAliveInterval = 5000;
+
+// Instances that quit or crash are started again later, doubling
+// the delay every time, crashing ones are eventually given up
+static const qint64 initialBackoff = 60000;
+static const qint64 maximumBackoff = 30 * 60000;
+static const int maximumCrashes = 3;
+
+// Instances start at low CPU and I/O priority, see ioprio_set(2)
+static const int backgroundNice = 10;
+static const int ioprioWhoProcess = 1;
+static const int ioprioClassShift = 13;
+static const int ioprioClassBestEffort = 2;
+static const int ioprioClassIdle = 3;
+
+// Frecency score half-life in days
+static const qreal halfLife = 7.0;
+
+static qint64 residentSetSize(qint64 pid)
+{
+    QFile file(QStringLiteral("/proc/%1/statm").arg(pid));
+    if (!file.open(QFile::ReadOnly))
+        return 0;
+
+    const QList<QByteArray> fields = file.readAll().split(' ');
+    if (fields.size() < 2)
+        return 0;
+
+    return fields.at(1).toLongLong() * ::sysconf(_SC_PAGESIZE);
+}
+
+static QStringList serviceExec(const QString &serviceName)
+{
+    // Start instances the way the bus would activate them, so that
+    // each toolkit gets its own flags to run without windows
+    const QString fileName =
+            QStandardPaths::locate(QStandardPaths::GenericDataLocation,
+                                   QStringLiteral("dbus-1/services/%1.service").arg(serviceName));
+    QFile file(fileName);
+    if (fileName.isEmpty() || !file.open(QFile::ReadOnly | QFile::Text))
+        return QStringList();
+
+    QString exec;
+    while (!file.atEnd()) {
+        const QString line = QString::fromUtf8(file.readLine()).trimmed();
+        if (line.startsWith(QStringLiteral("Exec="))) {
+            exec = line.mid(5);
+            break;
+        }
+    }
+
+    // Split arguments honoring double quotes
+    QStringList args;
+    QString arg;
+    bool quoted = false, pending = false;
+    Q_FOREACH (const QChar &c, exec) {
+        if (c == QLatin1Char('"')) {
+            quoted = !quoted;
+            pending = true;
+        } else if (c.isSpace() && !quoted) {
+            if (pending)
+                args.append(arg);
+            arg.clear();
+            pending = false;
+        } else {
+            arg.append(c);
+            pending = true;
+        }
+    }
+    if (pending)
+        args.append(arg);
+    return args;
+}
+
+static void restorePriority(qint64 pid)
+{
+    // Nice values are per thread, unprivileged users might not be
+    // allowed to lower them but can always restore I/O priority
+    const QStringList tids = QDir(QStringLiteral("/proc/%1/task").arg(pid)).entryList(QDir::Dirs | QDir::NoDotAndDotDot);
+    Q_FOREACH (const QString &tid, tids) {
+        if (::setpriority(PRIO_PROCESS, tid.toInt(), 0) != 0)
+            qCDebug(PRELAUNCH, "Unable to restore priority of thread %s: %s",
+                    qPrintable(tid), strerror(errno));
+    }
+    ::syscall(SYS_ioprio_set, ioprioWhoProcess, int(pid),
+              (ioprioClassBestEffort << ioprioClassShift) | 4);
+}
+
+/*
+ * PrelaunchProcess
+ */
+
+class PrelaunchProcess : public QProcess
+{
+public:
+    PrelaunchProcess(QObject *parent)
+        : QProcess(parent)
+    {
+    }
+
+protected:
+    void setupChildProcess()
+    {
+        // Runs in the child, don't compete with the session
+        ::setpriority(PRIO_PROCESS, 0, backgroundNice);
+        ::syscall(SYS_ioprio_set, ioprioWhoProcess, 0, ioprioClassIdle << ioprioClassShift);
+    }
+};
+
+/*
+ * PrelaunchPool
+ */
+
+PrelaunchPool::PrelaunchPool(ProcessLauncher *launcher)
+    : QObject(launcher)
+    , m_launcher(launcher)
+    , m_settings(Q_NULLPTR)
+    , m_started(false)
+    , m_listingServices(false)
+{
+    // Settings, prelaunch is disabled when the schema is not installed
+    if (Hawaii::QGSettings::isSchemaInstalled(QStringLiteral("org.hawaiios.shell.prelaunch"))) {
+        m_settings = new Hawaii::QGSettings(QStringLiteral("org.hawaiios.shell.prelaunch"),
+                                            QStringLiteral("/org/hawaiios/shell/prelaunch/"),
+                                            this);
+        connect(m_settings, SIGNAL(settingChanged(QString)),
+                this, SLOT(settingChanged(QString)));
+    } else {
+        qCWarning(PRELAUNCH) << "Settings schema not installed, prelaunch disabled";
+    }
+
+    // Instances are ready as soon as they own their bus name
+    m_watcher = new QDBusServiceWatcher(this);
+    m_watcher->setConnection(QDBusConnection::sessionBus());
+    m_watcher->setWatchMode(QDBusServiceWatcher::WatchForRegistration);
+    connect(m_watcher, &QDBusServiceWatcher::serviceRegistered,
+            this, &PrelaunchPool::serviceRegistered);
+
+    // Refill the pool in the background
+    m_refillTimer = new QTimer(this);
+    m_refillTimer->setSingleShot(true);
+    connect(m_refillTimer, &QTimer::timeout,
+            this, &PrelaunchPool::refill);
+
+    // Keep waiting instances from quitting
+    m_keepAliveTimer = new QTimer(this);
+    m_keepAliveTimer->setInterval(keepAliveInterval);
+    connect(m_keepAliveTimer, &QTimer::timeout,
+            this, &PrelaunchPool::keepAlive);
+
+    loadFrecency();
+}
+
+PrelaunchPool::~PrelaunchPool()
+{
+    stop();
+}
+
+bool PrelaunchPool::isEnabled() const
+{
+    if (!m_settings)
+        return false;
+    return m_settings->value(QStringLiteral("enabled")).toBool();
+}
+
+void PrelaunchPool::start()
+{
+    m_started = true;
+
+    if (isEnabled()) {
+        scheduleRefill(startupDelay);
+        m_keepAliveTimer->start();
+    }
+}
+
+void PrelaunchPool::stop()
+{
+    m_refillTimer->stop();
+    m_keepAliveTimer->stop();
+
+    Q_FOREACH (Instance *instance, m_instances.values())
+        removeInstance(instance, true);
+}
+
+void PrelaunchPool::recordLaunch(const QString &fileName)
+{
+    const qreal newScore = score(fileName) + 1;
+
+    Frecency &frecency = m_frecency[fileName];
+    frecency.score = newScore;
+    frecency.lastLaunch = QDateTime::currentDateTimeUtc();
+    saveFrecency();
+
+    // The top frecency applications might have changed
+    if (m_started && isEnabled())
+        scheduleRefill(refillDelay);
+}
+
+bool PrelaunchPool::activate(const XdgDesktopFile &entry)
+{
+    Instance *instance = m_instances.value(entry.fileName());
+    if (!instance || !instance->ready)
+        return false;
+
+    // Launched again before the application showed up
+    if (instance->activating)
+        return true;
+
+    qCInfo(PRELAUNCH) << "Handing over prelaunched instance of" << entry.fileName()
+                      << "with pid" << instance->process->processId();
+
+    // The application is going to show a window, it needs all
+    // the resources it can get
+    instance->activating = true;
+    restorePriority(instance->process->processId());
+
+    // Ask the application to show itself, the process is handed
+    // over only when we know it did
+    QDBusMessage msg = QDBusMessage::createMethodCall(
+                instance->serviceName, objectPath(instance->serviceName),
+                QStringLiteral("org.freedesktop.Application"),
+                QStringLiteral("Activate"));
+    msg << QVariantMap();
+    QDBusPendingCallWatcher *watcher =
+            new QDBusPendingCallWatcher(QDBusConnection::sessionBus().asyncCall(msg), this);
+    const QString fileName = entry.fileName();
+    QProcess *process = instance->process;
+    connect(watcher, &QDBusPendingCallWatcher::finished, this, [this, fileName, process](QDBusPendingCallWatcher *self) {
+        QDBusPendingReply<> reply = *self;
+        self->deleteLater();
+
+        // The pool might have been stopped in the meantime
+        Instance *instance = m_instances.value(fileName);
+        if (!instance || instance->process != process) {
+            if (reply.isError())
+                m_launcher->launchDesktopFile(fileName);
+            return;
+        }
+
+        if (reply.isError()) {
+            qCWarning(PRELAUNCH, "Failed to activate \"%s\": %s",
+                      qPrintable(fileName), qPrintable(reply.error().message()));
+            backOff(fileName, true);
+
+            // Fall back to a regular launch once the instance is gone,
+            // it still owns the bus name until then
+            if (process->state() != QProcess::NotRunning) {
+                connect(process, static_cast<void (QProcess::*)(int, QProcess::ExitStatus)>(&QProcess::finished),
+                        m_launcher, [this, fileName] {
+                    m_launcher->launchDesktopFile(fileName);
+                });
+                removeInstance(instance, true);
+            } else {
+                removeInstance(instance, false);
+                m_launcher->launchDesktopFile(fileName);
+            }
+            return;
+        }
+
+        // From now on the process is just like any other application,
+        // unless it handed the request over to another instance
+        instance->process = Q_NULLPTR;
+        disconnect(process, Q_NULLPTR, this, Q_NULLPTR);
+        removeInstance(instance, false);
+        m_backoff.remove(fileName);
+        if (process->state() != QProcess::NotRunning)
+            m_launcher->adoptProcess(fileName, process);
+        else
+            process->deleteLater();
+
+        // Another instance will be started when this one quits
+        scheduleRefill(refillDelay);
+    });
+
+    return true;
+}
+
+qreal PrelaunchPool::score(const QString &fileName) const
+{
+    if (!m_frecency.contains(fileName))
+        return 0;
+
+    // Exponential decay of the score since the last launch
+    const Frecency &frecency = m_frecency[fileName];
+    const qreal days = frecency.lastLaunch.secsTo(QDateTime::currentDateTimeUtc()) / 86400.0;
+    return frecency.score * qPow(0.5, days / halfLife);
+}
+
+QStringList PrelaunchPool::candidates() const
+{
+    QStringList result;
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+
+    // Only D-Bus activatable applications can be started without
+    // windows and later activated, other applications are ignored
+    auto isSuitable = [this, &result, now](const QString &fileName) {
+        if (fileName.isEmpty() || result.contains(fileName) || m_excluded.contains(fileName))
+            return false;
+        if (m_backoff.value(fileName).retryAt > now)
+            return false;
+        XdgDesktopFile *entry = XdgDesktopFileCache::getFile(fileName);
+        return entry && entry->value(QStringLiteral("DBusActivatable")).toBool();
+    };
+
+    // Explicitly configured applications come first
+    const QStringList appIds = m_settings->value(QStringLiteral("applications")).toStringList();
+    Q_FOREACH (const QString &appId, appIds) {
+        const QString fileName =
+                QStandardPaths::locate(QStandardPaths::ApplicationsLocation,
+                                       appId + QStringLiteral(".desktop"));
+        if (isSuitable(fileName))
+            result.append(fileName);
+    }
+
+    // Then the most frecent applications
+    QList<QPair<qreal, QString> > ranking;
+    for (auto it = m_frecency.constBegin(); it != m_frecency.constEnd(); ++it)
+        ranking.append(qMakePair(score(it.key()), it.key()));
+    std::sort(ranking.begin(), ranking.end(), [](const QPair<qreal, QString> &a, const QPair<qreal, QString> &b) {
+        return a.first > b.first;
+    });
+
+    int count = m_settings->value(QStringLiteral("frecentApplications")).toInt();
+    for (int i = 0; i < ranking.size() && count > 0; i++) {
+        if (isSuitable(ranking.at(i).second)) {
+            result.append(ranking.at(i).second);
+            count--;
+        }
+    }
+
+    return result;
+}
+
+qint64 PrelaunchPool::memoryUsage() const
+{
+    qint64 size = 0;
+    Q_FOREACH (Instance *instance, m_instances) {
+        if (instance->process)
+            size += residentSetSize(instance->process->processId());
+    }
+    return size;
+}
+
+void PrelaunchPool::scheduleRefill(int delay)
+{
+    if (!m_refillTimer->isActive())
+        m_refillTimer->start(delay);
+}
+
+bool PrelaunchPool::startInstance(const QString &fileName)
+{
+    XdgDesktopFile *entry = XdgDesktopFileCache::getFile(fileName);
+    if (!entry)
+        return false;
+
+    // Without a service file we don't know how to start the
+    // application so that it waits for activation
+    QStringList args = serviceExec(serviceName(fileName));
+    if (args.isEmpty()) {
+        qCDebug(PRELAUNCH, "No D-Bus service for \"%s\"", qPrintable(fileName));
+        m_excluded.insert(fileName);
+        return false;
+    }
+
+    Instance *instance = new Instance();
+    instance->fileName = fileName;
+    instance->serviceName = serviceName(fileName);
+
+    // The process registers its bus name and waits for an
+    // Activate call without showing any window
+    QProcess *process = new PrelaunchProcess(this);
+    process->setProgram(args.takeAt(0));
+    process->setArguments(args);
+    process->setProcessEnvironment(m_launcher->processEnvironment());
+    process->setProcessChannelMode(QProcess::ForwardedChannels);
+    connect(process, SIGNAL(started()), this, SLOT(instanceStarted()));
+    connect(process, SIGNAL(errorOccurred(QProcess::ProcessError)),
+            this, SLOT(instanceError(QProcess::ProcessError)));
+    connect(process, SIGNAL(finished(int,QProcess::ExitStatus)),
+            this, SLOT(instanceFinished(int,QProcess::ExitStatus)));
+    instance->process = process;
+
+    m_instances.insert(fileName, instance);
+    m_watcher->addWatchedService(instance->serviceName);
+
+    process->start();
+
+    // Give up on applications that never register their bus name
+    QTimer::singleShot(readyTimeout, this, [this, fileName, process] {
+        Instance *instance = m_instances.value(fileName);
+        if (!instance || instance->process != process || instance->ready)
+            return;
+
+        qCWarning(PRELAUNCH, "Prelaunched \"%s\" didn't register on the bus",
+                  qPrintable(fileName));
+        backOff(fileName, true);
+        removeInstance(instance, true);
+        scheduleRefill(refillDelay);
+    });
+
+    return true;
+}
+
+void PrelaunchPool::removeInstance(Instance *instance, bool terminate)
+{
+    m_instances.remove(instance->fileName);
+    m_watcher->removeWatchedService(instance->serviceName);
+
+    if (instance->process) {
+        QProcess *process = instance->process;
+        disconnect(process, Q_NULLPTR, this, Q_NULLPTR);
+        if (terminate && process->state() != QProcess::NotRunning) {
+            // Don't block waiting, kill it if it doesn't quit in time
+            connect(process, SIGNAL(finished(int)), process, SLOT(deleteLater()));
+            QTimer::singleShot(killTimeout, process, [process] {
+                process->kill();
+            });
+            process->terminate();
+        } else {
+            process->deleteLater();
+        }
+    }
+
+    delete instance;
+}
+
+void PrelaunchPool::backOff(const QString &fileName, bool crashed)
+{
+    Backoff &backoff = m_backoff[fileName];
+    if (crashed && ++backoff.crashes >= maximumCrashes) {
+        qCWarning(PRELAUNCH) << "Prelaunched instance of" << fileName
+                             << "failed" << backoff.crashes << "times, giving up";
+        m_excluded.insert(fileName);
+        m_backoff.remove(fileName);
+        return;
+    }
+
+    const qint64 delay = qMin(initialBackoff << qMin(backoff.failures, 16), maximumBackoff);
+    backoff.failures++;
+    backoff.retryAt = QDateTime::currentMSecsSinceEpoch() + delay;
+    qCDebug(PRELAUNCH) << "Prelaunching" << fileName << "again in" << delay / 1000 << "seconds";
+}
+
+void PrelaunchPool::trim()
+{
+    if (!m_settings)
+        return;
+
+    const qint64 budget = m_settings->value(QStringLiteral("memoryBudget")).toLongLong() * 1024 * 1024;
+
+    while (!m_instances.isEmpty() && memoryUsage() > budget) {
+        // Evict the least frecent instance
+        Instance *victim = Q_NULLPTR;
+        Q_FOREACH (Instance *instance, m_instances) {
+            if (instance->activating)
+                continue;
+            if (!victim || score(instance->fileName) < score(victim->fileName))
+                victim = instance;
+        }
+        if (!victim)
+            break;
+
+        qCInfo(PRELAUNCH) << "Memory budget exceeded, evicting" << victim->fileName;
+        backOff(victim->fileName, false);
+        removeInstance(victim, true);
+    }
+}
+
+void PrelaunchPool::loadFrecency()
+{
+    const QString fileName = QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation) +
+            QStringLiteral("/hawaii/prelaunch.ini");
+    QSettings settings(fileName, QSettings::IniFormat);
+
+    int size = settings.beginReadArray(QStringLiteral("Frecency"));
+    for (int i = 0; i < size; i++) {
+        settings.setArrayIndex(i);
+
+        Frecency frecency;
+        frecency.score = settings.value(QStringLiteral("Score")).toReal();
+        frecency.lastLaunch = settings.value(QStringLiteral("LastLaunch")).toDateTime();
+        m_frecency.insert(settings.value(QStringLiteral("FileName")).toString(), frecency);
+    }
+    settings.endArray();
+}
+
+void PrelaunchPool::saveFrecency()
+{
+    const QString fileName = QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation) +
+            QStringLiteral("/hawaii/prelaunch.ini");
+    QSettings settings(fileName, QSettings::IniFormat);
+
+    settings.beginWriteArray(QStringLiteral("Frecency"), m_frecency.size());
+    int i = 0;
+    for (auto it = m_frecency.constBegin(); it != m_frecency.constEnd(); ++it) {
+        settings.setArrayIndex(i++);
+        settings.setValue(QStringLiteral("FileName"), it.key());
+        settings.setValue(QStringLiteral("Score"), it.value().score);
+        settings.setValue(QStringLiteral("LastLaunch"), it.value().lastLaunch);
+    }
+    settings.endArray();
+}
+
+QString PrelaunchPool::serviceName(const QString &fileName)
+{
+    // D-Bus activatable applications own a bus name equal to
+    // the desktop entry name without the extension
+    return QFileInfo(fileName).completeBaseName();
+}
+
+QString PrelaunchPool::objectPath(const QString &serviceName)
+{
+    QString path = serviceName;
+    path.replace(QLatin1Char('.'), QLatin1Char('/'));
+    path.replace(QLatin1Char('-'), QLatin1Char('_'));
+    return QLatin1Char('/') + path;
+}
+
+void PrelaunchPool::settingChanged(const QString &key)
+{
+    if (!m_started)
+        return;
+
+    if (!isEnabled()) {
+        stop();
+        return;
+    }
+
+    // Budget or candidates might have changed
+    if (key != QStringLiteral("enabled"))
+        trim();
+    scheduleRefill(refillDelay);
+    if (!m_keepAliveTimer->isActive())
+        m_keepAliveTimer->start();
+}
+
+void PrelaunchPool::refill()
+{
+    if (!isEnabled() || m_listingServices)
+        return;
+
+    // Start one instance at a time, the next one is scheduled
+    // as soon as the current one is ready
+    Q_FOREACH (Instance *instance, m_instances) {
+        if (!instance->ready)
+            return;
+    }
+
+    const qint64 budget = m_settings->value(QStringLiteral("memoryBudget")).toLongLong() * 1024 * 1024;
+    if (memoryUsage() >= budget) {
+        qCDebug(PRELAUNCH) << "Memory budget reached, not prelaunching any other application";
+        return;
+    }
+
+    // Applications that are already running don't need to be warmed
+    // up, don't block the compositor while asking the bus about them
+    m_listingServices = true;
+    QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(
+                QDBusConnection::sessionBus().interface()->asyncCall(QStringLiteral("ListNames")), this);
+    connect(watcher, &QDBusPendingCallWatcher::finished, this, [this](QDBusPendingCallWatcher *self) {
+        QDBusPendingReply<QStringList> reply = *self;
+        self->deleteLater();
+        m_listingServices = false;
+
+        if (reply.isError()) {
+            qCWarning(PRELAUNCH) << "Unable to list bus names:" << reply.error().message();
+            return;
+        }
+
+        refillWith(reply.value());
+    });
+}
+
+void PrelaunchPool::refillWith(const QStringList &runningServices)
+{
+    // Things might have changed while waiting for the bus
+    if (!isEnabled())
+        return;
+    Q_FOREACH (Instance *instance, m_instances) {
+        if (!instance->ready)
+            return;
+    }
+
+    Q_FOREACH (const QString &fileName, candidates()) {
+        if (m_instances.contains(fileName) || runningServices.contains(serviceName(fileName)))
+            continue;
+
+        if (startInstance(fileName))
+            return;
+    }
+
+    // Come back for applications that are backing off
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    qint64 retryAt = 0;
+    Q_FOREACH (const Backoff &backoff, m_backoff) {
+        if (backoff.retryAt > now && (retryAt == 0 || backoff.retryAt < retryAt))
+            retryAt = backoff.retryAt;
+    }
+    if (retryAt > 0)
+        scheduleRefill(qMax<qint64>(refillDelay, retryAt - now));
+}
+
+void PrelaunchPool::keepAlive()
+{
+    // Any method handled by the application counts as activity,
+    // describing actions is cheap and has no side effects
+    Q_FOREACH (Instance *instance, m_instances) {
+        if (!instance->ready || instance->activating)
+            continue;
+
+        QDBusMessage msg = QDBusMessage::createMethodCall(
+                    instance->serviceName, objectPath(instance->serviceName),
+                    QStringLiteral("org.gtk.Actions"),
+                    QStringLiteral("DescribeAll"));
+        QDBusConnection::sessionBus().send(msg);
+    }
+}
+
+void PrelaunchPool::serviceRegistered(const QString &serviceName)
+{
+    Q_FOREACH (Instance *instance, m_instances) {
+        if (instance->serviceName != serviceName)
+            continue;
+
+        qCInfo(PRELAUNCH) << "Prelaunched instance of" << instance->fileName << "is ready";
+        instance->ready = true;
+        break;
+    }
+
+    trim();
+    scheduleRefill(refillDelay);
+}
+
+void PrelaunchPool::instanceStarted()
+{
+    QProcess *process = qobject_cast<QProcess *>(sender());
+    if (!process)
+        return;
+
+    Q_FOREACH (Instance *instance, m_instances) {
+        if (instance->process == process) {
+            qCDebug(PRELAUNCH, "Prelaunched \"%s\" with pid %lld",
+                    qPrintable(instance->fileName), process->processId());
+            break;
+        }
+    }
+}
+
+void PrelaunchPool::instanceError(QProcess::ProcessError error)
+{
+    QProcess *process = qobject_cast<QProcess *>(sender());
+    if (!process || error != QProcess::FailedToStart)
+        return;
+
+    Q_FOREACH (Instance *instance, m_instances) {
+        if (instance->process != process)
+            continue;
+
+        qCWarning(PRELAUNCH, "Failed to prelaunch \"%s\"", qPrintable(instance->fileName));
+        m_excluded.insert(instance->fileName);
+        removeInstance(instance, false);
+        break;
+    }
+
+    scheduleRefill(refillDelay);
+}
+
+void PrelaunchPool::instanceFinished(int exitCode, QProcess::ExitStatus exitStatus)
+{
+    QProcess *process = qobject_cast<QProcess *>(sender());
+    if (!process)
+        return;
+
+    Q_FOREACH (Instance *instance, m_instances) {
+        if (instance->process != process)
+            continue;
+
+        // Being activated, the reply tells what to do
+        if (instance->activating)
+            return;
+
+        // Services quitting cleanly went idle, anything else
+        // failed; either way wait before starting them again
+        // otherwise they would keep restarting
+        const bool crashed = exitStatus != QProcess::NormalExit || exitCode != 0 || !instance->ready;
+        if (crashed)
+            qCWarning(PRELAUNCH) << "Prelaunched instance of" << instance->fileName
+                                 << "failed with exit code" << exitCode;
+        else
+            qCInfo(PRELAUNCH) << "Prelaunched instance of" << instance->fileName << "quit while idle";
+        backOff(instance->fileName, crashed);
+        removeInstance(instance, false);
+        break;
+    }
+
+    scheduleRefill(refillDelay);
+}
+
+#include "moc_prelaunchpool.cpp"
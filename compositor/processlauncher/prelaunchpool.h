@@ -0,0 +1,146 @@
+/****************************************************************************
+ * This file is part of Hawaii.
+ *
+ * Copyright (C) 2016 Pier Luigi Fiorini
+ *
+ * Author(s):
+ *    Pier Luigi Fiorini <pierluigi.fiorini@gmail.com>
+ *
+ * $BEGIN_LICENSE:GPL2+$
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * $END_LICENSE$
+ ***************************************************************************/
+
+#ifndef PRELAUNCHPOOL_H
+#define PRELAUNCHPOOL_H
+
+#include <QtCore/QDateTime>
+#include <QtCore/QHash>
+#include <QtCore/QLoggingCategory>
+#include <QtCore/QObject>
+#include <QtCore/QProcess>
+#include <QtCore/QSet>
+
+#include <Hawaii/GSettings/QGSettings>
+
+Q_DECLARE_LOGGING_CATEGORY(PRELAUNCH)
+
+class QDBusServiceWatcher;
+class QTimer;
+class XdgDesktopFile;
+
+class ProcessLauncher;
+
+class PrelaunchPool : public QObject
+{
+    Q_OBJECT
+public:
+    PrelaunchPool(ProcessLauncher *launcher);
+    ~PrelaunchPool();
+
+    bool isEnabled() const;
+
+    void start();
+    void stop();
+
+    void recordLaunch(const QString &fileName);
+    bool activate(const XdgDesktopFile &entry);
+
+private:
+    class Instance
+    {
+    public:
+        Instance()
+            : process(Q_NULLPTR)
+            , ready(false)
+            , activating(false)
+        {
+        }
+
+        QString fileName;
+        QString serviceName;
+        QProcess *process;
+        bool ready;
+        bool activating;
+    };
+
+    class Backoff
+    {
+    public:
+        Backoff()
+            : failures(0)
+            , crashes(0)
+            , retryAt(0)
+        {
+        }
+
+        int failures;
+        int crashes;
+        qint64 retryAt;
+    };
+
+    class Frecency
+    {
+    public:
+        Frecency()
+            : score(0)
+        {
+        }
+
+        qreal score;
+        QDateTime lastLaunch;
+    };
+
+    ProcessLauncher *m_launcher;
+    Hawaii::QGSettings *m_settings;
+    QDBusServiceWatcher *m_watcher;
+    QTimer *m_refillTimer;
+    QTimer *m_keepAliveTimer;
+    QHash<QString, Instance *> m_instances;
+    QHash<QString, Frecency> m_frecency;
+    QHash<QString, Backoff> m_backoff;
+    QSet<QString> m_excluded;
+    bool m_started;
+    bool m_listingServices;
+
+    qreal score(const QString &fileName) const;
+    QStringList candidates() const;
+    qint64 memoryUsage() const;
+
+    void scheduleRefill(int delay);
+    bool startInstance(const QString &fileName);
+    void removeInstance(Instance *instance, bool terminate);
+    void backOff(const QString &fileName, bool crashed);
+    void trim();
+
+    void loadFrecency();
+    void saveFrecency();
+
+    static QString serviceName(const QString &fileName);
+    static QString objectPath(const QString &serviceName);
+
+private Q_SLOTS:
+    void settingChanged(const QString &key);
+    void refill();
+    void refillWith(const QStringList &runningServices);
+    void keepAlive();
+    void serviceRegistered(const QString &serviceName);
+    void instanceStarted();
+    void instanceError(QProcess::ProcessError error);
+    void instanceFinished(int exitCode, QProcess::ExitStatus exitStatus);
+};
+
+#endif // PRELAUNCHPOOL_H
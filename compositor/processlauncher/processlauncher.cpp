@@ -31,6 +31,7 @@
 
 #include <qt5xdg/xdgdesktopfile.h>
 
+#include "prelaunchpool.h"
 #include "processlauncher.h"
 #include "processlauncheradaptor.h"
 
@@ -38,6 +39,7 @@ Q_LOGGING_CATEGORY(LAUNCHER, "hawaii.launcher")
 
 ProcessLauncher::ProcessLauncher(QObject *parent)
     : QObject(parent)
+    , m_prelaunch(new PrelaunchPool(this))
 {
 }
 
@@ -64,6 +66,9 @@ void ProcessLauncher::closeApplications()
 {
     qCDebug(LAUNCHER) << "Terminate applications";
 
+    // Terminate prelaunched applications that were not handed over
+    m_prelaunch->stop();
+
     // Terminate all process launched by us
     ApplicationMapIterator i(m_apps);
     while (i.hasNext()) {
@@ -83,6 +88,11 @@ void ProcessLauncher::closeApplications()
     }
 }
 
+void ProcessLauncher::startPrelaunch()
+{
+    m_prelaunch->start();
+}
+
 bool ProcessLauncher::registerWithDBus(ProcessLauncher *instance)
 {
     QDBusConnection bus = QDBusConnection::sessionBus();
@@ -119,6 +129,8 @@ bool ProcessLauncher::launchApplication(const QString &appId)
         return false;
     }
 
+    m_prelaunch->recordLaunch(fileName);
+
     return launchEntry(*entry);
 }
 
@@ -135,6 +147,8 @@ bool ProcessLauncher::launchDesktopFile(const QString &fileName)
         return false;
     }
 
+    m_prelaunch->recordLaunch(fileName);
+
     return launchEntry(*entry);
 }
 
@@ -147,15 +161,8 @@ bool ProcessLauncher::launchCommand(const QString &command)
 
     qCInfo(LAUNCHER) << "Launching command" << command;
 
-    QProcessEnvironment env = QProcessEnvironment::systemEnvironment();
-    if (!m_waylandSocketName.isEmpty())
-        env.insert(QStringLiteral("WAYLAND_DISPLAY"), m_waylandSocketName);
-    env.insert(QStringLiteral("SAL_USE_VCLPLUGIN"), QStringLiteral("kde"));
-    env.insert(QStringLiteral("QT_PLATFORM_PLUGIN"), QStringLiteral("Hawaii"));
-    env.remove(QStringLiteral("QSG_RENDER_LOOP"));
-
     QProcess *process = new QProcess(this);
-    process->setProcessEnvironment(env);
+    process->setProcessEnvironment(processEnvironment());
     process->setProcessChannelMode(QProcess::ForwardedChannels);
     connect(process, SIGNAL(finished(int)), this, SLOT(finished(int)));
     process->start(command);
@@ -182,22 +189,19 @@ bool ProcessLauncher::closeDesktopFile(const QString &fileName)
 
 bool ProcessLauncher::launchEntry(const XdgDesktopFile &entry)
 {
+    // Hand over a prelaunched instance if available
+    if (m_prelaunch->activate(entry))
+        return true;
+
     QStringList args = entry.expandExecString();
     QString command = args.takeAt(0);
 
     qCDebug(LAUNCHER) << "Launching" << entry.expandExecString().join(" ") << "from" << entry.fileName();
 
-    QProcessEnvironment env = QProcessEnvironment::systemEnvironment();
-    if (!m_waylandSocketName.isEmpty())
-        env.insert(QStringLiteral("WAYLAND_DISPLAY"), m_waylandSocketName);
-    env.insert(QStringLiteral("SAL_USE_VCLPLUGIN"), QStringLiteral("kde"));
-    env.insert(QStringLiteral("QT_PLATFORM_PLUGIN"), QStringLiteral("Hawaii"));
-    env.remove(QStringLiteral("QSG_RENDER_LOOP"));
-
     QProcess *process = new QProcess(this);
     process->setProgram(command);
     process->setArguments(args);
-    process->setProcessEnvironment(env);
+    process->setProcessEnvironment(processEnvironment());
     process->setProcessChannelMode(QProcess::ForwardedChannels);
     m_apps[entry.fileName()] = process;
     connect(process, SIGNAL(finished(int)), this, SLOT(finished(int)));
@@ -219,6 +223,24 @@ bool ProcessLauncher::launchEntry(const XdgDesktopFile &entry)
     return true;
 }
 
+QProcessEnvironment ProcessLauncher::processEnvironment() const
+{
+    QProcessEnvironment env = QProcessEnvironment::systemEnvironment();
+    if (!m_waylandSocketName.isEmpty())
+        env.insert(QStringLiteral("WAYLAND_DISPLAY"), m_waylandSocketName);
+    env.insert(QStringLiteral("SAL_USE_VCLPLUGIN"), QStringLiteral("kde"));
+    env.insert(QStringLiteral("QT_PLATFORM_PLUGIN"), QStringLiteral("Hawaii"));
+    env.remove(QStringLiteral("QSG_RENDER_LOOP"));
+    return env;
+}
+
+void ProcessLauncher::adoptProcess(const QString &fileName, QProcess *process)
+{
+    process->setParent(this);
+    m_apps[fileName] = process;
+    connect(process, SIGNAL(finished(int)), this, SLOT(finished(int)));
+}
+
 bool ProcessLauncher::closeEntry(const QString &fileName)
 {
     if (!m_apps.contains(fileName))
@@ -30,12 +30,15 @@
 #include <QtCore/QLoggingCategory>
 #include <QtCore/QMap>
 #include <QtCore/QObject>
+#include <QtCore/QProcessEnvironment>
 
 Q_DECLARE_LOGGING_CATEGORY(LAUNCHER)
 
 class QProcess;
 class XdgDesktopFile;
 
+class PrelaunchPool;
+
 typedef QMap<QString, QProcess *> ApplicationMap;
 typedef QMutableMapIterator<QString, QProcess *> ApplicationMapIterator;
 
@@ -59,6 +62,8 @@ public:
     Q_INVOKABLE bool closeDesktopFile(const QString &fileName);
     void closeApplications();
 
+    void startPrelaunch();
+
     static bool registerWithDBus(ProcessLauncher *instance);
 
 Q_SIGNALS:
@@ -67,9 +72,14 @@ Q_SIGNALS:
 private:
     QString m_waylandSocketName;
     ApplicationMap m_apps;
+    PrelaunchPool *m_prelaunch;
 
+    QProcessEnvironment processEnvironment() const;
+    void adoptProcess(const QString &fileName, QProcess *process);
     bool closeEntry(const QString &fileName);
 
+    friend class PrelaunchPool;
+
 private Q_SLOTS:
     void finished(int exitCode);
 };
@@ -25,14 +25,23 @@
  ***************************************************************************/
 
 #include "authenticator.h"
+#include "config.h"
 
 #include <security/pam_appl.h>
+#include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 #include <pwd.h>
 
+Q_LOGGING_CATEGORY(AUTHENTICATOR, "hawaii.session.authenticator")
+
 Authenticator::Authenticator(QObject *parent)
     : QObject(parent)
-    , m_response(Q_NULLPTR)
+    , m_enabled(false)
+    , m_queued(false)
+    , m_running(false)
+    , m_cancelled(false)
+    , m_answered(false)
 {
 }
 
@@ -40,58 +49,210 @@ Authenticator::~Authenticator()
 {
 }
 
-void Authenticator::authenticate(const QString &password)
+void Authenticator::start()
+{
+    QMutexLocker locker(&m_mutex);
+
+    if (m_running || m_queued)
+        return;
+
+    m_queued = true;
+    QMetaObject::invokeMethod(this, "run", Qt::QueuedConnection);
+}
+
+void Authenticator::respond(const QString &response)
+{
+    QMutexLocker locker(&m_mutex);
+
+    // Repeated presses before a prompt is answered would otherwise
+    // feed stale answers to the following prompts
+    m_responses.clear();
+    m_responses.enqueue(response);
+    m_latency.start();
+    m_condition.wakeAll();
+}
+
+void Authenticator::setEnabled(bool enabled)
+{
+    QMutexLocker locker(&m_mutex);
+
+    m_enabled = enabled;
+    if (!m_enabled) {
+        m_cancelled = true;
+        m_responses.clear();
+        m_condition.wakeAll();
+    }
+}
+
+void Authenticator::cancel()
+{
+    QMutexLocker locker(&m_mutex);
+
+    m_cancelled = true;
+    m_responses.clear();
+    m_condition.wakeAll();
+}
+
+bool Authenticator::waitForResponse(QString *response)
 {
+    QMutexLocker locker(&m_mutex);
+
+    // Block the authenticator thread until the user answers
+    while (m_responses.isEmpty() && !m_cancelled)
+        m_condition.wait(&m_mutex);
+
+    if (m_cancelled)
+        return false;
+
+    *response = m_responses.dequeue();
+    m_answered = true;
+    return true;
+}
+
+void Authenticator::run()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_queued = false;
+        m_running = true;
+        m_cancelled = false;
+        m_answered = false;
+        m_latency.invalidate();
+    }
+
     const pam_conv conversation = { conversationHandler, this };
     pam_handle_t *handle = Q_NULLPTR;
+    int retval = PAM_SUCCESS;
 
-    passwd *pwd = getpwuid(getuid());
-    if (!pwd) {
-        Q_EMIT authenticationError();
-        return;
+    passwd pwdBuffer;
+    passwd *pwd = Q_NULLPTR;
+    long bufferSize = sysconf(_SC_GETPW_R_SIZE_MAX);
+    QByteArray buffer(bufferSize > 0 ? bufferSize : 16384, 0);
+    if (getpwuid_r(getuid(), &pwdBuffer, buffer.data(), buffer.size(), &pwd) != 0 || !pwd) {
+        qCWarning(AUTHENTICATOR, "Unable to find the current user");
+        retval = PAM_USER_UNKNOWN;
+    } else {
+        retval = pam_start(HAWAII_PAM_SERVICE, pwd->pw_name, &conversation, &handle);
+        if (retval != PAM_SUCCESS) {
+            qCWarning(AUTHENTICATOR, "pam_start returned %d", retval);
+            handle = Q_NULLPTR;
+        }
     }
 
-    int retval = pam_start("su", pwd->pw_name, &conversation, &handle);
-    if (retval != PAM_SUCCESS) {
-        qWarning("pam_start returned %d", retval);
-        Q_EMIT authenticationError();
-        return;
+    if (handle) {
+        qCDebug(AUTHENTICATOR) << "Conversation started";
+
+        retval = pam_authenticate(handle, 0);
+        if (retval == PAM_SUCCESS) {
+            // Some modules need to refresh credentials, for example Kerberos
+            int credRetval = pam_setcred(handle, PAM_REFRESH_CRED);
+            if (credRetval != PAM_SUCCESS)
+                qCDebug(AUTHENTICATOR, "pam_setcred returned %d", credRetval);
+        }
+
+        int endRetval = pam_end(handle, retval);
+        if (endRetval != PAM_SUCCESS)
+            qCWarning(AUTHENTICATOR, "pam_end returned %d", endRetval);
+    }
+
+    // Failing without asking anything, for example when the service
+    // denies everyone or the account is locked, would fail again right
+    // away: wait for the user to try again instead
+    bool cancelled, restart;
+    qint64 latency = -1;
+    {
+        QMutexLocker locker(&m_mutex);
+        cancelled = m_cancelled;
+        restart = m_enabled && retval != PAM_SUCCESS && m_answered;
+        if (m_latency.isValid())
+            latency = m_latency.elapsed();
+        m_responses.clear();
+        m_running = false;
     }
 
-    m_response = new pam_response;
-    m_response[0].resp = strdup(qPrintable(password));
-    m_response[0].resp_retcode = 0;
+    if (cancelled) {
+        qCDebug(AUTHENTICATOR) << "Conversation cancelled";
+    } else {
+        if (latency >= 0)
+            qCInfo(AUTHENTICATOR) << "Authentication completed" << latency << "ms after the last answer";
 
-    retval = pam_authenticate(handle, 0);
-    if (retval != PAM_SUCCESS) {
-        if (retval == PAM_AUTH_ERR) {
+        if (retval == PAM_SUCCESS) {
+            Q_EMIT authenticationSucceded();
+        } else if (retval == PAM_AUTH_ERR || retval == PAM_MAXTRIES) {
             Q_EMIT authenticationFailed();
         } else {
-            qWarning("pam_authenticate returned %d", retval);
+            qCWarning(AUTHENTICATOR, "Authentication error %d", retval);
             Q_EMIT authenticationError();
+            Q_EMIT message(tr("Unable to authenticate, please contact your system administrator."), true);
         }
-
-        return;
     }
 
-    retval = pam_end(handle, retval);
-    if (retval != PAM_SUCCESS) {
-        qWarning("pam_end returned %d", retval);
-        Q_EMIT authenticationError();
-        return;
-    }
-
-    Q_EMIT authenticationSucceded();
+    // Get ready for the next attempt
+    if (restart)
+        start();
 }
 
 int Authenticator::conversationHandler(int num, const pam_message **message,
                                        pam_response **response, void *data)
 {
-    Q_UNUSED(num);
-    Q_UNUSED(message);
-
     Authenticator *self = static_cast<Authenticator *>(data);
-    *response = self->m_response;
+
+    if (num <= 0 || num > PAM_MAX_NUM_MSG)
+        return PAM_CONV_ERR;
+
+    // PAM takes ownership of replies only when we return success
+    pam_response *replies = static_cast<pam_response *>(calloc(num, sizeof(pam_response)));
+    if (!replies)
+        return PAM_BUF_ERR;
+
+    int retval = PAM_SUCCESS;
+
+    for (int i = 0; i < num && retval == PAM_SUCCESS; i++) {
+        const QString text = QString::fromLocal8Bit(message[i]->msg);
+
+        switch (message[i]->msg_style) {
+        case PAM_PROMPT_ECHO_OFF:
+        case PAM_PROMPT_ECHO_ON: {
+            Q_EMIT self->prompt(text, message[i]->msg_style == PAM_PROMPT_ECHO_OFF);
+
+            QString answer;
+            if (!self->waitForResponse(&answer)) {
+                retval = PAM_CONV_ERR;
+                break;
+            }
+
+            QByteArray encoded = answer.toLocal8Bit();
+            replies[i].resp = strdup(encoded.constData());
+            encoded.fill(0);
+            if (!replies[i].resp)
+                retval = PAM_BUF_ERR;
+            break;
+        }
+        case PAM_ERROR_MSG:
+            Q_EMIT self->message(text, true);
+            break;
+        case PAM_TEXT_INFO:
+            Q_EMIT self->message(text, false);
+            break;
+        default:
+            retval = PAM_CONV_ERR;
+            break;
+        }
+    }
+
+    if (retval != PAM_SUCCESS) {
+        for (int i = 0; i < num; i++) {
+            if (replies[i].resp) {
+                memset(replies[i].resp, 0, strlen(replies[i].resp));
+                free(replies[i].resp);
+            }
+        }
+        free(replies);
+        *response = Q_NULLPTR;
+        return retval;
+    }
+
+    *response = replies;
     return PAM_SUCCESS;
 }
 
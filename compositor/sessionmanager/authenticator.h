@@ -27,7 +27,14 @@
 #ifndef AUTHENTICATOR_H
 #define AUTHENTICATOR_H
 
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QLoggingCategory>
+#include <QtCore/QMutex>
 #include <QtCore/QObject>
+#include <QtCore/QQueue>
+#include <QtCore/QWaitCondition>
+
+Q_DECLARE_LOGGING_CATEGORY(AUTHENTICATOR)
 
 struct pam_message;
 struct pam_response;
@@ -39,19 +46,61 @@ public:
     Authenticator(QObject *parent = 0);
     ~Authenticator();
 
-public Q_SLOTS:
-    void authenticate(const QString &password);
+    /*!
+     * \brief Start a conversation.
+     *
+     * Starts the PAM conversation on the authenticator thread, unless
+     * it's already running, so that slow modules do their work before
+     * the user is done typing. Can be called from any thread.
+     */
+    void start();
+
+    /*!
+     * \brief Answer a prompt.
+     *
+     * Queues an answer for the current or next prompt, replacing
+     * an answer that is still pending. Can be called from any thread.
+     */
+    void respond(const QString &response);
+
+    /*!
+     * \brief Enable conversations.
+     *
+     * While enabled a new conversation is started after each failed
+     * attempt where the user answered a prompt, disabling cancels
+     * the current conversation.
+     * Can be called from any thread.
+     */
+    void setEnabled(bool enabled);
+
+    void cancel();
 
 Q_SIGNALS:
+    void prompt(const QString &message, bool secret);
+    void message(const QString &text, bool error);
+
     void authenticationSucceded();
     void authenticationFailed();
     void authenticationError();
 
 private:
-    pam_response *m_response;
+    QMutex m_mutex;
+    QWaitCondition m_condition;
+    QQueue<QString> m_responses;
+    bool m_enabled;
+    bool m_queued;
+    bool m_running;
+    bool m_cancelled;
+    bool m_answered;
+    QElapsedTimer m_latency;
+
+    bool waitForResponse(QString *response);
 
     static int conversationHandler(int num, const pam_message **message,
                                    pam_response **response, void *data);
+
+private Q_SLOTS:
+    void run();
 };
 
 #endif // AUTHENTICATOR_H
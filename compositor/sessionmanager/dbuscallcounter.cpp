@@ -0,0 +1,81 @@
+/****************************************************************************
+ * This file is part of Hawaii.
+ *
+ * Copyright (C) 2016 Pier Luigi Fiorini
+ *
+ * Author(s):
+ *    Pier Luigi Fiorini <pierluigi.fiorini@gmail.com>
+ *
+ * $BEGIN_LICENSE:GPL2+$
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * $END_LICENSE$
+ ***************************************************************************/
+
+#include <QtCore/QHash>
+#include <QtCore/QMutex>
+
+#include "dbuscallcounter.h"
+
+class DBusCallCounterPrivate
+{
+public:
+    QMutex mutex;
+    QHash<QString, QPair<quint64, quint64> > counters;
+};
+
+Q_GLOBAL_STATIC(DBusCallCounterPrivate, s_counters)
+
+void DBusCallCounter::record(const QString &subsystem, CallType type)
+{
+    QMutexLocker locker(&s_counters()->mutex);
+
+    QPair<quint64, quint64> &counter = s_counters()->counters[subsystem];
+    if (type == BlockingCall)
+        counter.second++;
+    else
+        counter.first++;
+}
+
+quint64 DBusCallCounter::count(const QString &subsystem, CallType type)
+{
+    QMutexLocker locker(&s_counters()->mutex);
+
+    const QPair<quint64, quint64> counter = s_counters()->counters.value(subsystem, qMakePair<quint64, quint64>(0, 0));
+    return type == BlockingCall ? counter.second : counter.first;
+}
+
+QVariantMap DBusCallCounter::counters()
+{
+    QMutexLocker locker(&s_counters()->mutex);
+
+    QVariantMap map;
+
+    QHash<QString, QPair<quint64, quint64> >::const_iterator it;
+    for (it = s_counters()->counters.constBegin(); it != s_counters()->counters.constEnd(); ++it) {
+        QVariantMap counter;
+        counter.insert(QStringLiteral("async"), it.value().first);
+        counter.insert(QStringLiteral("blocking"), it.value().second);
+        map.insert(it.key(), counter);
+    }
+
+    return map;
+}
+
+void DBusCallCounter::reset()
+{
+    QMutexLocker locker(&s_counters()->mutex);
+    s_counters()->counters.clear();
+}
@@ -0,0 +1,62 @@
+/****************************************************************************
+ * This file is part of Hawaii.
+ *
+ * Copyright (C) 2016 Pier Luigi Fiorini
+ *
+ * Author(s):
+ *    Pier Luigi Fiorini <pierluigi.fiorini@gmail.com>
+ *
+ * $BEGIN_LICENSE:GPL2+$
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * $END_LICENSE$
+ ***************************************************************************/
+
+#ifndef DBUSCALLCOUNTER_H
+#define DBUSCALLCOUNTER_H
+
+#include <QtCore/QString>
+#include <QtCore/QVariantMap>
+
+class DBusCallCounter
+{
+public:
+    enum CallType {
+        AsyncCall = 0,
+        BlockingCall
+    };
+
+    /*!
+     * \brief Record a D-Bus call.
+     *
+     * Subsystems record every call they make, so that it's easy
+     * to verify that hot paths don't block on D-Bus.
+     */
+    static void record(const QString &subsystem, CallType type = AsyncCall);
+
+    static quint64 count(const QString &subsystem, CallType type);
+
+    /*!
+     * \brief Counters.
+     *
+     * Returns a map from each subsystem name to a map with
+     * the number of "async" and "blocking" calls.
+     */
+    static QVariantMap counters();
+
+    static void reset();
+};
+
+#endif // DBUSCALLCOUNTER_H
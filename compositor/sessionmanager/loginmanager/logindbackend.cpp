@@ -24,16 +24,23 @@
  * $END_LICENSE$
  ***************************************************************************/
 
+#include <QtCore/QFile>
+#include <QtCore/QMetaMethod>
+#include <QtCore/QTimer>
 #include <QtDBus/QDBusInterface>
 #include <QtDBus/QDBusPendingCallWatcher>
 #include <QtDBus/QDBusPendingReply>
 #include <QtDBus/QDBusUnixFileDescriptor>
 
 #include "logindbackend.h"
-#include "logindsessioninfo.h"
+#include "orgfreedesktoplogin1Session.h"
+#include "qlogind/src/sessiontracker.h"
+#include "qlogind/src/types.h"
+#include "sessionmanager/dbuscallcounter.h"
 #include "sessionmanager/sessionmanager.h"
 
 #include <sys/stat.h>
+#include <sys/sysmacros.h>
 #include <unistd.h>
 
 Q_LOGGING_CATEGORY(LOGIND_BACKEND, "hawaii.loginmanager.logind")
@@ -42,12 +49,21 @@ const static QString login1Service = QStringLiteral("org.freedesktop.login1");
 const static QString login1Object = QStringLiteral("/org/freedesktop/login1");
 const static QString login1ManagerInterface = QStringLiteral("org.freedesktop.login1.Manager");
 const static QString login1SessionInterface = QStringLiteral("org.freedesktop.login1.Session");
-const static QString dbusPropertiesInterface = QStringLiteral("org.freedesktop.DBus.Properties");
+const static QString subsystem = QStringLiteral("logind");
 
 LogindBackend::LogindBackend()
     : LoginManagerBackend()
+    , m_session(Q_NULLPTR)
     , m_inhibitFd(-1)
+    , m_sessionTracker(Q_NULLPTR)
 {
+    // Devices are paused and resumed all at once on VT switch
+    // and resume, handle them in batches
+    m_deviceTimer = new QTimer(this);
+    m_deviceTimer->setSingleShot(true);
+    m_deviceTimer->setInterval(0);
+    connect(m_deviceTimer, &QTimer::timeout,
+            this, &LogindBackend::flushDevices);
 }
 
 LogindBackend::~LogindBackend()
@@ -64,10 +80,12 @@ LogindBackend *LogindBackend::create(SessionManager *sm, const QDBusConnection &
         return Q_NULLPTR;
     backend->m_sessionManager = sm;
 
-    // Connect to logind if available
+    // Connect to logind if available, this introspects the manager
+    // object but it's done only once at startup
     backend->m_interface = new QDBusInterface(login1Service, login1Object,
                                               login1ManagerInterface,
                                               connection);
+    DBusCallCounter::record(subsystem, DBusCallCounter::BlockingCall);
     if (!backend->m_interface || !backend->m_interface->isValid()) {
         delete backend;
         return Q_NULLPTR;
@@ -86,6 +104,7 @@ LogindBackend *LogindBackend::create(SessionManager *sm, const QDBusConnection &
                                                backend, SLOT(prepareForShutdown(bool)));
 
     // Get a hold of the session
+    DBusCallCounter::record(subsystem);
     QDBusPendingCall call = backend->m_interface->asyncCall(QStringLiteral("GetSessionByPID"),
                                                             (quint32)getpid());
     QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(call);
@@ -95,6 +114,20 @@ LogindBackend *LogindBackend::create(SessionManager *sm, const QDBusConnection &
     // Lock screen when preparing to sleep and logout before shutdown
     backend->setupInhibitors();
 
+    // Keep track of sessions so that switching VT doesn't
+    // have to query all of them every time
+    registerTypes();
+    backend->m_sessionTracker = new SessionTracker(backend, connection);
+    backend->connect(backend->m_sessionTracker, &SessionTracker::sessionAdded,
+                     backend, &LogindBackend::addSession);
+    backend->connect(backend->m_sessionTracker, &SessionTracker::sessionRemoved,
+                     backend, &LogindBackend::sessionRemoved);
+    PendingSessions *pendingSessions = backend->m_sessionTracker->listSessions();
+    backend->connect(pendingSessions, &PendingInterfaceInternal::finished, backend, [backend, pendingSessions] {
+        Q_FOREACH (const SessionPtr &session, pendingSessions->interfaces())
+            backend->addSession(session);
+    });
+
     return backend;
 }
 
@@ -105,22 +138,20 @@ QString LogindBackend::name() const
 
 void LogindBackend::setIdle(bool value)
 {
-    QDBusInterface iface(login1Service, m_sessionPath, login1SessionInterface,
-                         m_interface->connection());
-    iface.asyncCall(QStringLiteral("SetIdleHint"), value);
+    if (!m_session)
+        return;
+
+    DBusCallCounter::record(subsystem);
+    m_session->SetIdleHint(value);
 }
 
 void LogindBackend::takeControl()
 {
-    if (m_sessionPath.isEmpty() || m_sessionControl)
+    if (!m_session || m_sessionControl)
         return;
 
-    QDBusMessage msg = QDBusMessage::createMethodCall(login1Service, m_sessionPath,
-                                                      login1SessionInterface,
-                                                      QStringLiteral("TakeControl"));
-    msg.setArguments(QVariantList() << QVariant(false));
-
-    QDBusPendingReply<void> call = m_interface->connection().asyncCall(msg);
+    DBusCallCounter::record(subsystem);
+    QDBusPendingReply<void> call = m_session->TakeControl(false);
     QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(call);
     connect(watcher, &QDBusPendingCallWatcher::finished, this,
             [this](QDBusPendingCallWatcher *self) {
@@ -142,17 +173,20 @@ void LogindBackend::takeControl()
                                           login1SessionInterface,
                                           QStringLiteral("PauseDevice"),
                                           this, SLOT(devicePaused(quint32,quint32,QString)));
+        m_interface->connection().connect(login1Service, m_sessionPath,
+                                          login1SessionInterface,
+                                          QStringLiteral("ResumeDevice"),
+                                          this, SLOT(deviceResumed(quint32,quint32,QDBusUnixFileDescriptor)));
     });
 }
 
 void LogindBackend::releaseControl()
 {
-    if (m_sessionPath.isEmpty() || !m_sessionControl)
+    if (!m_session || !m_sessionControl)
         return;
 
-    QDBusInterface iface(login1Service, m_sessionPath, login1SessionInterface,
-                         m_interface->connection());
-    iface.asyncCall(QStringLiteral("ReleaseControl"));
+    DBusCallCounter::record(subsystem);
+    m_session->ReleaseControl();
 
     qCDebug(LOGIND_BACKEND) << "Session control released";
 
@@ -162,29 +196,76 @@ void LogindBackend::releaseControl()
 
 int LogindBackend::takeDevice(const QString &path)
 {
-    struct stat s;
-
-    if (::stat(path.toLatin1().constData(), &s) < 0) {
+    dev_t number;
+    if (!deviceNumber(path, &number)) {
         qCWarning(LOGIND_BACKEND) << "Couldn't stat" << path;
         return -1;
     }
 
-    QDBusMessage msg = QDBusMessage::createMethodCall(login1Service, m_sessionPath,
-                                                      login1SessionInterface,
-                                                      QStringLiteral("TakeDevice"));
-    msg.setArguments(QVariantList() << QVariant(major(s.st_rdev)) << QVariant(minor(s.st_rdev)));
-
-    QDBusMessage reply = m_interface->connection().call(msg);
+    DBusCallCounter::record(subsystem, DBusCallCounter::BlockingCall);
+    QDBusMessage reply = m_interface->connection().call(deviceMessage(QStringLiteral("TakeDevice"), number));
     if (reply.type() == QDBusMessage::ErrorMessage) {
         qCWarning(LOGIND_BACKEND,
                   "Couldn't take device \"%s\": %s",
                   qPrintable(path), qPrintable(reply.errorMessage()));
+        forgetDevice(number);
         return -1;
     }
 
     return ::dup(reply.arguments().first().value<QDBusUnixFileDescriptor>().fileDescriptor());
 }
 
+void LogindBackend::takeDevices(const QStringList &paths)
+{
+    // Issue all requests at once instead of waiting for each
+    // round trip, file descriptors are handed out by deviceTaken()
+    Q_FOREACH (const QString &path, paths) {
+        if (m_pendingDevices.contains(path))
+            continue;
+
+        dev_t number;
+        if (!deviceNumber(path, &number)) {
+            qCWarning(LOGIND_BACKEND) << "Couldn't stat" << path;
+            Q_EMIT deviceTaken(path, -1);
+            continue;
+        }
+
+        m_pendingDevices.insert(path);
+
+        DBusCallCounter::record(subsystem);
+        QDBusPendingCall call = m_interface->connection().asyncCall(deviceMessage(QStringLiteral("TakeDevice"), number));
+        QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(call, this);
+        connect(watcher, &QDBusPendingCallWatcher::finished, this,
+                [this, path, number](QDBusPendingCallWatcher *self) {
+            QDBusPendingReply<QDBusUnixFileDescriptor, bool> reply = *self;
+            self->deleteLater();
+
+            m_pendingDevices.remove(path);
+
+            if (!reply.isValid()) {
+                qCWarning(LOGIND_BACKEND,
+                          "Couldn't take device \"%s\": %s",
+                          qPrintable(path), qPrintable(reply.error().message()));
+                forgetDevice(number);
+                Q_EMIT deviceTaken(path, -1);
+                return;
+            }
+
+            // File descriptors are owned by the receiver, don't hand them
+            // out when nobody is listening or they would leak
+            if (!isSignalConnected(QMetaMethod::fromSignal(&LoginManagerBackend::deviceTaken))) {
+                qCDebug(LOGIND_BACKEND) << "Nobody is waiting for" << path << "releasing it";
+                DBusCallCounter::record(subsystem);
+                m_interface->connection().asyncCall(deviceMessage(QStringLiteral("ReleaseDevice"), number));
+                forgetDevice(number);
+                return;
+            }
+
+            Q_EMIT deviceTaken(path, ::dup(reply.argumentAt<0>().fileDescriptor()));
+        });
+    }
+}
+
 void LogindBackend::releaseDevice(int fd)
 {
     struct stat s;
@@ -194,12 +275,8 @@ void LogindBackend::releaseDevice(int fd)
         return;
     }
 
-    QDBusMessage msg = QDBusMessage::createMethodCall(login1Service, m_sessionPath,
-                                                      login1SessionInterface,
-                                                      QStringLiteral("ReleaseDevice"));
-    msg.setArguments(QVariantList() << QVariant(major(s.st_rdev)) << QVariant(minor(s.st_rdev)));
-
-    m_interface->connection().asyncCall(msg);
+    DBusCallCounter::record(subsystem);
+    m_interface->connection().asyncCall(deviceMessage(QStringLiteral("ReleaseDevice"), s.st_rdev));
 }
 
 void LogindBackend::lockSession()
@@ -214,16 +291,20 @@ void LogindBackend::unlockSession()
 
 void LogindBackend::requestLockSession()
 {
-    QDBusInterface iface(login1Service, m_sessionPath, login1SessionInterface,
-                         m_interface->connection());
-    iface.asyncCall(QStringLiteral("Lock"));
+    if (!m_session)
+        return;
+
+    DBusCallCounter::record(subsystem);
+    m_session->requestLock();
 }
 
 void LogindBackend::requestUnlockSession()
 {
-    QDBusInterface iface(login1Service, m_sessionPath, login1SessionInterface,
-                         m_interface->connection());
-    iface.asyncCall(QStringLiteral("Unlock"));
+    if (!m_session)
+        return;
+
+    DBusCallCounter::record(subsystem);
+    m_session->requestUnlock();
 }
 
 void LogindBackend::locked()
@@ -241,42 +322,17 @@ void LogindBackend::unlocked()
 
 void LogindBackend::switchToVt(int index)
 {
-    // Find a session whose VTNr is equal to index and activate it
-    QDBusPendingCall call = m_interface->asyncCall(QStringLiteral("ListSessions"));
-    QDBusPendingCallWatcher *w = new QDBusPendingCallWatcher(call);
-    connect(w, &QDBusPendingCallWatcher::finished, this, [this, index](QDBusPendingCallWatcher *watcher) {
-        QDBusPendingReply<LogindSessionInfoList> reply = *watcher;
-        watcher->deleteLater();
-        if (!reply.isValid())
-            return;
+    SessionPtr session = m_vtSessions.value(index);
+    if (!session) {
+        qCDebug(LOGIND_BACKEND) << "No session on vt" << index;
+        return;
+    }
 
-        Q_FOREACH (const LogindSessionInfo &sessionInfo, reply.value()) {
-            QDBusMessage msg = QDBusMessage::createMethodCall(login1Service, sessionInfo.sessionPath.path(),
-                                                              dbusPropertiesInterface,
-                                                              QStringLiteral("GetAll"));
-            msg.setArguments(QList<QVariant>() << login1SessionInterface);
-
-            QDBusPendingCall call = m_interface->connection().asyncCall(msg, 3000);
-            QDBusPendingCallWatcher *w = new QDBusPendingCallWatcher(call);
-            connect(w, &QDBusPendingCallWatcher::finished, this, [this, index, sessionInfo](QDBusPendingCallWatcher *watcher) {
-                QDBusPendingReply<QVariantMap> reply = *watcher;
-                watcher->deleteLater();
-                if (!reply.isValid())
-                    return;
-
-                QVariantMap props = reply.value();
-
-                bool ok = false;
-                int vtNr = props.value(QStringLiteral("VTNr")).toInt(&ok);
-                if (ok && vtNr == index) {
-                    qCDebug(LOGIND_BACKEND)
-                            << "Switching to session" << sessionInfo.sessionId
-                            << "on vt" << vtNr;
-                    m_interface->asyncCall(QStringLiteral("ActivateSession"), sessionInfo.sessionId);
-                }
-            });
-        }
-    });
+    qCDebug(LOGIND_BACKEND)
+            << "Switching to session" << session->id()
+            << "on vt" << index;
+    DBusCallCounter::record(subsystem);
+    m_interface->asyncCall(QStringLiteral("ActivateSession"), session->id());
 }
 
 void LogindBackend::setupInhibitors()
@@ -285,6 +341,7 @@ void LogindBackend::setupInhibitors()
     if (m_inhibitFd > 0 || m_sessionManager->isLocked())
         return;
 
+    DBusCallCounter::record(subsystem);
     QDBusPendingCall call = m_interface->asyncCall(QStringLiteral("Inhibit"),
                                                    QStringLiteral("shutdown:sleep"),
                                                    QStringLiteral("Hawaii"),
@@ -316,10 +373,12 @@ void LogindBackend::setupInhibitors()
 
 void LogindBackend::prepareForSleep(bool arg)
 {
-    // Ask to lock the session when the system is
-    // going to sleep
+    // Ask to lock the session when the system is going to sleep,
+    // the delay inhibitor is released by locked() once the lock
+    // screen is on screen
     if (arg)
         Q_EMIT sessionLocked();
+    Q_EMIT preparingForSleep(arg);
 }
 
 void LogindBackend::prepareForShutdown(bool arg)
@@ -340,6 +399,11 @@ void LogindBackend::getSession(QDBusPendingCallWatcher *watcher)
     m_sessionPath = reply.value().path();
     qCDebug(LOGIND_BACKEND) << "Session path:" << m_sessionPath;
 
+    // Generated proxies don't introspect, unlike QDBusInterface,
+    // so calls on the session never block
+    m_session = new OrgFreedesktopLogin1SessionInterface(login1Service, m_sessionPath,
+                                                         m_interface->connection(), this);
+
     // Emit signals when the session is locked/unlocked by logind
     m_interface->connection().connect(login1Service, m_sessionPath,
                                       login1SessionInterface,
@@ -355,14 +419,145 @@ void LogindBackend::getSession(QDBusPendingCallWatcher *watcher)
     setIdle(false);
 }
 
+void LogindBackend::addSession(const SessionPtr &session)
+{
+    if (!session)
+        return;
+
+    // Sessions without a VT, for example on seats other than seat0
+    // or remote sessions, cannot be switched to with a key binding
+    const int vtNr = static_cast<int>(session->vTNr());
+    if (vtNr <= 0)
+        return;
+
+    qCDebug(LOGIND_BACKEND) << "Session" << session->id() << "is on vt" << vtNr;
+    m_vtSessions.insert(vtNr, session);
+}
+
+void LogindBackend::sessionRemoved(const QString &id, const QDBusObjectPath &path)
+{
+    QHash<int, SessionPtr>::iterator it = m_vtSessions.begin();
+    while (it != m_vtSessions.end()) {
+        if (it.value()->path() == path.path()) {
+            qCDebug(LOGIND_BACKEND) << "Session" << id << "on vt" << it.key() << "was removed";
+            it = m_vtSessions.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+bool LogindBackend::deviceNumber(const QString &path, dev_t *number)
+{
+    QHash<QString, dev_t>::const_iterator it = m_deviceNumbers.constFind(path);
+    if (it != m_deviceNumbers.constEnd()) {
+        *number = it.value();
+        return true;
+    }
+
+    struct stat s;
+    if (::stat(QFile::encodeName(path).constData(), &s) < 0)
+        return false;
+
+    m_deviceNumbers.insert(path, s.st_rdev);
+    m_devicePaths.insert(s.st_rdev, path);
+    *number = s.st_rdev;
+    return true;
+}
+
+void LogindBackend::forgetDevice(dev_t number)
+{
+    // Device nodes might be created again with a different number
+    m_deviceNumbers.remove(m_devicePaths.take(number));
+}
+
+QDBusMessage LogindBackend::deviceMessage(const QString &method, dev_t number) const
+{
+    QDBusMessage msg = QDBusMessage::createMethodCall(login1Service, m_sessionPath,
+                                                      login1SessionInterface,
+                                                      method);
+    msg.setArguments(QVariantList() << QVariant(major(number)) << QVariant(minor(number)));
+    return msg;
+}
+
 void LogindBackend::devicePaused(quint32 devMajor, quint32 devMinor, const QString &type)
 {
-    if (QString::compare(type, QStringLiteral("pause"), Qt::CaseInsensitive) == 0) {
-        QDBusMessage msg = QDBusMessage::createMethodCall(login1Service, m_sessionPath,
-                                                          login1SessionInterface,
-                                                          QStringLiteral("PauseDeviceComplete"));
-        msg.setArguments(QVariantList() << QVariant(devMajor) << QVariant(devMinor));
-        m_interface->connection().asyncCall(msg);
+    m_pausedDevices.append(qMakePair(makedev(devMajor, devMinor), type));
+    m_deviceTimer->start();
+}
+
+void LogindBackend::deviceResumed(quint32 devMajor, quint32 devMinor, const QDBusUnixFileDescriptor &fd)
+{
+    // Resumed devices are only interesting to whoever is using them
+    if (!isSignalConnected(QMetaMethod::fromSignal(&LoginManagerBackend::devicesResumed)))
+        return;
+
+    m_resumedDevices.append(qMakePair(makedev(devMajor, devMinor), fd));
+    m_deviceTimer->start();
+}
+
+void LogindBackend::flushDevices()
+{
+    if (!m_pausedDevices.isEmpty()) {
+        QStringList paths;
+        QList<dev_t> acknowledge;
+
+        for (int i = 0; i < m_pausedDevices.size(); i++) {
+            const dev_t number = m_pausedDevices.at(i).first;
+            const QString type = m_pausedDevices.at(i).second;
+
+            const QString path = m_devicePaths.value(number);
+            if (!path.isEmpty())
+                paths.append(path);
+
+            if (QString::compare(type, QStringLiteral("pause"), Qt::CaseInsensitive) == 0)
+                acknowledge.append(number);
+            else if (QString::compare(type, QStringLiteral("gone"), Qt::CaseInsensitive) == 0)
+                forgetDevice(number);
+        }
+        m_pausedDevices.clear();
+
+        qCDebug(LOGIND_BACKEND) << "Paused" << paths.size() << "device(s)";
+
+        // Let users stop using the devices before acknowledging
+        Q_EMIT devicesPaused(paths);
+
+        Q_FOREACH (dev_t number, acknowledge) {
+            DBusCallCounter::record(subsystem);
+            m_interface->connection().asyncCall(deviceMessage(QStringLiteral("PauseDeviceComplete"), number));
+        }
+    }
+
+    if (!m_resumedDevices.isEmpty()) {
+        QStringList paths;
+        QList<int> fds;
+
+        // Receivers might have gone away since the devices were queued,
+        // duplicate descriptors only when somebody is going to own them
+        const bool connected = isSignalConnected(QMetaMethod::fromSignal(&LoginManagerBackend::devicesResumed));
+
+        for (int i = 0; i < m_resumedDevices.size() && connected; i++) {
+            const QString path = m_devicePaths.value(m_resumedDevices.at(i).first);
+            if (path.isEmpty())
+                continue;
+
+            const int fd = ::dup(m_resumedDevices.at(i).second.fileDescriptor());
+            if (fd < 0) {
+                qCWarning(LOGIND_BACKEND) << "Couldn't duplicate file descriptor for" << path;
+                continue;
+            }
+
+            paths.append(path);
+            fds.append(fd);
+        }
+        m_resumedDevices.clear();
+
+        if (!connected)
+            return;
+
+        qCDebug(LOGIND_BACKEND) << "Resumed" << paths.size() << "device(s)";
+
+        Q_EMIT devicesResumed(paths, fds);
     }
 }
 
@@ -27,15 +27,26 @@
 #ifndef LOGINDBACKEND_H
 #define LOGINDBACKEND_H
 
+#include <QtCore/QHash>
 #include <QtCore/QLoggingCategory>
+#include <QtCore/QSet>
 #include <QtDBus/QDBusConnection>
+#include <QtDBus/QDBusMessage>
+#include <QtDBus/QDBusUnixFileDescriptor>
+
+#include <sys/types.h>
 
 #include "loginmanagerbackend.h"
+#include "qlogind/src/session.h"
 
 Q_DECLARE_LOGGING_CATEGORY(LOGIND_BACKEND)
 
 class QDBusInterface;
 class QDBusPendingCallWatcher;
+class QTimer;
+
+class OrgFreedesktopLogin1SessionInterface;
+class SessionTracker;
 
 class SessionManager;
 
@@ -56,6 +67,7 @@ public:
     void releaseControl();
 
     int takeDevice(const QString &path);
+    void takeDevices(const QStringList &paths);
     void releaseDevice(int fd);
 
     void lockSession();
@@ -75,15 +87,36 @@ private:
     SessionManager *m_sessionManager;
     QDBusInterface *m_interface;
     QString m_sessionPath;
+    OrgFreedesktopLogin1SessionInterface *m_session;
     int m_inhibitFd;
 
+    QHash<QString, dev_t> m_deviceNumbers;
+    QHash<dev_t, QString> m_devicePaths;
+    QSet<QString> m_pendingDevices;
+
+    SessionTracker *m_sessionTracker;
+    QHash<int, SessionPtr> m_vtSessions;
+
+    QTimer *m_deviceTimer;
+    QList<QPair<dev_t, QString> > m_pausedDevices;
+    QList<QPair<dev_t, QDBusUnixFileDescriptor> > m_resumedDevices;
+
     void setupInhibitors();
 
+    void addSession(const SessionPtr &session);
+
+    bool deviceNumber(const QString &path, dev_t *number);
+    void forgetDevice(dev_t number);
+    QDBusMessage deviceMessage(const QString &method, dev_t number) const;
+
 private Q_SLOTS:
     void prepareForSleep(bool arg);
     void prepareForShutdown(bool arg);
     void getSession(QDBusPendingCallWatcher *watcher);
+    void sessionRemoved(const QString &id, const QDBusObjectPath &path);
     void devicePaused(quint32 devMajor, quint32 devMinor, const QString &type);
+    void deviceResumed(quint32 devMajor, quint32 devMinor, const QDBusUnixFileDescriptor &fd);
+    void flushDevices();
 };
 
 #endif // LOGINDBACKEND_H
@@ -1,76 +0,0 @@
-/****************************************************************************
- * This file is part of Hawaii.
- *
- * Copyright (C) 2015-2016 Pier Luigi Fiorini
- *
- * Author(s):
- *    Pier Luigi Fiorini <pierluigi.fiorini@gmail.com>
- *
- * $BEGIN_LICENSE:GPL2+$
- *
- * This program is free software: you can redistribute it and/or modify
- * it under the terms of the GNU General Public License as published by
- * the Free Software Foundation, either version 2 of the License, or
- * (at your option) any later version.
- *
- * This program is distributed in the hope that it will be useful,
- * but WITHOUT ANY WARRANTY; without even the implied warranty of
- * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
- * GNU General Public License for more details.
- *
- * You should have received a copy of the GNU General Public License
- * along with this program.  If not, see <http://www.gnu.org/licenses/>.
- *
- * $END_LICENSE$
- ***************************************************************************/
-
-#ifndef LOGINDSESSIONINFO_H
-#define LOGINDSESSIONINFO_H
-
-#include <QtDBus/QDBusObjectPath>
-#include <QtDBus/QDBusArgument>
-
-struct LogindSessionInfo
-{
-    QString sessionId;
-    uint userId;
-    QString userName;
-    QString seatId;
-    QDBusObjectPath sessionPath;
-};
-
-Q_DECLARE_TYPEINFO(LogindSessionInfo, Q_PRIMITIVE_TYPE);
-Q_DECLARE_METATYPE(LogindSessionInfo)
-
-typedef QList<LogindSessionInfo> LogindSessionInfoList;
-
-Q_DECLARE_METATYPE(LogindSessionInfoList)
-
-inline QDBusArgument &operator<<(QDBusArgument &argument, const LogindSessionInfo &sessionInfo)
-{
-    argument.beginStructure();
-    argument << sessionInfo.sessionId;
-    argument << sessionInfo.userId;
-    argument << sessionInfo.userName;
-    argument << sessionInfo.seatId;
-    argument << sessionInfo.sessionPath;
-    argument.endStructure();
-
-    return argument;
-}
-
-inline const QDBusArgument &operator>>(const QDBusArgument &argument, LogindSessionInfo &sessionInfo)
-{
-    argument.beginStructure();
-    argument >> sessionInfo.sessionId;
-    argument >> sessionInfo.userId;
-    argument >> sessionInfo.userName;
-    argument >> sessionInfo.seatId;
-    argument >> sessionInfo.sessionPath;
-    argument.endStructure();
-
-    return argument;
-}
-
-#endif // LOGINDSESSIONINFO_H
-
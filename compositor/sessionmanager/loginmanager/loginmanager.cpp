@@ -46,6 +46,13 @@ LoginManager::LoginManager(SessionManager *sm, QObject *parent)
             this, SIGNAL(sessionLocked()));
     connect(m_backend, SIGNAL(sessionUnlocked()),
             this, SIGNAL(sessionUnlocked()));
+    connect(m_backend, SIGNAL(preparingForSleep(bool)),
+            this, SIGNAL(preparingForSleep(bool)));
+    connect(m_backend, SIGNAL(devicesPaused(QStringList)),
+            this, SIGNAL(devicesPaused(QStringList)));
+
+    // Device file descriptors are relayed only while somebody is
+    // listening, see connectNotify()
 }
 
 LoginManager::~LoginManager()
@@ -54,6 +61,31 @@ LoginManager::~LoginManager()
         m_backend->deleteLater();
 }
 
+void LoginManager::connectNotify(const QMetaMethod &signal)
+{
+    // The backend hands out file descriptors owned by the receiver
+    // only when its signals are connected, so relay them on demand
+    if (signal == QMetaMethod::fromSignal(&LoginManager::deviceTaken))
+        connect(m_backend, &LoginManagerBackend::deviceTaken,
+                this, &LoginManager::deviceTaken, Qt::UniqueConnection);
+    else if (signal == QMetaMethod::fromSignal(&LoginManager::devicesResumed))
+        connect(m_backend, &LoginManagerBackend::devicesResumed,
+                this, &LoginManager::devicesResumed, Qt::UniqueConnection);
+}
+
+void LoginManager::disconnectNotify(const QMetaMethod &signal)
+{
+    // Invalid method means everything was disconnected
+    Q_UNUSED(signal);
+
+    if (!isSignalConnected(QMetaMethod::fromSignal(&LoginManager::deviceTaken)))
+        disconnect(m_backend, &LoginManagerBackend::deviceTaken,
+                   this, &LoginManager::deviceTaken);
+    if (!isSignalConnected(QMetaMethod::fromSignal(&LoginManager::devicesResumed)))
+        disconnect(m_backend, &LoginManagerBackend::devicesResumed,
+                   this, &LoginManager::devicesResumed);
+}
+
 void LoginManager::setIdle(bool value)
 {
     m_backend->setIdle(value);
@@ -74,6 +106,11 @@ int LoginManager::takeDevice(const QString &path)
     return m_backend->takeDevice(path);
 }
 
+void LoginManager::takeDevices(const QStringList &paths)
+{
+    m_backend->takeDevices(paths);
+}
+
 void LoginManager::releaseDevice(int fd)
 {
     m_backend->releaseDevice(fd);
@@ -29,6 +29,7 @@
 
 #include <QtCore/QObject>
 #include <QtCore/QLoggingCategory>
+#include <QtCore/QMetaMethod>
 
 #include "loginmanagerbackend.h"
 
@@ -49,6 +50,7 @@ public:
     void releaseControl();
 
     int takeDevice(const QString &path);
+    void takeDevices(const QStringList &paths);
     void releaseDevice(int fd);
 
     void lockSession();
@@ -64,6 +66,15 @@ Q_SIGNALS:
     void logOutRequested();
     void sessionLocked();
     void sessionUnlocked();
+    void preparingForSleep(bool active);
+
+    void deviceTaken(const QString &path, int fd);
+    void devicesPaused(const QStringList &paths);
+    void devicesResumed(const QStringList &paths, const QList<int> &fds);
+
+protected:
+    void connectNotify(const QMetaMethod &signal) Q_DECL_OVERRIDE;
+    void disconnectNotify(const QMetaMethod &signal) Q_DECL_OVERRIDE;
 
 private:
     LoginManagerBackend *m_backend;
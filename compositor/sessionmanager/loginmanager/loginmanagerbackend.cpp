@@ -52,7 +52,13 @@ void LoginManagerBackend::releaseControl()
 int LoginManagerBackend::takeDevice(const QString &path)
 {
     Q_UNUSED(path)
-    return false;
+    return -1;
+}
+
+void LoginManagerBackend::takeDevices(const QStringList &paths)
+{
+    Q_FOREACH (const QString &path, paths)
+        Q_EMIT deviceTaken(path, takeDevice(path));
 }
 
 void LoginManagerBackend::releaseDevice(int fd)
@@ -28,6 +28,7 @@
 #define LOGINMANAGERBACKEND_H
 
 #include <QtCore/QObject>
+#include <QtCore/QStringList>
 
 class LoginManagerBackend : public QObject
 {
@@ -46,6 +47,7 @@ public:
     virtual void releaseControl();
 
     virtual int takeDevice(const QString &path);
+    virtual void takeDevices(const QStringList &paths);
     virtual void releaseDevice(int fd);
 
     virtual void lockSession() = 0;
@@ -62,6 +64,14 @@ Q_SIGNALS:
     void sessionLocked();
     void sessionUnlocked();
 
+    // True before the system goes to sleep, false after resume
+    void preparingForSleep(bool active);
+
+    // File descriptors are owned by the receiver, -1 means failure
+    void deviceTaken(const QString &path, int fd);
+    void devicesPaused(const QStringList &paths);
+    void devicesResumed(const QStringList &paths, const QList<int> &fds);
+
 protected:
     bool m_sessionControl;
 };
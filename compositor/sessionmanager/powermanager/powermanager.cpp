@@ -25,26 +25,46 @@
  ***************************************************************************/
 
 #include <QtDBus/QDBusConnectionInterface>
+#include <QtDBus/QDBusPendingCallWatcher>
+#include <QtDBus/QDBusPendingReply>
+#include <QtDBus/QDBusServiceWatcher>
 
 #include "powermanager.h"
 #include "systemdpowerbackend.h"
 #include "upowerpowerbackend.h"
+#include "sessionmanager/dbuscallcounter.h"
 
 PowerManager::PowerManager(QObject *parent)
     : QObject(parent)
+    , m_capabilities(PowerManager::None)
 {
-    QDBusConnectionInterface *interface = QDBusConnection::systemBus().interface();
-
-    if (interface->isServiceRegistered(SystemdPowerBackend::service()))
-        m_backends.append(new SystemdPowerBackend());
-
-    if (interface->isServiceRegistered(UPowerPowerBackend::service()))
-        m_backends.append(new UPowerPowerBackend());
-
-    connect(interface, &QDBusConnectionInterface::serviceRegistered,
+    const QStringList services = QStringList()
+            << SystemdPowerBackend::service()
+            << UPowerPowerBackend::service();
+
+    // Only watch the services we are interested in
+    m_watcher = new QDBusServiceWatcher(this);
+    m_watcher->setConnection(QDBusConnection::systemBus());
+    m_watcher->setWatchedServices(services);
+    connect(m_watcher, &QDBusServiceWatcher::serviceRegistered,
             this, &PowerManager::serviceRegistered);
-    connect(interface, &QDBusConnectionInterface::serviceUnregistered,
+    connect(m_watcher, &QDBusServiceWatcher::serviceUnregistered,
             this, &PowerManager::serviceUnregistered);
+
+    // Find out which services are already running without blocking
+    QDBusConnectionInterface *interface = QDBusConnection::systemBus().interface();
+    Q_FOREACH (const QString &service, services) {
+        DBusCallCounter::record(QStringLiteral("power"));
+        QDBusPendingCall call = interface->asyncCall(QStringLiteral("NameHasOwner"), service);
+        QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(call, this);
+        connect(watcher, &QDBusPendingCallWatcher::finished, this, [this, service](QDBusPendingCallWatcher *self) {
+            QDBusPendingReply<bool> reply = *self;
+            self->deleteLater();
+
+            if (reply.isValid() && reply.value())
+                addBackend(service);
+        });
+    }
 }
 
 PowerManager::~PowerManager()
@@ -55,12 +75,7 @@ PowerManager::~PowerManager()
 
 PowerManager::Capabilities PowerManager::capabilities() const
 {
-    PowerManager::Capabilities caps = PowerManager::None;
-
-    foreach (PowerManagerBackend *backend, m_backends)
-        caps |= backend->capabilities();
-
-    return caps;
+    return m_capabilities;
 }
 
 void PowerManager::powerOff()
@@ -115,40 +130,62 @@ void PowerManager::hybridSleep()
 
 void PowerManager::serviceRegistered(const QString &service)
 {
-    // Just return if we already have all the backends registered
-    if (m_backends.size() == 2)
-        return;
-
-    // Otherwise add the most appropriate backend
-    if (service == SystemdPowerBackend::service()) {
-        m_backends.append(new SystemdPowerBackend());
-        Q_EMIT capabilitiesChanged();
-    } else if (service == UPowerPowerBackend::service()) {
-        m_backends.append(new UPowerPowerBackend());
-        Q_EMIT capabilitiesChanged();
-    }
+    addBackend(service);
 }
 
 void PowerManager::serviceUnregistered(const QString &service)
 {
-    // Just return if we don't have any backend already
-    if (m_backends.size() == 0)
-        return;
-
-    // Otherwise remove the backend corresponding to the service
+    // Remove the backend corresponding to the service
     for (int i = 0; i < m_backends.size(); i++) {
         PowerManagerBackend *backend = m_backends.at(i);
 
-        if (service == SystemdPowerBackend::service() && backend->name() == QStringLiteral("systemd")) {
-            delete m_backends.takeAt(i);
-            Q_EMIT capabilitiesChanged();
-            return;
-        } else if (service == UPowerPowerBackend::service() && backend->name() == QStringLiteral("upower")) {
-            delete m_backends.takeAt(i);
-            Q_EMIT capabilitiesChanged();
+        if ((service == SystemdPowerBackend::service() && backend->name() == QStringLiteral("systemd")) ||
+                (service == UPowerPowerBackend::service() && backend->name() == QStringLiteral("upower"))) {
+            m_backends.takeAt(i)->deleteLater();
+            updateCapabilities();
             return;
         }
     }
 }
 
+void PowerManager::updateCapabilities()
+{
+    PowerManager::Capabilities caps = PowerManager::None;
+
+    Q_FOREACH (PowerManagerBackend *backend, m_backends)
+        caps |= backend->capabilities();
+
+    if (m_capabilities == caps)
+        return;
+
+    m_capabilities = caps;
+    Q_EMIT capabilitiesChanged();
+}
+
+void PowerManager::addBackend(const QString &service)
+{
+    const QString name = service == SystemdPowerBackend::service()
+            ? QStringLiteral("systemd") : QStringLiteral("upower");
+
+    // Each backend is added only once, the service might have been
+    // registered while we were asking whether it was running
+    Q_FOREACH (PowerManagerBackend *backend, m_backends) {
+        if (backend->name() == name)
+            return;
+    }
+
+    PowerManagerBackend *backend = Q_NULLPTR;
+    if (service == SystemdPowerBackend::service())
+        backend = new SystemdPowerBackend();
+    else if (service == UPowerPowerBackend::service())
+        backend = new UPowerPowerBackend();
+    if (!backend)
+        return;
+
+    // Capabilities are fetched asynchronously by the backend
+    connect(backend, &PowerManagerBackend::capabilitiesChanged,
+            this, &PowerManager::updateCapabilities);
+    m_backends.append(backend);
+}
+
 #include "moc_powermanager.cpp"
@@ -29,6 +29,8 @@
 
 #include <QtCore/QObject>
 
+class QDBusServiceWatcher;
+
 class PowerManagerBackend;
 
 class PowerManager : public QObject
@@ -67,11 +69,16 @@ public Q_SLOTS:
 private Q_SLOTS:
     void serviceRegistered(const QString &service);
     void serviceUnregistered(const QString &service);
+    void updateCapabilities();
 
 private:
     Q_DISABLE_COPY(PowerManager)
 
+    QDBusServiceWatcher *m_watcher;
     QList<PowerManagerBackend *> m_backends;
+    Capabilities m_capabilities;
+
+    void addBackend(const QString &service);
 };
 
 Q_DECLARE_METATYPE(PowerManager *)
@@ -27,9 +27,26 @@
 #include "powermanagerbackend.h"
 
 PowerManagerBackend::PowerManagerBackend()
+    : m_capabilities(PowerManager::None)
 {
 }
 
 PowerManagerBackend::~PowerManagerBackend()
 {
 }
+
+PowerManager::Capabilities PowerManagerBackend::capabilities() const
+{
+    return m_capabilities;
+}
+
+void PowerManagerBackend::setCapabilities(PowerManager::Capabilities caps)
+{
+    if (m_capabilities == caps)
+        return;
+
+    m_capabilities = caps;
+    Q_EMIT capabilitiesChanged();
+}
+
+#include "moc_powermanagerbackend.cpp"
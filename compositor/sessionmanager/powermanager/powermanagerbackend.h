@@ -34,19 +34,37 @@
 
 class PowerManagerBackend : public QObject
 {
+    Q_OBJECT
 public:
     explicit PowerManagerBackend();
     virtual ~PowerManagerBackend();
 
     virtual QString name() const = 0;
 
-    virtual PowerManager::Capabilities capabilities() const = 0;
+    /*!
+     * \brief Capabilities.
+     *
+     * Returns the cached capabilities, which are fetched
+     * asynchronously by refreshCapabilities().
+     */
+    PowerManager::Capabilities capabilities() const;
+
+    virtual void refreshCapabilities() = 0;
 
     virtual void powerOff() = 0;
     virtual void restart() = 0;
     virtual void suspend() = 0;
     virtual void hibernate() = 0;
     virtual void hybridSleep() = 0;
+
+Q_SIGNALS:
+    void capabilitiesChanged();
+
+protected:
+    void setCapabilities(PowerManager::Capabilities caps);
+
+private:
+    PowerManager::Capabilities m_capabilities;
 };
 
 #endif // POWERMANAGERBACKEND_H
@@ -24,28 +24,50 @@
  * $END_LICENSE$
  ***************************************************************************/
 
-#include <QtDBus/QDBusReply>
+#include <QtCore/QSharedPointer>
+#include <QtDBus/QDBusConnection>
+#include <QtDBus/QDBusPendingCallWatcher>
+#include <QtDBus/QDBusPendingReply>
 
 #include "systemdpowerbackend.h"
+#include "sessionmanager/dbuscallcounter.h"
 
 #define LOGIN1_SERVICE QStringLiteral("org.freedesktop.login1")
 #define LOGIN1_PATH QStringLiteral("/org/freedesktop/login1")
 #define LOGIN1_OBJECT QStringLiteral("org.freedesktop.login1.Manager")
 
+class SystemdCapabilities
+{
+public:
+    SystemdCapabilities()
+        : caps(PowerManager::None)
+        , pending(0)
+    {
+    }
+
+    PowerManager::Capabilities caps;
+    int pending;
+};
+
 QString SystemdPowerBackend::service()
 {
     return LOGIN1_SERVICE;
 }
 
 SystemdPowerBackend::SystemdPowerBackend()
+    : m_generation(0)
 {
-    m_interface = new QDBusInterface(LOGIN1_SERVICE, LOGIN1_PATH,
-                                     LOGIN1_OBJECT, QDBusConnection::systemBus());
+    // Capabilities might change after resume, for example
+    // when the swap partition was changed
+    QDBusConnection::systemBus().connect(LOGIN1_SERVICE, LOGIN1_PATH, LOGIN1_OBJECT,
+                                         QStringLiteral("PrepareForSleep"),
+                                         this, SLOT(prepareForSleep(bool)));
+
+    refreshCapabilities();
 }
 
 SystemdPowerBackend::~SystemdPowerBackend()
 {
-    m_interface->deleteLater();
 }
 
 QString SystemdPowerBackend::name() const
@@ -53,59 +75,90 @@ QString SystemdPowerBackend::name() const
     return QStringLiteral("systemd");
 }
 
-PowerManager::Capabilities SystemdPowerBackend::capabilities() const
+void SystemdPowerBackend::refreshCapabilities()
 {
-    PowerManager::Capabilities caps = PowerManager::None;
-
-    QStringList validValues;
-    validValues << QStringLiteral("yes") << QStringLiteral("challenge");
-
-    QDBusReply<QString> reply;
-
-    reply = m_interface->call(QStringLiteral("CanPowerOff"));
-    if (reply.isValid() && validValues.contains(reply.value()))
-        caps |= PowerManager::PowerOff;
-
-    reply = m_interface->call(QStringLiteral("CanReboot"));
-    if (reply.isValid() && validValues.contains(reply.value()))
-        caps |= PowerManager::Restart;
-
-    reply = m_interface->call(QStringLiteral("CanSuspend"));
-    if (reply.isValid() && validValues.contains(reply.value()))
-        caps |= PowerManager::Suspend;
-
-    reply = m_interface->call(QStringLiteral("CanHibernate"));
-    if (reply.isValid() && validValues.contains(reply.value()))
-        caps |= PowerManager::Hibernate;
-
-    reply = m_interface->call(QStringLiteral("CanHybridSleep"));
-    if (reply.isValid() && validValues.contains(reply.value()))
-        caps |= PowerManager::HybridSleep;
-
-    return caps;
+    typedef QPair<QString, PowerManager::Capability> Query;
+    const QList<Query> queries = QList<Query>()
+            << qMakePair(QStringLiteral("CanPowerOff"), PowerManager::PowerOff)
+            << qMakePair(QStringLiteral("CanReboot"), PowerManager::Restart)
+            << qMakePair(QStringLiteral("CanSuspend"), PowerManager::Suspend)
+            << qMakePair(QStringLiteral("CanHibernate"), PowerManager::Hibernate)
+            << qMakePair(QStringLiteral("CanHybridSleep"), PowerManager::HybridSleep);
+
+    // Results of a refresh that was superseded are ignored
+    const quint32 generation = ++m_generation;
+
+    QSharedPointer<SystemdCapabilities> result(new SystemdCapabilities);
+    result->pending = queries.size();
+
+    // Ask everything at once, capabilities are updated
+    // when all the replies have arrived
+    Q_FOREACH (const Query &query, queries) {
+        const PowerManager::Capability capability = query.second;
+
+        DBusCallCounter::record(QStringLiteral("power"));
+        QDBusPendingCall call = QDBusConnection::systemBus().asyncCall(methodCall(query.first));
+        QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(call, this);
+        connect(watcher, &QDBusPendingCallWatcher::finished, this,
+                [this, generation, result, capability](QDBusPendingCallWatcher *self) {
+            QDBusPendingReply<QString> reply = *self;
+            self->deleteLater();
+
+            if (reply.isValid() && (reply.value() == QStringLiteral("yes") ||
+                                    reply.value() == QStringLiteral("challenge")))
+                result->caps |= capability;
+
+            if (--result->pending == 0 && generation == m_generation)
+                setCapabilities(result->caps);
+        });
+    }
 }
 
 void SystemdPowerBackend::powerOff()
 {
-    m_interface->call(QStringLiteral("PowerOff"), true);
+    callAction(QStringLiteral("PowerOff"));
 }
 
 void SystemdPowerBackend::restart()
 {
-    m_interface->call(QStringLiteral("Reboot"), true);
+    callAction(QStringLiteral("Reboot"));
 }
 
 void SystemdPowerBackend::suspend()
 {
-    m_interface->call(QStringLiteral("Suspend"), true);
+    callAction(QStringLiteral("Suspend"));
 }
 
 void SystemdPowerBackend::hibernate()
 {
-    m_interface->call(QStringLiteral("Hibernate"), true);
+    callAction(QStringLiteral("Hibernate"));
 }
 
 void SystemdPowerBackend::hybridSleep()
 {
-    m_interface->call(QStringLiteral("HybridSleep"), true);
+    callAction(QStringLiteral("HybridSleep"));
 }
+
+QDBusMessage SystemdPowerBackend::methodCall(const QString &method) const
+{
+    return QDBusMessage::createMethodCall(LOGIN1_SERVICE, LOGIN1_PATH,
+                                          LOGIN1_OBJECT, method);
+}
+
+void SystemdPowerBackend::callAction(const QString &method)
+{
+    QDBusMessage msg = methodCall(method);
+    msg.setArguments(QVariantList() << true);
+
+    DBusCallCounter::record(QStringLiteral("power"));
+    QDBusConnection::systemBus().asyncCall(msg);
+}
+
+void SystemdPowerBackend::prepareForSleep(bool arg)
+{
+    // Refresh when the system is back
+    if (!arg)
+        refreshCapabilities();
+}
+
+#include "moc_systemdpowerbackend.cpp"
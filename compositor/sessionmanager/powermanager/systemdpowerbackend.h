@@ -27,12 +27,13 @@
 #ifndef SYSTEMDPOWERBACKEND_H
 #define SYSTEMDPOWERBACKEND_H
 
-#include <QtDBus/QDBusInterface>
+#include <QtDBus/QDBusMessage>
 
 #include "powermanagerbackend.h"
 
 class SystemdPowerBackend : public PowerManagerBackend
 {
+    Q_OBJECT
 public:
     SystemdPowerBackend();
     virtual ~SystemdPowerBackend();
@@ -41,7 +42,7 @@ public:
 
     QString name() const;
 
-    PowerManager::Capabilities capabilities() const;
+    void refreshCapabilities();
 
     void powerOff();
     void restart();
@@ -50,7 +51,13 @@ public:
     void hybridSleep();
 
 private:
-    QDBusInterface *m_interface;
+    quint32 m_generation;
+
+    QDBusMessage methodCall(const QString &method) const;
+    void callAction(const QString &method);
+
+private Q_SLOTS:
+    void prepareForSleep(bool arg);
 };
 
 #endif // SYSTEMDPOWERBACKEND_H
@@ -24,29 +24,45 @@
  * $END_LICENSE$
  ***************************************************************************/
 
-#include <QtDBus/QDBusReply>
 #include <QtCore/QProcess>
+#include <QtCore/QSharedPointer>
+#include <QtDBus/QDBusConnection>
+#include <QtDBus/QDBusPendingCallWatcher>
+#include <QtDBus/QDBusPendingReply>
 
 #include "upowerpowerbackend.h"
+#include "sessionmanager/dbuscallcounter.h"
 
 #define UPOWER_SERVICE QStringLiteral("org.freedesktop.UPower")
 #define UPOWER_PATH QStringLiteral("/org/freedesktop/UPower")
 #define UPOWER_OBJECT QStringLiteral("org.freedesktop.UPower")
 
+class UPowerCapabilities
+{
+public:
+    UPowerCapabilities()
+        : caps(PowerManager::None)
+        , pending(0)
+    {
+    }
+
+    PowerManager::Capabilities caps;
+    int pending;
+};
+
 QString UPowerPowerBackend::service()
 {
     return UPOWER_SERVICE;
 }
 
 UPowerPowerBackend::UPowerPowerBackend()
+    : m_generation(0)
 {
-    m_interface = new QDBusInterface(UPOWER_SERVICE, UPOWER_PATH,
-                                     UPOWER_OBJECT, QDBusConnection::systemBus());
+    refreshCapabilities();
 }
 
 UPowerPowerBackend::~UPowerPowerBackend()
 {
-    m_interface->deleteLater();
 }
 
 QString UPowerPowerBackend::name() const
@@ -54,43 +70,68 @@ QString UPowerPowerBackend::name() const
     return QStringLiteral("upower");
 }
 
-PowerManager::Capabilities UPowerPowerBackend::capabilities() const
+void UPowerPowerBackend::refreshCapabilities()
 {
-    PowerManager::Capabilities caps = PowerManager::None;
-
-    QDBusReply<QString> reply;
-
-    reply = m_interface->call(QStringLiteral("SuspendAllowed"));
-    if (reply.isValid() && reply.value() == QStringLiteral("yes"))
-        caps |= PowerManager::Suspend;
-
-    reply = m_interface->call(QStringLiteral("HibernateAllowed"));
-    if (reply.isValid() && reply.value() == QStringLiteral("yes"))
-        caps |= PowerManager::Hibernate;
-
-    return caps;
+    typedef QPair<QString, PowerManager::Capability> Query;
+    const QList<Query> queries = QList<Query>()
+            << qMakePair(QStringLiteral("SuspendAllowed"), PowerManager::Suspend)
+            << qMakePair(QStringLiteral("HibernateAllowed"), PowerManager::Hibernate);
+
+    const quint32 generation = ++m_generation;
+
+    QSharedPointer<UPowerCapabilities> result(new UPowerCapabilities);
+    result->pending = queries.size();
+
+    Q_FOREACH (const Query &query, queries) {
+        const PowerManager::Capability capability = query.second;
+
+        DBusCallCounter::record(QStringLiteral("power"));
+        QDBusPendingCall call = QDBusConnection::systemBus().asyncCall(methodCall(query.first));
+        QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(call, this);
+        connect(watcher, &QDBusPendingCallWatcher::finished, this,
+                [this, generation, result, capability](QDBusPendingCallWatcher *self) {
+            QDBusPendingReply<bool> reply = *self;
+            self->deleteLater();
+
+            if (reply.isValid() && reply.value())
+                result->caps |= capability;
+
+            if (--result->pending == 0 && generation == m_generation)
+                setCapabilities(result->caps);
+        });
+    }
 }
 
 void UPowerPowerBackend::powerOff()
 {
-    QProcess::execute(QStringLiteral("/sbin/poweroff"));
+    QProcess::startDetached(QStringLiteral("/sbin/poweroff"));
 }
 
 void UPowerPowerBackend::restart()
 {
-    QProcess::execute(QStringLiteral("/sbin/reboot"));
+    QProcess::startDetached(QStringLiteral("/sbin/reboot"));
 }
 
 void UPowerPowerBackend::suspend()
 {
-    m_interface->call(QStringLiteral("Suspend"));
+    DBusCallCounter::record(QStringLiteral("power"));
+    QDBusConnection::systemBus().asyncCall(methodCall(QStringLiteral("Suspend")));
 }
 
 void UPowerPowerBackend::hibernate()
 {
-    m_interface->call(QStringLiteral("Hibernate"));
+    DBusCallCounter::record(QStringLiteral("power"));
+    QDBusConnection::systemBus().asyncCall(methodCall(QStringLiteral("Hibernate")));
 }
 
 void UPowerPowerBackend::hybridSleep()
 {
 }
+
+QDBusMessage UPowerPowerBackend::methodCall(const QString &method) const
+{
+    return QDBusMessage::createMethodCall(UPOWER_SERVICE, UPOWER_PATH,
+                                          UPOWER_OBJECT, method);
+}
+
+#include "moc_upowerpowerbackend.cpp"
@@ -27,12 +27,13 @@
 #ifndef UPOWERPOWERBACKEND_H
 #define UPOWERPOWERBACKEND_H
 
-#include <QtDBus/QDBusInterface>
+#include <QtDBus/QDBusMessage>
 
 #include "powermanagerbackend.h"
 
 class UPowerPowerBackend : public PowerManagerBackend
 {
+    Q_OBJECT
 public:
     UPowerPowerBackend();
     virtual ~UPowerPowerBackend();
@@ -41,7 +42,7 @@ public:
 
     QString name() const;
 
-    PowerManager::Capabilities capabilities() const;
+    void refreshCapabilities();
 
     void powerOff();
     void restart();
@@ -50,7 +51,9 @@ public:
     void hybridSleep();
 
 private:
-    QDBusInterface *m_interface;
+    quint32 m_generation;
+
+    QDBusMessage methodCall(const QString &method) const;
 };
 
 #endif // UPOWERPOWERBACKEND_H
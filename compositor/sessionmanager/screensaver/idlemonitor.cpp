@@ -0,0 +1,230 @@
+/****************************************************************************
+ * This file is part of Hawaii.
+ *
+ * Copyright (C) 2016 Pier Luigi Fiorini
+ *
+ * Author(s):
+ *    Pier Luigi Fiorini <pierluigi.fiorini@gmail.com>
+ *
+ * $BEGIN_LICENSE:GPL2+$
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * $END_LICENSE$
+ ***************************************************************************/
+
+#include <QtCore/QCoreApplication>
+#include <QtCore/QTimer>
+
+#include "idlemonitor.h"
+#include "screensaver.h"
+
+IdleMonitor::IdleMonitor(QObject *parent)
+    : QObject(parent)
+    , m_lastActivity(0)
+    , m_nextId(1)
+    , m_idle(false)
+    , m_inhibited(false)
+{
+    m_clock.start();
+
+    // A single timer armed for the closest deadline, input
+    // events just take a timestamp and never touch it
+    m_timer = new QTimer(this);
+    m_timer->setSingleShot(true);
+    m_timer->setTimerType(Qt::PreciseTimer);
+    connect(m_timer, &QTimer::timeout,
+            this, &IdleMonitor::timeout);
+
+    // Watch input events delivered to any output window
+    QCoreApplication::instance()->installEventFilter(this);
+}
+
+IdleMonitor::~IdleMonitor()
+{
+    if (QCoreApplication::instance())
+        QCoreApplication::instance()->removeEventFilter(this);
+}
+
+bool IdleMonitor::isIdle() const
+{
+    return m_idle;
+}
+
+bool IdleMonitor::isInhibited() const
+{
+    return m_inhibited;
+}
+
+void IdleMonitor::setInhibited(bool value)
+{
+    if (m_inhibited == value)
+        return;
+
+    m_inhibited = value;
+    Q_EMIT inhibitedChanged(value);
+
+    qCDebug(SCREENSAVER) << "Idle" << (value ? "inhibited" : "uninhibited");
+
+    if (m_inhibited) {
+        m_timer->stop();
+    } else {
+        // Don't go idle right away when the inhibition is lifted
+        m_lastActivity = m_clock.elapsed();
+        arm();
+    }
+}
+
+qint64 IdleMonitor::idleTime() const
+{
+    return m_clock.elapsed() - m_lastActivity;
+}
+
+int IdleMonitor::addThreshold(int timeout)
+{
+    Threshold threshold;
+    threshold.timeout = timeout;
+
+    int id = m_nextId++;
+    m_thresholds.insert(id, threshold);
+    arm();
+
+    return id;
+}
+
+void IdleMonitor::removeThreshold(int id)
+{
+    if (m_thresholds.remove(id) > 0)
+        arm();
+}
+
+void IdleMonitor::setThresholdTimeout(int id, int timeout)
+{
+    if (!m_thresholds.contains(id))
+        return;
+
+    Threshold &threshold = m_thresholds[id];
+    if (threshold.timeout == timeout)
+        return;
+
+    threshold.timeout = timeout;
+    if (threshold.reached && idleTime() < timeout)
+        threshold.reached = false;
+    arm();
+}
+
+void IdleMonitor::simulateUserActivity()
+{
+    activity();
+}
+
+bool IdleMonitor::eventFilter(QObject *object, QEvent *event)
+{
+    switch (event->type()) {
+    case QEvent::KeyPress:
+    case QEvent::KeyRelease:
+    case QEvent::MouseButtonPress:
+    case QEvent::MouseButtonRelease:
+    case QEvent::MouseButtonDblClick:
+    case QEvent::MouseMove:
+    case QEvent::Wheel:
+    case QEvent::TouchBegin:
+    case QEvent::TouchUpdate:
+    case QEvent::TouchEnd:
+    case QEvent::TabletPress:
+    case QEvent::TabletMove:
+    case QEvent::TabletRelease:
+        activity();
+        break;
+    default:
+        break;
+    }
+
+    return QObject::eventFilter(object, event);
+}
+
+void IdleMonitor::activity()
+{
+    m_lastActivity = m_clock.elapsed();
+
+    // Nothing else to do until a threshold is reached, the
+    // timer will notice the new timestamp when it fires
+    if (!m_idle)
+        return;
+
+    QMap<int, Threshold>::iterator it;
+    for (it = m_thresholds.begin(); it != m_thresholds.end(); ++it)
+        it.value().reached = false;
+
+    m_idle = false;
+    Q_EMIT idleChanged(false);
+    Q_EMIT resumed();
+
+    arm();
+}
+
+void IdleMonitor::arm()
+{
+    m_timer->stop();
+
+    if (m_inhibited)
+        return;
+
+    // Find the closest deadline among thresholds not yet reached
+    qint64 deadline = -1;
+    QMap<int, Threshold>::const_iterator it;
+    for (it = m_thresholds.constBegin(); it != m_thresholds.constEnd(); ++it) {
+        if (it.value().reached || it.value().timeout <= 0)
+            continue;
+
+        const qint64 value = m_lastActivity + it.value().timeout;
+        if (deadline < 0 || value < deadline)
+            deadline = value;
+    }
+
+    if (deadline >= 0)
+        m_timer->start(qMax<qint64>(0, deadline - m_clock.elapsed()));
+}
+
+void IdleMonitor::timeout()
+{
+    const qint64 elapsed = idleTime();
+
+    // Signal every threshold that was reached, there might be none
+    // if there was some activity since the timer was armed
+    QList<int> reached;
+    QMap<int, Threshold>::iterator it;
+    for (it = m_thresholds.begin(); it != m_thresholds.end(); ++it) {
+        Threshold &threshold = it.value();
+        if (threshold.reached || threshold.timeout <= 0 || elapsed < threshold.timeout)
+            continue;
+
+        threshold.reached = true;
+        reached.append(it.key());
+    }
+
+    if (!reached.isEmpty() && !m_idle) {
+        m_idle = true;
+        Q_EMIT idleChanged(true);
+    }
+
+    Q_FOREACH (int id, reached) {
+        qCDebug(SCREENSAVER) << "Idle threshold" << id << "reached after" << elapsed << "ms";
+        Q_EMIT thresholdReached(id);
+    }
+
+    arm();
+}
+
+#include "moc_idlemonitor.cpp"
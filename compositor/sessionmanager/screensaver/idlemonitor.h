@@ -0,0 +1,113 @@
+/****************************************************************************
+ * This file is part of Hawaii.
+ *
+ * Copyright (C) 2016 Pier Luigi Fiorini
+ *
+ * Author(s):
+ *    Pier Luigi Fiorini <pierluigi.fiorini@gmail.com>
+ *
+ * $BEGIN_LICENSE:GPL2+$
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * $END_LICENSE$
+ ***************************************************************************/
+
+#ifndef IDLEMONITOR_H
+#define IDLEMONITOR_H
+
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QMap>
+#include <QtCore/QObject>
+
+class QTimer;
+
+class IdleMonitor : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(bool idle READ isIdle NOTIFY idleChanged)
+    Q_PROPERTY(bool inhibited READ isInhibited WRITE setInhibited NOTIFY inhibitedChanged)
+public:
+    IdleMonitor(QObject *parent = Q_NULLPTR);
+    ~IdleMonitor();
+
+    /*!
+     * \brief Idle state.
+     *
+     * Returns whether at least one threshold was reached
+     * since the last user activity.
+     */
+    bool isIdle() const;
+
+    /*!
+     * \brief Inhibition.
+     *
+     * Thresholds are not reached while inhibited, idle time starts
+     * counting again from when the inhibition is lifted.
+     */
+    bool isInhibited() const;
+    void setInhibited(bool value);
+
+    /*!
+     * \brief Idle time.
+     *
+     * Returns the number of milliseconds since the last user activity.
+     */
+    qint64 idleTime() const;
+
+    Q_INVOKABLE int addThreshold(int timeout);
+    Q_INVOKABLE void removeThreshold(int id);
+    Q_INVOKABLE void setThresholdTimeout(int id, int timeout);
+
+    Q_INVOKABLE void simulateUserActivity();
+
+Q_SIGNALS:
+    void idleChanged(bool value);
+    void inhibitedChanged(bool value);
+    void thresholdReached(int threshold);
+    void resumed();
+
+protected:
+    bool eventFilter(QObject *object, QEvent *event) Q_DECL_OVERRIDE;
+
+private:
+    class Threshold
+    {
+    public:
+        Threshold()
+            : timeout(0)
+            , reached(false)
+        {
+        }
+
+        int timeout;
+        bool reached;
+    };
+
+    QElapsedTimer m_clock;
+    qint64 m_lastActivity;
+    QTimer *m_timer;
+    QMap<int, Threshold> m_thresholds;
+    int m_nextId;
+    bool m_idle;
+    bool m_inhibited;
+
+    void activity();
+    void arm();
+
+private Q_SLOTS:
+    void timeout();
+};
+
+#endif // IDLEMONITOR_H
@@ -0,0 +1,125 @@
+/****************************************************************************
+ * This file is part of Hawaii.
+ *
+ * Copyright (C) 2016 Pier Luigi Fiorini
+ *
+ * Author(s):
+ *    Pier Luigi Fiorini <pierluigi.fiorini@gmail.com>
+ *
+ * $BEGIN_LICENSE:GPL2+$
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * $END_LICENSE$
+ ***************************************************************************/
+
+#include <QtCore/QTimer>
+
+#include "renderthrottle.h"
+#include "screensaver.h"
+
+RenderThrottle::RenderThrottle(QObject *parent)
+    : QObject(parent)
+    , m_settings(Q_NULLPTR)
+    , m_locked(false)
+    , m_idle(false)
+    , m_requests(0)
+    , m_throttled(false)
+    , m_maximumFrameRate(10)
+{
+    // Fall back to the default frame rate when the schema is not installed
+    if (Hawaii::QGSettings::isSchemaInstalled(QStringLiteral("org.hawaiios.shell.throttle"))) {
+        m_settings = new Hawaii::QGSettings(QStringLiteral("org.hawaiios.shell.throttle"),
+                                            QStringLiteral("/org/hawaiios/shell/throttle/"),
+                                            this);
+        connect(m_settings, SIGNAL(settingChanged(QString)),
+                this, SLOT(settingChanged(QString)));
+        m_maximumFrameRate = qMax(1, m_settings->value(QStringLiteral("maximumFrameRate")).toInt());
+    }
+
+    m_timer = new QTimer(this);
+    m_timer->setTimerType(Qt::PreciseTimer);
+    m_timer->setInterval(1000 / m_maximumFrameRate);
+    connect(m_timer, &QTimer::timeout,
+            this, &RenderThrottle::frame);
+}
+
+bool RenderThrottle::isThrottled() const
+{
+    return m_throttled;
+}
+
+int RenderThrottle::maximumFrameRate() const
+{
+    return m_maximumFrameRate;
+}
+
+void RenderThrottle::setLocked(bool value)
+{
+    m_locked = value;
+    update();
+}
+
+void RenderThrottle::setIdle(bool value)
+{
+    m_idle = value;
+    update();
+}
+
+void RenderThrottle::acquire()
+{
+    m_requests++;
+    update();
+}
+
+void RenderThrottle::release()
+{
+    m_requests = qMax(0, m_requests - 1);
+    update();
+}
+
+void RenderThrottle::update()
+{
+    const bool throttled = m_locked || m_idle || m_requests > 0;
+    if (m_throttled == throttled)
+        return;
+
+    m_throttled = throttled;
+
+    qCDebug(SCREENSAVER) << "Rendering" << (m_throttled ? "throttled to" : "no longer throttled to")
+                         << m_maximumFrameRate << "fps";
+
+    if (m_throttled)
+        m_timer->start();
+    else
+        m_timer->stop();
+
+    Q_EMIT throttledChanged(m_throttled);
+}
+
+void RenderThrottle::settingChanged(const QString &key)
+{
+    if (key != QStringLiteral("maximumFrameRate"))
+        return;
+
+    const int value = qMax(1, m_settings->value(key).toInt());
+    if (m_maximumFrameRate == value)
+        return;
+
+    m_maximumFrameRate = value;
+    m_timer->setInterval(1000 / m_maximumFrameRate);
+    Q_EMIT maximumFrameRateChanged(m_maximumFrameRate);
+}
+
+#include "moc_renderthrottle.cpp"
@@ -0,0 +1,88 @@
+/****************************************************************************
+ * This file is part of Hawaii.
+ *
+ * Copyright (C) 2016 Pier Luigi Fiorini
+ *
+ * Author(s):
+ *    Pier Luigi Fiorini <pierluigi.fiorini@gmail.com>
+ *
+ * $BEGIN_LICENSE:GPL2+$
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * $END_LICENSE$
+ ***************************************************************************/
+
+#ifndef RENDERTHROTTLE_H
+#define RENDERTHROTTLE_H
+
+#include <QtCore/QObject>
+
+#include <Hawaii/GSettings/QGSettings>
+
+class QTimer;
+
+class RenderThrottle : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(bool throttled READ isThrottled NOTIFY throttledChanged)
+    Q_PROPERTY(int maximumFrameRate READ maximumFrameRate NOTIFY maximumFrameRateChanged)
+public:
+    RenderThrottle(QObject *parent = Q_NULLPTR);
+
+    /*!
+     * \brief Throttled state.
+     *
+     * Rendering is throttled while the session is locked or idle
+     * and while at least one client asked for it.
+     */
+    bool isThrottled() const;
+
+    int maximumFrameRate() const;
+
+    void setLocked(bool value);
+    void setIdle(bool value);
+
+    void acquire();
+    void release();
+
+Q_SIGNALS:
+    void throttledChanged(bool value);
+    void maximumFrameRateChanged(int value);
+
+    /*!
+     * \brief Frame tick.
+     *
+     * Emitted at the maximum frame rate while throttled, outputs
+     * send frame callbacks to clients on this tick instead of
+     * after each frame is rendered.
+     */
+    void frame();
+
+private:
+    Hawaii::QGSettings *m_settings;
+    QTimer *m_timer;
+    bool m_locked;
+    bool m_idle;
+    int m_requests;
+    bool m_throttled;
+    int m_maximumFrameRate;
+
+    void update();
+
+private Q_SLOTS:
+    void settingChanged(const QString &key);
+};
+
+#endif // RENDERTHROTTLE_H
@@ -24,8 +24,14 @@
  * $END_LICENSE$
  ***************************************************************************/
 
+#include <QtCore/QTimer>
 #include <QtDBus/QDBusConnection>
+#include <QtDBus/QDBusConnectionInterface>
 #include <QtDBus/QDBusError>
+#include <QtDBus/QDBusMetaType>
+#include <QtDBus/QDBusPendingCallWatcher>
+#include <QtDBus/QDBusPendingReply>
+#include <QtDBus/QDBusServiceWatcher>
 
 #include "screensaver.h"
 #include "sessionmanager/sessionmanager.h"
@@ -36,7 +42,21 @@ ScreenSaver::ScreenSaver(QObject *parent)
     : QObject(parent)
     , m_active(false)
     , m_sessionManager(qobject_cast<SessionManager *>(parent))
+    , m_nextCookie(1)
+    , m_watcher(new QDBusServiceWatcher(this))
 {
+    qDBusRegisterMetaType<QList<QVariantMap> >();
+
+    // Release inhibitors when the application that asked
+    // for them leaves the bus, for example if it crashes
+    m_watcher->setConnection(QDBusConnection::sessionBus());
+    m_watcher->setWatchMode(QDBusServiceWatcher::WatchForUnregistration);
+    connect(m_watcher, &QDBusServiceWatcher::serviceUnregistered,
+            this, &ScreenSaver::senderVanished);
+
+    // The screen saver is active while the session is idle
+    connect(m_sessionManager, &SessionManager::idleChanged,
+            this, &ScreenSaver::setActive);
 }
 
 ScreenSaver::~ScreenSaver()
@@ -60,36 +80,34 @@ bool ScreenSaver::SetActive(bool state)
 
 uint ScreenSaver::GetActiveTime()
 {
-    return 0;
+    if (!m_active)
+        return 0;
+    return m_activeTimer.elapsed() / 1000;
 }
 
 uint ScreenSaver::GetSessionIdleTime()
 {
-    return 0;
+    return m_sessionManager->idleMonitor()->idleTime() / 1000;
 }
 
 void ScreenSaver::SimulateUserActivity()
 {
+    m_sessionManager->idleMonitor()->simulateUserActivity();
 }
 
 uint ScreenSaver::Inhibit(const QString &appName, const QString &reason)
 {
-    Q_UNUSED(appName)
-    Q_UNUSED(reason)
-
-    static uint cookieSeed = 0;
-    int newCookie = cookieSeed++;
-
-    Q_EMIT m_sessionManager->idleInhibitRequested();
-
-    return newCookie;
+    return addInhibitor(Inhibitor::Idle, appName, reason);
 }
 
 void ScreenSaver::UnInhibit(uint cookie)
 {
-    Q_UNUSED(cookie)
+    if (m_inhibitors.value(cookie).kind != Inhibitor::Idle) {
+        qCWarning(SCREENSAVER) << "Cannot uninhibit unknown cookie" << cookie;
+        return;
+    }
 
-    m_sessionManager->idleUninhibitRequested();
+    releaseInhibitor(cookie);
 }
 
 void ScreenSaver::Lock()
@@ -99,16 +117,151 @@ void ScreenSaver::Lock()
 
 uint ScreenSaver::Throttle(const QString &appName, const QString &reason)
 {
-    // TODO:
-    Q_UNUSED(appName);
-    Q_UNUSED(reason);
-    return 0;
+    return addInhibitor(Inhibitor::Throttle, appName, reason);
 }
 
 void ScreenSaver::UnThrottle(uint cookie)
 {
-    // TODO:
-    Q_UNUSED(cookie);
+    if (m_inhibitors.value(cookie).kind != Inhibitor::Throttle) {
+        qCWarning(SCREENSAVER) << "Cannot unthrottle unknown cookie" << cookie;
+        return;
+    }
+
+    releaseInhibitor(cookie);
+}
+
+QList<QVariantMap> ScreenSaver::ListInhibitors()
+{
+    QList<QVariantMap> list;
+
+    Q_FOREACH (const Inhibitor &inhibitor, m_inhibitors) {
+        QVariantMap map;
+        map.insert(QStringLiteral("cookie"), inhibitor.cookie);
+        map.insert(QStringLiteral("kind"), inhibitor.kind == Inhibitor::Throttle
+                   ? QStringLiteral("throttle") : QStringLiteral("idle"));
+        map.insert(QStringLiteral("applicationName"), inhibitor.appName);
+        map.insert(QStringLiteral("reason"), inhibitor.reason);
+        map.insert(QStringLiteral("sender"), inhibitor.sender);
+        map.insert(QStringLiteral("timestamp"), inhibitor.timestamp.toMSecsSinceEpoch() / 1000);
+        list.append(map);
+    }
+
+    return list;
+}
+
+uint ScreenSaver::addInhibitor(Inhibitor::Kind kind, const QString &appName, const QString &reason)
+{
+    Inhibitor inhibitor;
+    inhibitor.kind = kind;
+    inhibitor.cookie = m_nextCookie++;
+    inhibitor.appName = appName;
+    inhibitor.reason = reason;
+    inhibitor.timestamp = QDateTime::currentDateTimeUtc();
+    if (calledFromDBus())
+        inhibitor.sender = message().service();
+
+    m_inhibitors.insert(inhibitor.cookie, inhibitor);
+
+    if (!inhibitor.sender.isEmpty()) {
+        // Watch each sender only once, registration is deferred so that
+        // a burst of requests results in a single round of match rules
+        if (!m_senderCookies.contains(inhibitor.sender)) {
+            if (m_pendingWatches.isEmpty())
+                QTimer::singleShot(0, this, SLOT(watchPendingSenders()));
+            m_pendingWatches.insert(inhibitor.sender);
+        }
+        m_senderCookies.insert(inhibitor.sender, inhibitor.cookie);
+    }
+
+    if (kind == Inhibitor::Throttle) {
+        qCDebug(SCREENSAVER) << "Throttle requested by" << appName
+                             << "with cookie" << inhibitor.cookie
+                             << "and reason" << reason;
+
+        m_sessionManager->renderThrottle()->acquire();
+    } else {
+        qCDebug(SCREENSAVER) << "Inhibit requested by" << appName
+                             << "with cookie" << inhibitor.cookie
+                             << "and reason" << reason;
+
+        Q_EMIT m_sessionManager->idleInhibitRequested();
+    }
+
+    return inhibitor.cookie;
+}
+
+void ScreenSaver::releaseInhibitor(uint cookie)
+{
+    const Inhibitor inhibitor = m_inhibitors.take(cookie);
+
+    if (!inhibitor.sender.isEmpty()) {
+        m_senderCookies.remove(inhibitor.sender, cookie);
+        if (!m_senderCookies.contains(inhibitor.sender)) {
+            if (!m_pendingWatches.remove(inhibitor.sender))
+                m_watcher->removeWatchedService(inhibitor.sender);
+        }
+    }
+
+    qCDebug(SCREENSAVER) << "Released inhibitor" << cookie
+                         << "of" << inhibitor.appName;
+
+    if (inhibitor.kind == Inhibitor::Throttle)
+        m_sessionManager->renderThrottle()->release();
+    else
+        Q_EMIT m_sessionManager->idleUninhibitRequested();
+}
+
+void ScreenSaver::watchPendingSenders()
+{
+    if (m_pendingWatches.isEmpty())
+        return;
+
+    // Only add new senders, replacing the whole list would remove
+    // and add again the match rules of those already watched
+    Q_FOREACH (const QString &sender, m_pendingWatches)
+        m_watcher->addWatchedService(sender);
+
+    // Senders might have left the bus before the watch was installed,
+    // unique names are never reused so ask if they are still there
+    QDBusConnectionInterface *iface = QDBusConnection::sessionBus().interface();
+    Q_FOREACH (const QString &sender, m_pendingWatches) {
+        QDBusPendingCall call = iface->asyncCall(QStringLiteral("NameHasOwner"), sender);
+        QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(call, this);
+        connect(watcher, &QDBusPendingCallWatcher::finished, this, [this, sender](QDBusPendingCallWatcher *self) {
+            QDBusPendingReply<bool> reply = *self;
+            if (reply.isValid() && !reply.value())
+                senderVanished(sender);
+            self->deleteLater();
+        });
+    }
+
+    m_pendingWatches.clear();
+}
+
+void ScreenSaver::senderVanished(const QString &service)
+{
+    const QList<uint> cookies = m_senderCookies.values(service);
+    if (cookies.isEmpty())
+        return;
+
+    qCInfo(SCREENSAVER) << service << "left the bus, releasing"
+                        << cookies.size() << "inhibitor(s)";
+
+    Q_FOREACH (uint cookie, cookies)
+        releaseInhibitor(cookie);
+}
+
+void ScreenSaver::setActive(bool value)
+{
+    if (m_active == value)
+        return;
+
+    m_active = value;
+    if (m_active)
+        m_activeTimer.start();
+    else
+        m_activeTimer.invalidate();
+    Q_EMIT ActiveChanged(m_active);
 }
 
 #include "moc_screensaver.cpp"
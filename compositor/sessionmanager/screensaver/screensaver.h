@@ -27,14 +27,22 @@
 #ifndef SCREENSAVER_H
 #define SCREENSAVER_H
 
+#include <QtCore/QDateTime>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QHash>
 #include <QtCore/QObject>
 #include <QtCore/QLoggingCategory>
+#include <QtCore/QSet>
+#include <QtCore/QVariantMap>
+#include <QtDBus/QDBusContext>
 
 Q_DECLARE_LOGGING_CATEGORY(SCREENSAVER)
 
+class QDBusServiceWatcher;
+
 class SessionManager;
 
-class ScreenSaver : public QObject
+class ScreenSaver : public QObject, protected QDBusContext
 {
     Q_OBJECT
 public:
@@ -57,12 +65,52 @@ public:
     uint Throttle(const QString &appName, const QString &reason);
     void UnThrottle(uint cookie);
 
+    QList<QVariantMap> ListInhibitors();
+
 Q_SIGNALS:
     void ActiveChanged(bool in);
 
 private:
+    class Inhibitor
+    {
+    public:
+        enum Kind {
+            Unknown = 0,
+            Idle,
+            Throttle
+        };
+
+        Inhibitor()
+            : kind(Unknown)
+            , cookie(0)
+        {
+        }
+
+        Kind kind;
+        uint cookie;
+        QString appName;
+        QString reason;
+        QString sender;
+        QDateTime timestamp;
+    };
+
     bool m_active;
+    QElapsedTimer m_activeTimer;
     SessionManager *m_sessionManager;
+
+    uint m_nextCookie;
+    QHash<uint, Inhibitor> m_inhibitors;
+    QMultiHash<QString, uint> m_senderCookies;
+    QDBusServiceWatcher *m_watcher;
+    QSet<QString> m_pendingWatches;
+
+    uint addInhibitor(Inhibitor::Kind kind, const QString &appName, const QString &reason);
+    void releaseInhibitor(uint cookie);
+
+private Q_SLOTS:
+    void setActive(bool value);
+    void watchPendingSenders();
+    void senderVanished(const QString &service);
 };
 
 #endif // SCREENSAVER_H
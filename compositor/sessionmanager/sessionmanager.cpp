@@ -31,17 +31,22 @@
 
 #include "authenticator.h"
 #include "cmakedirs.h"
+#include "dbuscallcounter.h"
 #include "loginmanager/loginmanager.h"
 #include "powermanager/powermanager.h"
 #include "sessionmanager.h"
 #include "sessionmanager/screensaver/screensaver.h"
 #include "sessionmanager/screensaver/screensaveradaptor.h"
+#include "sessionmanager/screensaver/hawaiiscreensaveradaptor.h"
 
 #include <sys/types.h>
 #include <signal.h>
 
 Q_LOGGING_CATEGORY(SESSION_MANAGER, "hawaii.session.manager")
 
+// Well below logind's default InhibitDelayMaxSec of 5 seconds
+static const int lockScreenTimeoutInterval = 2000;
+
 /*
  * CustomAuthenticator
  */
@@ -98,9 +103,16 @@ SessionManager::SessionManager(QObject *parent)
     , m_authenticator(new Authenticator)
     , m_loginManager(new LoginManager(this, this))
     , m_powerManager(new PowerManager(this))
+    , m_idleMonitor(new IdleMonitor(this))
+    , m_renderThrottle(new RenderThrottle(this))
     , m_screenSaver(new ScreenSaver(this))
     , m_idle(false)
     , m_locked(false)
+    , m_lockScreenTimer(new QTimer(this))
+    , m_suspending(false)
+    , m_resuming(false)
+    , m_suspendPrepareTime(-1)
+    , m_resumeTime(-1)
 {
     // Lock and unlock the session
     connect(m_loginManager, &LoginManager::sessionLocked, this, [this] {
@@ -110,10 +122,35 @@ SessionManager::SessionManager(QObject *parent)
         setLocked(false);
     });
 
+    // Hold the system from sleeping until the lock screen is
+    // rendered, but not longer than logind would wait for us
+    m_lockScreenTimer->setSingleShot(true);
+    m_lockScreenTimer->setInterval(lockScreenTimeoutInterval);
+    connect(m_lockScreenTimer, &QTimer::timeout,
+            this, &SessionManager::lockScreenTimeout);
+    connect(m_loginManager, &LoginManager::preparingForSleep,
+            this, &SessionManager::prepareForSleep);
+
+    // Render at a lower rate while nobody is looking
+    connect(this, &SessionManager::lockedChanged,
+            m_renderThrottle, &RenderThrottle::setLocked);
+    connect(this, &SessionManager::idleChanged,
+            m_renderThrottle, &RenderThrottle::setIdle);
+
+    // Power capabilities are fetched asynchronously
+    connect(m_powerManager, &PowerManager::capabilitiesChanged,
+            this, &SessionManager::capabilitiesChanged);
+
     // Logout session before the system goes off
     connect(m_loginManager, &LoginManager::logOutRequested,
             this, &SessionManager::logOut);
 
+    // Relay PAM prompts and messages to the lock screen
+    connect(m_authenticator, &Authenticator::prompt,
+            this, &SessionManager::authenticationPrompt);
+    connect(m_authenticator, &Authenticator::message,
+            this, &SessionManager::authenticationMessage);
+
     // Authenticate in a separate thread
     m_authenticator->moveToThread(m_authenticatorThread);
     m_authenticatorThread->start();
@@ -121,6 +158,9 @@ SessionManager::SessionManager(QObject *parent)
 
 SessionManager::~SessionManager()
 {
+    // Unblock a conversation waiting for the user
+    m_authenticator->setEnabled(false);
+
     m_authenticatorThread->quit();
     m_authenticatorThread->wait();
     m_authenticator->deleteLater();
@@ -131,6 +171,7 @@ bool SessionManager::registerWithDBus()
     QDBusConnection bus = QDBusConnection::sessionBus();
 
     new ScreenSaverAdaptor(m_screenSaver);
+    new HawaiiScreenSaverAdaptor(m_screenSaver);
     if (!bus.registerObject(QStringLiteral("/org/freedesktop/ScreenSaver"), m_screenSaver)) {
         qCWarning(SESSION_MANAGER,
                   "Couldn't register /org/freedesktop/ScreenSaver D-Bus object: %s",
@@ -161,6 +202,16 @@ bool SessionManager::isLocked() const
     return m_locked;
 }
 
+IdleMonitor *SessionManager::idleMonitor() const
+{
+    return m_idleMonitor;
+}
+
+RenderThrottle *SessionManager::renderThrottle() const
+{
+    return m_renderThrottle;
+}
+
 void SessionManager::setLocked(bool value)
 {
     if (m_locked == value)
@@ -169,10 +220,20 @@ void SessionManager::setLocked(bool value)
     m_locked = value;
     Q_EMIT lockedChanged(value);
 
+    // Start talking to PAM as soon as the lock screen shows up,
+    // so that unlocking only waits for the password check
+    m_authenticator->setEnabled(value);
     if (value)
+        m_authenticator->start();
+
+    if (value) {
         Q_EMIT sessionLocked();
-    else
+    } else {
+        // Take the sleep inhibitor again, it was
+        // released when the system went to sleep
+        m_loginManager->unlocked();
         Q_EMIT sessionUnlocked();
+    }
 }
 
 bool SessionManager::canLock() const
@@ -221,6 +282,19 @@ bool SessionManager::canHybridSleep()
     return m_powerManager->capabilities() & PowerManager::HybridSleep;
 }
 
+QVariantMap SessionManager::dbusCallCounters() const
+{
+    return DBusCallCounter::counters();
+}
+
+QVariantMap SessionManager::sleepTimings() const
+{
+    QVariantMap timings;
+    timings.insert(QStringLiteral("suspendPrepare"), m_suspendPrepareTime);
+    timings.insert(QStringLiteral("resumeToFirstFrame"), m_resumeTime);
+    return timings;
+}
+
 void SessionManager::logOut()
 {
     // Exit
@@ -259,12 +333,33 @@ void SessionManager::lockSession()
 
 void SessionManager::unlockSession(const QString &password, const QJSValue &callback)
 {
-    if (m_authRequested)
-        return;
+    // Following calls answer further prompts of the same conversation
+    if (!m_authRequested) {
+        (void)new CustomAuthenticator(this, callback);
+        m_authRequested = true;
+    }
+
+    m_authenticator->respond(password);
+    m_authenticator->start();
+}
+
+void SessionManager::lockScreenRendered()
+{
+    if (m_suspending) {
+        m_suspending = false;
+        m_lockScreenTimer->stop();
+        m_suspendPrepareTime = m_sleepTimer.elapsed();
+        qCInfo(SESSION_MANAGER) << "Lock screen rendered" << m_suspendPrepareTime
+                                << "ms after the system asked to sleep";
 
-    (void)new CustomAuthenticator(this, callback);
-    QMetaObject::invokeMethod(m_authenticator, "authenticate", Q_ARG(QString, password));
-    m_authRequested = true;
+        // Now the system can go to sleep
+        m_loginManager->locked();
+    } else if (m_resuming) {
+        m_resuming = false;
+        m_resumeTime = m_sleepTimer.elapsed();
+        qCInfo(SESSION_MANAGER) << "Lock screen rendered" << m_resumeTime
+                                << "ms after resume";
+    }
 }
 
 void SessionManager::startNewSession()
@@ -325,4 +420,31 @@ void SessionManager::cancelShutdownRequest()
     Q_EMIT shutdownRequestCanceled();
 }
 
+void SessionManager::prepareForSleep(bool active)
+{
+    m_sleepTimer.start();
+    m_suspending = active;
+    m_resuming = !active;
+
+    if (active)
+        m_lockScreenTimer->start();
+    else
+        m_lockScreenTimer->stop();
+
+    Q_EMIT lockScreenFrameRequested();
+}
+
+void SessionManager::lockScreenTimeout()
+{
+    if (!m_suspending)
+        return;
+
+    m_suspending = false;
+    m_suspendPrepareTime = m_sleepTimer.elapsed();
+    qCWarning(SESSION_MANAGER) << "Lock screen not rendered after"
+                               << m_suspendPrepareTime << "ms, going to sleep anyway";
+
+    m_loginManager->locked();
+}
+
 #include "moc_sessionmanager.cpp"
@@ -27,11 +27,16 @@
 #ifndef SESSIONMANAGER_H
 #define SESSIONMANAGER_H
 
+#include <QtCore/QElapsedTimer>
 #include <QtCore/QObject>
 #include <QtCore/QLoggingCategory>
 #include <QtCore/QThread>
+#include <QtCore/QVariantMap>
 #include <QtQml/QJSValue>
 
+#include "screensaver/idlemonitor.h"
+#include "screensaver/renderthrottle.h"
+
 Q_DECLARE_LOGGING_CATEGORY(SESSION_MANAGER)
 
 class Authenticator;
@@ -40,19 +45,23 @@ class LoginManager;
 class PowerManager;
 class ScreenSaver;
 
+class QTimer;
+
 class SessionManager : public QObject
 {
     Q_OBJECT
     Q_PROPERTY(bool idle READ isIdle WRITE setIdle NOTIFY idleChanged)
     Q_PROPERTY(bool locked READ isLocked NOTIFY lockedChanged)
     Q_PROPERTY(bool canLock READ canLock CONSTANT)
+    Q_PROPERTY(IdleMonitor *idleMonitor READ idleMonitor CONSTANT)
+    Q_PROPERTY(RenderThrottle *renderThrottle READ renderThrottle CONSTANT)
     Q_PROPERTY(bool canStartNewSession READ canStartNewSession CONSTANT)
     Q_PROPERTY(bool canLogOut READ canLogOut CONSTANT)
-    Q_PROPERTY(bool canPowerOff READ canPowerOff CONSTANT)
-    Q_PROPERTY(bool canRestart READ canRestart CONSTANT)
-    Q_PROPERTY(bool canSuspend READ canSuspend CONSTANT)
-    Q_PROPERTY(bool canHibernate READ canHibernate CONSTANT)
-    Q_PROPERTY(bool canHybridSleep READ canHybridSleep CONSTANT)
+    Q_PROPERTY(bool canPowerOff READ canPowerOff NOTIFY capabilitiesChanged)
+    Q_PROPERTY(bool canRestart READ canRestart NOTIFY capabilitiesChanged)
+    Q_PROPERTY(bool canSuspend READ canSuspend NOTIFY capabilitiesChanged)
+    Q_PROPERTY(bool canHibernate READ canHibernate NOTIFY capabilitiesChanged)
+    Q_PROPERTY(bool canHybridSleep READ canHybridSleep NOTIFY capabilitiesChanged)
 public:
     SessionManager(QObject *parent = Q_NULLPTR);
     virtual ~SessionManager();
@@ -64,6 +73,9 @@ public:
 
     bool isLocked() const;
 
+    IdleMonitor *idleMonitor() const;
+    RenderThrottle *renderThrottle() const;
+
     bool canLock() const;
     bool canStartNewSession();
     bool canLogOut();
@@ -73,13 +85,34 @@ public:
     bool canHibernate();
     bool canHybridSleep();
 
+    Q_INVOKABLE QVariantMap dbusCallCounters() const;
+
+    /*!
+     * \brief Sleep timings.
+     *
+     * Returns a map with the time it took to show the lock screen
+     * on all outputs after the system asked to sleep
+     * ("suspendPrepare") and to render the first lock screen
+     * frame after resume ("resumeToFirstFrame"), both in
+     * milliseconds and -1 when unknown.
+     */
+    Q_INVOKABLE QVariantMap sleepTimings() const;
+
 Q_SIGNALS:
     void idleChanged(bool value);
     void lockedChanged(bool value);
+    void capabilitiesChanged();
 
     void sessionLocked();
     void sessionUnlocked();
 
+    // The shell should call lockScreenRendered() as soon as the
+    // lock screen has been rendered on all outputs
+    void lockScreenFrameRequested();
+
+    void authenticationPrompt(const QString &message, bool secret);
+    void authenticationMessage(const QString &text, bool error);
+
     void loggedOut();
 
     void idleInhibitRequested();
@@ -103,6 +136,7 @@ public Q_SLOTS:
 
     void lockSession();
     void unlockSession(const QString &password, const QJSValue &callback);
+    void lockScreenRendered();
     void startNewSession();
     void activateSession(int index);
 
@@ -121,14 +155,27 @@ private:
 
     LoginManager *m_loginManager;
     PowerManager *m_powerManager;
+    IdleMonitor *m_idleMonitor;
+    RenderThrottle *m_renderThrottle;
     ScreenSaver *m_screenSaver;
     QList<qint64> m_processes;
 
     bool m_idle;
     bool m_locked;
 
+    QTimer *m_lockScreenTimer;
+    QElapsedTimer m_sleepTimer;
+    bool m_suspending;
+    bool m_resuming;
+    qint64 m_suspendPrepareTime;
+    qint64 m_resumeTime;
+
     void setLocked(bool value);
 
+private Q_SLOTS:
+    void prepareForSleep(bool active);
+    void lockScreenTimeout();
+
     friend class CustomAuthenticator;
 };
 
@@ -0,0 +1,170 @@
+/****************************************************************************
+ * This file is part of Hawaii.
+ *
+ * Copyright (C) 2016 Pier Luigi Fiorini
+ *
+ * Author(s):
+ *    Pier Luigi Fiorini <pierluigi.fiorini@gmail.com>
+ *
+ * $BEGIN_LICENSE:LGPL2.1+$
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * $END_LICENSE$
+ ***************************************************************************/
+
+#include <QtCore/QCoreApplication>
+#include <QtCore/QDir>
+#include <QtCore/QDirIterator>
+#include <QtCore/QFileSystemWatcher>
+#include <QtCore/QSettings>
+#include <QtCore/QStandardPaths>
+#include <QtCore/QThread>
+
+#include "desktopentryiconresolver.h"
+
+Q_LOGGING_CATEGORY(DESKTOPENTRY, "hawaii.qml.desktopentry")
+
+DesktopEntryIconResolver::DesktopEntryIconResolver(QObject *parent)
+    : QObject(parent)
+    , m_watcher(new QFileSystemWatcher(this))
+{
+    watchDirectories();
+
+    connect(m_watcher, SIGNAL(directoryChanged(QString)),
+            this, SLOT(invalidate()));
+    connect(m_watcher, SIGNAL(fileChanged(QString)),
+            this, SLOT(invalidate()));
+}
+
+static DesktopEntryIconResolver *createInstance()
+{
+    // Lives as long as the application and in its thread, so that
+    // the watcher delivers notifications no matter who asks
+    DesktopEntryIconResolver *resolver = new DesktopEntryIconResolver();
+    if (QCoreApplication::instance()) {
+        resolver->moveToThread(QCoreApplication::instance()->thread());
+        resolver->setParent(QCoreApplication::instance());
+    }
+    return resolver;
+}
+
+DesktopEntryIconResolver *DesktopEntryIconResolver::instance()
+{
+    static DesktopEntryIconResolver *resolver = createInstance();
+    return resolver;
+}
+
+QString DesktopEntryIconResolver::iconName(const QString &desktopEntry)
+{
+    if (desktopEntry.isEmpty())
+        return QString();
+
+    // Specifications say the hint doesn't have the suffix,
+    // but some applications add it anyway
+    QString name = desktopEntry;
+    if (!name.endsWith(QStringLiteral(".desktop")))
+        name += QStringLiteral(".desktop");
+
+    {
+        QMutexLocker locker(&m_mutex);
+        QHash<QString, QString>::const_iterator it = m_iconNames.constFind(name);
+        if (it != m_iconNames.constEnd())
+            return it.value();
+    }
+
+    const QString fileName = QStandardPaths::locate(QStandardPaths::ApplicationsLocation, name);
+    QString iconName;
+    if (!fileName.isEmpty()) {
+        QSettings desktopFile(fileName, QSettings::IniFormat);
+        desktopFile.setIniCodec("UTF-8");
+        desktopFile.beginGroup(QStringLiteral("Desktop Entry"));
+        iconName = desktopFile.value(QStringLiteral("Icon")).toString();
+        desktopFile.endGroup();
+
+        watch(fileName);
+    }
+
+    qCDebug(DESKTOPENTRY) << "Resolved" << name << "to icon" << iconName;
+
+    // Cache misses too, otherwise unknown entries would always hit the disk
+    QMutexLocker locker(&m_mutex);
+    m_iconNames.insert(name, iconName);
+    return iconName;
+}
+
+void DesktopEntryIconResolver::watch(const QString &fileName)
+{
+    // The watcher belongs to the application thread
+    QMetaObject::invokeMethod(this, "addWatchedPath",
+                              QThread::currentThread() == thread()
+                              ? Qt::DirectConnection : Qt::QueuedConnection,
+                              Q_ARG(QString, fileName));
+}
+
+void DesktopEntryIconResolver::watchDirectories()
+{
+    // Applications installed or removed might change the resolution
+    // of any cached entry, including those that were not found;
+    // entries can live in subdirectories too (e.g. kde4/)
+    const QStringList watched = m_watcher->directories();
+    QStringList paths;
+
+    Q_FOREACH (const QString &path, QStandardPaths::standardLocations(QStandardPaths::ApplicationsLocation)) {
+        if (!QDir(path).exists())
+            continue;
+
+        if (!watched.contains(path))
+            paths.append(path);
+
+        QDirIterator it(path, QDir::Dirs | QDir::NoDotAndDotDot,
+                        QDirIterator::Subdirectories | QDirIterator::FollowSymlinks);
+        while (it.hasNext()) {
+            const QString subdir = it.next();
+            if (!watched.contains(subdir) && !paths.contains(subdir))
+                paths.append(subdir);
+        }
+    }
+
+    if (!paths.isEmpty())
+        m_watcher->addPaths(paths);
+}
+
+void DesktopEntryIconResolver::addWatchedPath(const QString &fileName)
+{
+    if (!m_watcher->files().contains(fileName))
+        m_watcher->addPath(fileName);
+}
+
+void DesktopEntryIconResolver::invalidate()
+{
+    qCDebug(DESKTOPENTRY) << "Applications changed, invalidating icon names";
+
+    {
+        QMutexLocker locker(&m_mutex);
+        m_iconNames.clear();
+    }
+
+    // Stop watching files, entries will be watched again when resolved
+    const QStringList files = m_watcher->files();
+    if (!files.isEmpty())
+        m_watcher->removePaths(files);
+
+    // Pick up subdirectories that were just created
+    watchDirectories();
+
+    Q_EMIT iconNamesChanged();
+}
+
+#include "moc_desktopentryiconresolver.cpp"
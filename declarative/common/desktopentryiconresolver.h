@@ -0,0 +1,67 @@
+/****************************************************************************
+ * This file is part of Hawaii.
+ *
+ * Copyright (C) 2016 Pier Luigi Fiorini
+ *
+ * Author(s):
+ *    Pier Luigi Fiorini <pierluigi.fiorini@gmail.com>
+ *
+ * $BEGIN_LICENSE:LGPL2.1+$
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * $END_LICENSE$
+ ***************************************************************************/
+
+#ifndef DESKTOPENTRYICONRESOLVER_H
+#define DESKTOPENTRYICONRESOLVER_H
+
+#include <QtCore/QHash>
+#include <QtCore/QLoggingCategory>
+#include <QtCore/QMutex>
+#include <QtCore/QObject>
+
+#include "hawaiideclarativecommon_export.h"
+
+class QFileSystemWatcher;
+
+Q_DECLARE_LOGGING_CATEGORY(DESKTOPENTRY)
+
+class HAWAIIDECLARATIVECOMMON_EXPORT DesktopEntryIconResolver : public QObject
+{
+    Q_OBJECT
+public:
+    DesktopEntryIconResolver(QObject *parent = 0);
+
+    static DesktopEntryIconResolver *instance();
+
+    QString iconName(const QString &desktopEntry);
+
+Q_SIGNALS:
+    void iconNamesChanged();
+
+private:
+    QMutex m_mutex;
+    QHash<QString, QString> m_iconNames;
+    QFileSystemWatcher *m_watcher;
+
+    void watch(const QString &fileName);
+    void watchDirectories();
+
+private Q_SLOTS:
+    void addWatchedPath(const QString &fileName);
+    void invalidate();
+};
+
+#endif // DESKTOPENTRYICONRESOLVER_H
@@ -0,0 +1,66 @@
+/****************************************************************************
+ * This file is part of Hawaii.
+ *
+ * Copyright (C) 2016 Pier Luigi Fiorini
+ *
+ * Author(s):
+ *    Pier Luigi Fiorini <pierluigi.fiorini@gmail.com>
+ *
+ * $BEGIN_LICENSE:LGPL2.1+$
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * $END_LICENSE$
+ ***************************************************************************/
+
+#include <QtQml/QtQml>
+
+#include "windowsmodel.h"
+#include "windowsproxymodel.h"
+#include "windowthumbnails.h"
+#include "windowthumbnailsimageprovider.h"
+
+static QObject *windowThumbnailsProvider(QQmlEngine *engine, QJSEngine *jsEngine)
+{
+    Q_UNUSED(engine);
+    Q_UNUSED(jsEngine);
+
+    return new WindowThumbnails();
+}
+
+class CompositorPlugin : public QQmlExtensionPlugin
+{
+    Q_OBJECT
+    Q_PLUGIN_METADATA(IID "org.qt-project.Qt.QQmlExtensionInterface")
+public:
+    void initializeEngine(QQmlEngine *engine, const char *uri)
+    {
+        Q_ASSERT(uri == QLatin1String("org.hawaiios.compositor"));
+
+        engine->addImageProvider(QStringLiteral("windowthumbnails"), new WindowThumbnailsImageProvider());
+    }
+
+    void registerTypes(const char *uri)
+    {
+        // @uri org.hawaiios.compositor
+        Q_ASSERT(uri == QLatin1String("org.hawaiios.compositor"));
+
+        qmlRegisterType<WindowsModel>(uri, 0, 1, "WindowsModel");
+        qmlRegisterType<WindowsProxyModel>(uri, 0, 1, "WindowsProxyModel");
+        qmlRegisterSingletonType<WindowThumbnails>(uri, 0, 1, "WindowThumbnails",
+                                                   windowThumbnailsProvider);
+    }
+};
+
+#include "plugin.moc"
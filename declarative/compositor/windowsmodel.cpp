@@ -0,0 +1,301 @@
+/****************************************************************************
+ * This file is part of Hawaii.
+ *
+ * Copyright (C) 2016 Pier Luigi Fiorini
+ *
+ * Author(s):
+ *    Pier Luigi Fiorini <pierluigi.fiorini@gmail.com>
+ *
+ * $BEGIN_LICENSE:LGPL2.1+$
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * $END_LICENSE$
+ ***************************************************************************/
+
+#include <GreenIsland/QtWaylandCompositor/QWaylandOutput>
+#include <GreenIsland/QtWaylandCompositor/QWaylandSurface>
+
+#include "windowsmodel.h"
+
+class WindowEntry
+{
+public:
+    WindowEntry()
+        : window(Q_NULLPTR)
+        , surface(Q_NULLPTR)
+        , position(-1)
+        , workspace(0)
+    {
+    }
+
+    ClientWindow *window;
+    QWaylandSurface *surface;
+    int position;
+    int workspace;
+};
+
+WindowsModel::WindowsModel(QObject *parent)
+    : QAbstractListModel(parent)
+    , m_validPositions(0)
+{
+}
+
+WindowsModel::~WindowsModel()
+{
+    qDeleteAll(m_entries);
+}
+
+int WindowsModel::count() const
+{
+    return m_entries.size();
+}
+
+QHash<int, QByteArray> WindowsModel::roleNames() const
+{
+    QHash<int, QByteArray> roles;
+    roles.insert(WindowRole, "window");
+    roles.insert(TitleRole, "title");
+    roles.insert(AppIdRole, "appId");
+    roles.insert(IconNameRole, "iconName");
+    roles.insert(ActiveRole, "active");
+    roles.insert(MinimizedRole, "minimized");
+    roles.insert(OutputRole, "output");
+    roles.insert(WorkspaceRole, "workspace");
+    return roles;
+}
+
+int WindowsModel::rowCount(const QModelIndex &parent) const
+{
+    Q_UNUSED(parent);
+    return m_entries.size();
+}
+
+QVariant WindowsModel::data(const QModelIndex &index, int role) const
+{
+    WindowEntry *entry = entryAt(index.row());
+    if (!index.isValid() || !entry)
+        return QVariant();
+
+    ClientWindow *window = entry->window;
+
+    switch (role) {
+    case WindowRole:
+        return QVariant::fromValue(window);
+    case Qt::DisplayRole:
+    case TitleRole:
+        return window->title();
+    case AppIdRole:
+        return window->appId();
+    case IconNameRole:
+        return window->iconName();
+    case ActiveRole:
+        return window->isActive();
+    case MinimizedRole:
+        return window->isMinimized();
+    case OutputRole:
+        return QVariant::fromValue(window->designedOutput());
+    case WorkspaceRole:
+        return entry->workspace;
+    default:
+        break;
+    }
+
+    return QVariant();
+}
+
+ClientWindow *WindowsModel::get(int row) const
+{
+    WindowEntry *entry = entryAt(row);
+    return entry ? entry->window : Q_NULLPTR;
+}
+
+int WindowsModel::indexOf(ClientWindow *window) const
+{
+    WindowEntry *entry = m_windows.value(window);
+    return entry ? rowOf(entry) : -1;
+}
+
+void WindowsModel::addWindow(ClientWindow *window)
+{
+    if (!window || m_windows.contains(window))
+        return;
+
+    WindowEntry *entry = new WindowEntry();
+    entry->window = window;
+    entry->surface = window->surface();
+    entry->position = m_entries.size();
+
+    // New windows are the most recent ones, hence they go on top
+    beginInsertRows(QModelIndex(), 0, 0);
+    m_entries.append(entry);
+    m_windows.insert(window, entry);
+    if (entry->surface)
+        m_surfaces.insert(entry->surface, entry);
+    if (m_validPositions == entry->position)
+        m_validPositions++;
+    endInsertRows();
+    Q_EMIT countChanged();
+
+    connect(window, &ClientWindow::activeChanged,
+            this, &WindowsModel::windowActiveChanged);
+    connect(window, &ClientWindow::titleChanged, this, [this, window] {
+        notifyChanged(window, QVector<int>() << Qt::DisplayRole << TitleRole);
+    });
+    connect(window, &ClientWindow::appIdChanged, this, [this, window] {
+        notifyChanged(window, QVector<int>() << AppIdRole);
+    });
+    connect(window, &ClientWindow::iconNameChanged, this, [this, window] {
+        notifyChanged(window, QVector<int>() << IconNameRole);
+    });
+    connect(window, &ClientWindow::minimizedChanged, this, [this, window] {
+        notifyChanged(window, QVector<int>() << MinimizedRole);
+    });
+    connect(window, &ClientWindow::designedOutputChanged, this, [this, window] {
+        notifyChanged(window, QVector<int>() << OutputRole);
+    });
+    connect(window, &QObject::destroyed,
+            this, &WindowsModel::windowDestroyed);
+}
+
+void WindowsModel::removeWindow(ClientWindow *window)
+{
+    WindowEntry *entry = m_windows.value(window);
+    if (entry)
+        removeEntry(entry);
+}
+
+void WindowsModel::removeSurface(QWaylandSurface *surface)
+{
+    WindowEntry *entry = m_surfaces.value(surface);
+    if (entry)
+        removeEntry(entry);
+}
+
+void WindowsModel::setWorkspace(ClientWindow *window, int workspace)
+{
+    WindowEntry *entry = m_windows.value(window);
+    if (!entry || entry->workspace == workspace)
+        return;
+
+    entry->workspace = workspace;
+
+    const QModelIndex modelIndex = index(rowOf(entry));
+    Q_EMIT dataChanged(modelIndex, modelIndex, QVector<int>() << WorkspaceRole);
+}
+
+void WindowsModel::removeWorkspace(int workspace, int target)
+{
+    // Windows move to the target workspace, numbered as after the
+    // removal, and those on the following workspaces shift down
+    Q_FOREACH (WindowEntry *entry, m_entries) {
+        if (entry->workspace == workspace)
+            setWorkspace(entry->window, target);
+        else if (entry->workspace > workspace)
+            setWorkspace(entry->window, entry->workspace - 1);
+    }
+}
+
+int WindowsModel::rowOf(WindowEntry *entry) const
+{
+    // Positions after a removal or a raise are refreshed lazily,
+    // so that a burst of unmaps costs a single pass
+    if (entry->position >= m_validPositions) {
+        for (int i = m_validPositions; i < m_entries.size(); i++)
+            m_entries.at(i)->position = i;
+        m_validPositions = m_entries.size();
+    }
+
+    return m_entries.size() - 1 - entry->position;
+}
+
+WindowEntry *WindowsModel::entryAt(int row) const
+{
+    if (row < 0 || row >= m_entries.size())
+        return Q_NULLPTR;
+    return m_entries.at(m_entries.size() - 1 - row);
+}
+
+void WindowsModel::removeEntry(WindowEntry *entry)
+{
+    const int row = rowOf(entry);
+    const int position = entry->position;
+
+    beginRemoveRows(QModelIndex(), row, row);
+    m_entries.remove(position);
+    m_windows.remove(entry->window);
+    if (entry->surface)
+        m_surfaces.remove(entry->surface);
+    m_validPositions = qMin(m_validPositions, position);
+    endRemoveRows();
+    Q_EMIT countChanged();
+
+    if (entry->window)
+        disconnect(entry->window, Q_NULLPTR, this, Q_NULLPTR);
+    delete entry;
+}
+
+void WindowsModel::raiseEntry(WindowEntry *entry)
+{
+    const int row = rowOf(entry);
+    if (row == 0)
+        return;
+
+    const int position = entry->position;
+
+    beginMoveRows(QModelIndex(), row, row, QModelIndex(), 0);
+    m_entries.remove(position);
+    m_entries.append(entry);
+    m_validPositions = qMin(m_validPositions, position);
+    endMoveRows();
+}
+
+void WindowsModel::notifyChanged(ClientWindow *window, const QVector<int> &roles)
+{
+    WindowEntry *entry = m_windows.value(window);
+    if (!entry)
+        return;
+
+    const QModelIndex modelIndex = index(rowOf(entry));
+    Q_EMIT dataChanged(modelIndex, modelIndex, roles);
+}
+
+void WindowsModel::windowActiveChanged()
+{
+    ClientWindow *window = qobject_cast<ClientWindow *>(sender());
+    WindowEntry *entry = m_windows.value(window);
+    if (!entry)
+        return;
+
+    // Keep the focus recency order for the window switcher
+    if (window->isActive())
+        raiseEntry(entry);
+
+    const QModelIndex modelIndex = index(rowOf(entry));
+    Q_EMIT dataChanged(modelIndex, modelIndex, QVector<int>() << ActiveRole);
+}
+
+void WindowsModel::windowDestroyed(QObject *object)
+{
+    // Can't use qobject_cast here because the object is being destroyed
+    WindowEntry *entry = m_windows.value(static_cast<ClientWindow *>(object));
+    if (!entry)
+        return;
+
+    entry->window = Q_NULLPTR;
+    m_windows.remove(static_cast<ClientWindow *>(object));
+    removeEntry(entry);
+}
+
+#include "moc_windowsmodel.cpp"
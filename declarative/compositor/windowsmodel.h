@@ -0,0 +1,104 @@
+/****************************************************************************
+ * This file is part of Hawaii.
+ *
+ * Copyright (C) 2016 Pier Luigi Fiorini
+ *
+ * Author(s):
+ *    Pier Luigi Fiorini <pierluigi.fiorini@gmail.com>
+ *
+ * $BEGIN_LICENSE:LGPL2.1+$
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * $END_LICENSE$
+ ***************************************************************************/
+
+#ifndef WINDOWSMODEL_H
+#define WINDOWSMODEL_H
+
+#include <QtCore/QAbstractListModel>
+#include <QtCore/QHash>
+#include <QtCore/QVector>
+#include <QtQml/QQmlComponent>
+
+#include <GreenIsland/Server/ClientWindow>
+
+using namespace GreenIsland::Server;
+
+class WindowEntry;
+
+class WindowsModel : public QAbstractListModel
+{
+    Q_OBJECT
+    Q_PROPERTY(int count READ count NOTIFY countChanged)
+    Q_ENUMS(Roles)
+public:
+    enum Roles {
+        WindowRole = Qt::UserRole + 1,
+        TitleRole,
+        AppIdRole,
+        IconNameRole,
+        ActiveRole,
+        MinimizedRole,
+        OutputRole,
+        WorkspaceRole
+    };
+
+    WindowsModel(QObject *parent = 0);
+    ~WindowsModel();
+
+    int count() const;
+
+    QHash<int, QByteArray> roleNames() const;
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const;
+
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const;
+
+    Q_INVOKABLE ClientWindow *get(int row) const;
+    Q_INVOKABLE int indexOf(ClientWindow *window) const;
+
+    Q_INVOKABLE void addWindow(ClientWindow *window);
+    Q_INVOKABLE void removeWindow(ClientWindow *window);
+    Q_INVOKABLE void removeSurface(QWaylandSurface *surface);
+
+    Q_INVOKABLE void setWorkspace(ClientWindow *window, int workspace);
+    Q_INVOKABLE void removeWorkspace(int workspace, int target);
+
+Q_SIGNALS:
+    void countChanged();
+
+private:
+    // Entries are stored from the least to the most recently focused,
+    // so that mapping a window is an append and rows are the reverse
+    QVector<WindowEntry *> m_entries;
+    QHash<ClientWindow *, WindowEntry *> m_windows;
+    QHash<QWaylandSurface *, WindowEntry *> m_surfaces;
+    mutable int m_validPositions;
+
+    int rowOf(WindowEntry *entry) const;
+    WindowEntry *entryAt(int row) const;
+
+    void removeEntry(WindowEntry *entry);
+    void raiseEntry(WindowEntry *entry);
+    void notifyChanged(ClientWindow *window, const QVector<int> &roles);
+
+private Q_SLOTS:
+    void windowActiveChanged();
+    void windowDestroyed(QObject *object);
+};
+
+QML_DECLARE_TYPE(WindowsModel)
+
+#endif // WINDOWSMODEL_H
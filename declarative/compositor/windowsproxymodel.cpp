@@ -0,0 +1,124 @@
+/****************************************************************************
+ * This file is part of Hawaii.
+ *
+ * Copyright (C) 2016 Pier Luigi Fiorini
+ *
+ * Author(s):
+ *    Pier Luigi Fiorini <pierluigi.fiorini@gmail.com>
+ *
+ * $BEGIN_LICENSE:LGPL2.1+$
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * $END_LICENSE$
+ ***************************************************************************/
+
+#include "windowsproxymodel.h"
+
+WindowsProxyModel::WindowsProxyModel(QObject *parent)
+    : QSortFilterProxyModel(parent)
+    , m_workspace(-1)
+{
+    // Filter again when output or workspace of a window change
+    setDynamicSortFilter(true);
+
+    connect(this, &QSortFilterProxyModel::rowsInserted,
+            this, &WindowsProxyModel::countChanged);
+    connect(this, &QSortFilterProxyModel::rowsRemoved,
+            this, &WindowsProxyModel::countChanged);
+    connect(this, &QSortFilterProxyModel::modelReset,
+            this, &WindowsProxyModel::countChanged);
+}
+
+WindowsModel *WindowsProxyModel::model() const
+{
+    return m_sourceModel;
+}
+
+void WindowsProxyModel::setModel(WindowsModel *model)
+{
+    if (m_sourceModel == model)
+        return;
+
+    m_sourceModel = model;
+    setSourceModel(model);
+    Q_EMIT modelChanged();
+}
+
+QWaylandOutput *WindowsProxyModel::output() const
+{
+    return m_output;
+}
+
+void WindowsProxyModel::setOutput(QWaylandOutput *output)
+{
+    if (m_output == output)
+        return;
+
+    m_output = output;
+    invalidateFilter();
+    Q_EMIT outputChanged();
+}
+
+int WindowsProxyModel::workspace() const
+{
+    return m_workspace;
+}
+
+void WindowsProxyModel::setWorkspace(int workspace)
+{
+    if (m_workspace == workspace)
+        return;
+
+    m_workspace = workspace;
+    invalidateFilter();
+    Q_EMIT workspaceChanged();
+}
+
+int WindowsProxyModel::count() const
+{
+    return rowCount();
+}
+
+ClientWindow *WindowsProxyModel::get(int row) const
+{
+    if (!m_sourceModel)
+        return Q_NULLPTR;
+
+    const QModelIndex sourceIndex = mapToSource(index(row, 0));
+    return m_sourceModel->get(sourceIndex.row());
+}
+
+bool WindowsProxyModel::filterAcceptsRow(int sourceRow, const QModelIndex &sourceParent) const
+{
+    if (!m_sourceModel)
+        return false;
+
+    const QModelIndex sourceIndex = m_sourceModel->index(sourceRow, 0, sourceParent);
+
+    if (m_output) {
+        QWaylandOutput *output = sourceIndex.data(WindowsModel::OutputRole).value<QWaylandOutput *>();
+        if (output != m_output)
+            return false;
+    }
+
+    if (m_workspace >= 0) {
+        if (sourceIndex.data(WindowsModel::WorkspaceRole).toInt() != m_workspace)
+            return false;
+    }
+
+    return true;
+}
+
+#include "moc_windowsproxymodel.cpp"
@@ -0,0 +1,75 @@
+/****************************************************************************
+ * This file is part of Hawaii.
+ *
+ * Copyright (C) 2016 Pier Luigi Fiorini
+ *
+ * Author(s):
+ *    Pier Luigi Fiorini <pierluigi.fiorini@gmail.com>
+ *
+ * $BEGIN_LICENSE:LGPL2.1+$
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * $END_LICENSE$
+ ***************************************************************************/
+
+#ifndef WINDOWSPROXYMODEL_H
+#define WINDOWSPROXYMODEL_H
+
+#include <QtCore/QPointer>
+#include <QtCore/QSortFilterProxyModel>
+
+#include <GreenIsland/QtWaylandCompositor/QWaylandOutput>
+
+#include "windowsmodel.h"
+
+class WindowsProxyModel : public QSortFilterProxyModel
+{
+    Q_OBJECT
+    Q_PROPERTY(WindowsModel *model READ model WRITE setModel NOTIFY modelChanged)
+    Q_PROPERTY(QWaylandOutput *output READ output WRITE setOutput NOTIFY outputChanged)
+    Q_PROPERTY(int workspace READ workspace WRITE setWorkspace NOTIFY workspaceChanged)
+    Q_PROPERTY(int count READ count NOTIFY countChanged)
+public:
+    WindowsProxyModel(QObject *parent = 0);
+
+    WindowsModel *model() const;
+    void setModel(WindowsModel *model);
+
+    QWaylandOutput *output() const;
+    void setOutput(QWaylandOutput *output);
+
+    int workspace() const;
+    void setWorkspace(int workspace);
+
+    int count() const;
+
+    Q_INVOKABLE ClientWindow *get(int row) const;
+
+Q_SIGNALS:
+    void modelChanged();
+    void outputChanged();
+    void workspaceChanged();
+    void countChanged();
+
+protected:
+    bool filterAcceptsRow(int sourceRow, const QModelIndex &sourceParent) const Q_DECL_OVERRIDE;
+
+private:
+    QPointer<WindowsModel> m_sourceModel;
+    QPointer<QWaylandOutput> m_output;
+    int m_workspace;
+};
+
+#endif // WINDOWSPROXYMODEL_H
@@ -0,0 +1,365 @@
+/****************************************************************************
+ * This file is part of Hawaii.
+ *
+ * Copyright (C) 2016 Pier Luigi Fiorini
+ *
+ * Author(s):
+ *    Pier Luigi Fiorini <pierluigi.fiorini@gmail.com>
+ *
+ * $BEGIN_LICENSE:LGPL2.1+$
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * $END_LICENSE$
+ ***************************************************************************/
+
+#include <QtCore/QTimer>
+#include <QtQuick/QQuickItem>
+#include <QtQuick/QQuickItemGrabResult>
+#include <QtQuick/QQuickWindow>
+
+#include <GreenIsland/QtWaylandCompositor/QWaylandSurface>
+
+#include "windowthumbnails.h"
+
+WindowThumbnails *WindowThumbnails::s_instance = Q_NULLPTR;
+
+WindowThumbnails::WindowThumbnails(QObject *parent)
+    : QObject(parent)
+    , m_size(256, 256)
+    , m_maximumRate(2)
+    , m_memoryBudget(32768)
+    , m_memoryUsage(0)
+    , m_revision(0)
+    , m_holds(0)
+    , m_nextId(1)
+    , m_clock(0)
+{
+    Q_ASSERT(!s_instance);
+    s_instance = this;
+
+    // A single timer refreshes all damaged windows
+    m_timer = new QTimer(this);
+    m_timer->setInterval(1000 / m_maximumRate);
+    connect(m_timer, &QTimer::timeout,
+            this, &WindowThumbnails::update);
+}
+
+WindowThumbnails::~WindowThumbnails()
+{
+    QMutexLocker locker(&m_mutex);
+    s_instance = Q_NULLPTR;
+    qDeleteAll(m_thumbnails);
+}
+
+WindowThumbnails *WindowThumbnails::instance()
+{
+    return s_instance;
+}
+
+QSize WindowThumbnails::size() const
+{
+    return m_size;
+}
+
+void WindowThumbnails::setSize(const QSize &size)
+{
+    if (m_size == size)
+        return;
+
+    m_size = size;
+    Q_EMIT sizeChanged();
+
+    Q_FOREACH (WindowThumbnail *thumbnail, m_thumbnails)
+        damage(thumbnail);
+}
+
+int WindowThumbnails::maximumRate() const
+{
+    return m_maximumRate;
+}
+
+void WindowThumbnails::setMaximumRate(int rate)
+{
+    rate = qMax(1, rate);
+    if (m_maximumRate == rate)
+        return;
+
+    m_maximumRate = rate;
+    m_timer->setInterval(1000 / m_maximumRate);
+    Q_EMIT maximumRateChanged();
+}
+
+int WindowThumbnails::memoryBudget() const
+{
+    return m_memoryBudget;
+}
+
+void WindowThumbnails::setMemoryBudget(int budget)
+{
+    if (m_memoryBudget == budget)
+        return;
+
+    m_memoryBudget = budget;
+    Q_EMIT memoryBudgetChanged();
+
+    trim();
+}
+
+int WindowThumbnails::memoryUsage() const
+{
+    return m_memoryUsage / 1024;
+}
+
+int WindowThumbnails::revision() const
+{
+    return m_revision;
+}
+
+void WindowThumbnails::addView(ClientWindow *window, QQuickItem *item)
+{
+    if (!window || !item)
+        return;
+
+    WindowThumbnail *thumbnail = m_windows.value(window);
+    if (!thumbnail) {
+        thumbnail = new WindowThumbnail();
+        thumbnail->id = m_nextId++;
+        thumbnail->window = window;
+
+        {
+            QMutexLocker locker(&m_mutex);
+            m_windows.insert(window, thumbnail);
+            m_thumbnails.insert(thumbnail->id, thumbnail);
+        }
+
+        connect(window, &QObject::destroyed,
+                this, &WindowThumbnails::windowDestroyed);
+
+        // Refresh on damage and drop the snapshot when the size
+        // changes because the aspect ratio is likely different
+        QWaylandSurface *surface = window->surface();
+        if (surface) {
+            const int id = thumbnail->id;
+            connect(surface, &QWaylandSurface::redraw, this, [this, id] {
+                WindowThumbnail *thumbnail = m_thumbnails.value(id);
+                if (thumbnail)
+                    damage(thumbnail);
+            });
+            connect(surface, &QWaylandSurface::sizeChanged, this, [this, window] {
+                invalidate(window);
+            });
+        }
+    }
+
+    thumbnail->views.removeAll(QPointer<QQuickItem>());
+    thumbnail->views.append(QPointer<QQuickItem>(item));
+    damage(thumbnail);
+}
+
+QUrl WindowThumbnails::url(ClientWindow *window, int revision) const
+{
+    // Revision is not used, it's only there so that bindings
+    // are evaluated again when a snapshot is updated
+    Q_UNUSED(revision);
+
+    WindowThumbnail *thumbnail = m_windows.value(window);
+    if (!thumbnail || thumbnail->image.isNull())
+        return QUrl();
+
+    return QUrl(QStringLiteral("image://windowthumbnails/%1/%2")
+                .arg(thumbnail->id).arg(thumbnail->version));
+}
+
+void WindowThumbnails::invalidate(ClientWindow *window)
+{
+    WindowThumbnail *thumbnail = m_windows.value(window);
+    if (!thumbnail)
+        return;
+
+    {
+        QMutexLocker locker(&m_mutex);
+        m_memoryUsage -= thumbnail->image.byteCount();
+        thumbnail->image = QImage();
+        thumbnail->version++;
+    }
+    Q_EMIT memoryUsageChanged();
+
+    damage(thumbnail);
+}
+
+void WindowThumbnails::hold()
+{
+    // Snapshots are refreshed only while somebody shows them
+    if (m_holds++ == 0) {
+        Q_FOREACH (WindowThumbnail *thumbnail, m_thumbnails) {
+            if (thumbnail->dirty || thumbnail->image.isNull())
+                damage(thumbnail);
+        }
+    }
+}
+
+void WindowThumbnails::release()
+{
+    if (m_holds == 0)
+        return;
+
+    if (--m_holds == 0)
+        m_timer->stop();
+}
+
+QImage WindowThumbnails::image(int id)
+{
+    QMutexLocker locker(&m_mutex);
+
+    WindowThumbnail *thumbnail = m_thumbnails.value(id);
+    if (!thumbnail)
+        return QImage();
+
+    thumbnail->lastUsed = ++m_clock;
+    return thumbnail->image;
+}
+
+void WindowThumbnails::damage(WindowThumbnail *thumbnail)
+{
+    thumbnail->dirty = true;
+
+    if (m_holds == 0)
+        return;
+
+    // Grab right away if the window was not refreshed recently,
+    // otherwise wait for the next tick
+    if (!thumbnail->lastGrab.isValid() || thumbnail->lastGrab.elapsed() >= m_timer->interval())
+        grab(thumbnail);
+    if (thumbnail->dirty && !m_timer->isActive())
+        m_timer->start();
+}
+
+void WindowThumbnails::grab(WindowThumbnail *thumbnail)
+{
+    // Find a view that can be rendered
+    QQuickItem *item = Q_NULLPTR;
+    Q_FOREACH (const QPointer<QQuickItem> &view, thumbnail->views) {
+        if (view && view->window() && view->isVisible() &&
+                view->width() > 0 && view->height() > 0) {
+            item = view;
+            break;
+        }
+    }
+    if (!item)
+        return;
+
+    // Let the GPU downscale, never upscale
+    QSize targetSize(qRound(item->width()), qRound(item->height()));
+    if (targetSize.width() > m_size.width() || targetSize.height() > m_size.height())
+        targetSize.scale(m_size, Qt::KeepAspectRatio);
+
+    QSharedPointer<QQuickItemGrabResult> result = item->grabToImage(targetSize);
+    if (!result)
+        return;
+
+    thumbnail->dirty = false;
+    thumbnail->lastGrab.start();
+    thumbnail->grabResult = result;
+
+    // A newer grab might have replaced this one in the meantime,
+    // don't hold a reference here or the result would never go away
+    const int id = thumbnail->id;
+    QQuickItemGrabResult *grabResult = result.data();
+    connect(grabResult, &QQuickItemGrabResult::ready, this, [this, id, grabResult] {
+        WindowThumbnail *thumbnail = m_thumbnails.value(id);
+        if (!thumbnail || thumbnail->grabResult.data() != grabResult)
+            return;
+
+        {
+            QMutexLocker locker(&m_mutex);
+            m_memoryUsage -= thumbnail->image.byteCount();
+            thumbnail->image = grabResult->image();
+            m_memoryUsage += thumbnail->image.byteCount();
+            thumbnail->version++;
+            thumbnail->lastUsed = ++m_clock;
+        }
+
+        trim();
+
+        m_revision++;
+        Q_EMIT memoryUsageChanged();
+        Q_EMIT revisionChanged();
+    });
+}
+
+void WindowThumbnails::trim()
+{
+    QMutexLocker locker(&m_mutex);
+
+    const qint64 budget = qint64(m_memoryBudget) * 1024;
+    while (m_memoryUsage > budget) {
+        // Drop the least recently used snapshot
+        WindowThumbnail *victim = Q_NULLPTR;
+        Q_FOREACH (WindowThumbnail *thumbnail, m_thumbnails) {
+            if (thumbnail->image.isNull())
+                continue;
+            if (!victim || thumbnail->lastUsed < victim->lastUsed)
+                victim = thumbnail;
+        }
+        if (!victim)
+            break;
+
+        m_memoryUsage -= victim->image.byteCount();
+        victim->image = QImage();
+        victim->dirty = true;
+        victim->version++;
+    }
+}
+
+void WindowThumbnails::update()
+{
+    bool pending = false;
+
+    Q_FOREACH (WindowThumbnail *thumbnail, m_thumbnails) {
+        if (!thumbnail->dirty)
+            continue;
+
+        if (thumbnail->lastGrab.isValid() && thumbnail->lastGrab.elapsed() < m_timer->interval())
+            pending = true;
+        else
+            grab(thumbnail);
+    }
+
+    // Keep ticking only while windows wait to be refreshed
+    if (!pending)
+        m_timer->stop();
+}
+
+void WindowThumbnails::windowDestroyed(QObject *object)
+{
+    // Can't use qobject_cast here because the object is being destroyed
+    ClientWindow *window = static_cast<ClientWindow *>(object);
+
+    {
+        QMutexLocker locker(&m_mutex);
+
+        WindowThumbnail *thumbnail = m_windows.take(window);
+        if (!thumbnail)
+            return;
+
+        m_thumbnails.remove(thumbnail->id);
+        m_memoryUsage -= thumbnail->image.byteCount();
+        delete thumbnail;
+    }
+
+    Q_EMIT memoryUsageChanged();
+}
+
+#include "moc_windowthumbnails.cpp"
@@ -0,0 +1,168 @@
+/****************************************************************************
+ * This file is part of Hawaii.
+ *
+ * Copyright (C) 2016 Pier Luigi Fiorini
+ *
+ * Author(s):
+ *    Pier Luigi Fiorini <pierluigi.fiorini@gmail.com>
+ *
+ * $BEGIN_LICENSE:LGPL2.1+$
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * $END_LICENSE$
+ ***************************************************************************/
+
+#ifndef WINDOWTHUMBNAILS_H
+#define WINDOWTHUMBNAILS_H
+
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QHash>
+#include <QtCore/QMutex>
+#include <QtCore/QObject>
+#include <QtCore/QPointer>
+#include <QtCore/QSharedPointer>
+#include <QtCore/QSize>
+#include <QtCore/QUrl>
+#include <QtGui/QImage>
+
+#include <GreenIsland/Server/ClientWindow>
+
+using namespace GreenIsland::Server;
+
+class QQuickItem;
+class QQuickItemGrabResult;
+class QTimer;
+
+class WindowThumbnail
+{
+public:
+    WindowThumbnail()
+        : id(0)
+        , window(Q_NULLPTR)
+        , version(0)
+        , dirty(true)
+        , lastUsed(0)
+    {
+    }
+
+    int id;
+    ClientWindow *window;
+    QList<QPointer<QQuickItem> > views;
+    QImage image;
+    int version;
+    bool dirty;
+    quint64 lastUsed;
+    QElapsedTimer lastGrab;
+    QSharedPointer<QQuickItemGrabResult> grabResult;
+};
+
+class WindowThumbnails : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(QSize size READ size WRITE setSize NOTIFY sizeChanged)
+    Q_PROPERTY(int maximumRate READ maximumRate WRITE setMaximumRate NOTIFY maximumRateChanged)
+    Q_PROPERTY(int memoryBudget READ memoryBudget WRITE setMemoryBudget NOTIFY memoryBudgetChanged)
+    Q_PROPERTY(int memoryUsage READ memoryUsage NOTIFY memoryUsageChanged)
+    Q_PROPERTY(int revision READ revision NOTIFY revisionChanged)
+public:
+    WindowThumbnails(QObject *parent = 0);
+    ~WindowThumbnails();
+
+    static WindowThumbnails *instance();
+
+    /*!
+     * \brief Maximum thumbnail size.
+     *
+     * Snapshots are downscaled to fit this size, keeping
+     * the aspect ratio.
+     */
+    QSize size() const;
+    void setSize(const QSize &size);
+
+    /*!
+     * \brief Maximum refresh rate.
+     *
+     * Maximum number of times per second that the snapshot
+     * of a damaged window is refreshed.
+     */
+    int maximumRate() const;
+    void setMaximumRate(int rate);
+
+    /*!
+     * \brief Memory budget.
+     *
+     * Maximum amount of memory, in KiB, used by snapshots.
+     * Least recently used snapshots are dropped when exceeded.
+     */
+    int memoryBudget() const;
+    void setMemoryBudget(int budget);
+
+    /*!
+     * \brief Memory usage.
+     *
+     * Amount of memory, in KiB, currently used by snapshots.
+     */
+    int memoryUsage() const;
+
+    /*!
+     * \brief Revision.
+     *
+     * Incremented every time a snapshot is updated, bind to it
+     * in order to refresh thumbnail URLs.
+     */
+    int revision() const;
+
+    Q_INVOKABLE void addView(ClientWindow *window, QQuickItem *item);
+    Q_INVOKABLE QUrl url(ClientWindow *window, int revision = 0) const;
+    Q_INVOKABLE void invalidate(ClientWindow *window);
+
+    Q_INVOKABLE void hold();
+    Q_INVOKABLE void release();
+
+    QImage image(int id);
+
+Q_SIGNALS:
+    void sizeChanged();
+    void maximumRateChanged();
+    void memoryBudgetChanged();
+    void memoryUsageChanged();
+    void revisionChanged();
+
+private:
+    QSize m_size;
+    int m_maximumRate;
+    int m_memoryBudget;
+    qint64 m_memoryUsage;
+    int m_revision;
+    int m_holds;
+    int m_nextId;
+    quint64 m_clock;
+    QTimer *m_timer;
+    QMutex m_mutex;
+    QHash<ClientWindow *, WindowThumbnail *> m_windows;
+    QHash<int, WindowThumbnail *> m_thumbnails;
+
+    static WindowThumbnails *s_instance;
+
+    void damage(WindowThumbnail *thumbnail);
+    void grab(WindowThumbnail *thumbnail);
+    void trim();
+
+private Q_SLOTS:
+    void update();
+    void windowDestroyed(QObject *object);
+};
+
+#endif // WINDOWTHUMBNAILS_H
@@ -0,0 +1,55 @@
+/****************************************************************************
+ * This file is part of Hawaii.
+ *
+ * Copyright (C) 2016 Pier Luigi Fiorini
+ *
+ * Author(s):
+ *    Pier Luigi Fiorini <pierluigi.fiorini@gmail.com>
+ *
+ * $BEGIN_LICENSE:LGPL2.1+$
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * $END_LICENSE$
+ ***************************************************************************/
+
+#include "windowthumbnails.h"
+#include "windowthumbnailsimageprovider.h"
+
+WindowThumbnailsImageProvider::WindowThumbnailsImageProvider()
+    : QQuickImageProvider(QQuickImageProvider::Image)
+{
+}
+
+QImage WindowThumbnailsImageProvider::requestImage(const QString &id, QSize *size, const QSize &requestedSize)
+{
+    Q_UNUSED(requestedSize);
+
+    // Identifier is made of the thumbnail identifier and its version,
+    // the version makes Image reload only when the snapshot changed
+    bool ok = false;
+    int thumbnailId = id.section(QLatin1Char('/'), 0, 0).toInt(&ok);
+    if (!ok)
+        return QImage();
+
+    WindowThumbnails *thumbnails = WindowThumbnails::instance();
+    if (!thumbnails)
+        return QImage();
+
+    // Snapshots are already downscaled
+    QImage image = thumbnails->image(thumbnailId);
+    if (size)
+        *size = image.size();
+    return image;
+}
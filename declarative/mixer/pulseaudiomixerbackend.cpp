@@ -36,8 +36,10 @@ Q_LOGGING_CATEGORY(PULSEAUDIO, "hawaii.qml.mixer.pulseaudio")
 struct Sink
 {
     Sink()
-        : muted(false)
+        : index(PA_INVALID_INDEX)
+        , muted(false)
     {
+        pa_cvolume_init(&volume);
     }
 
     uint32_t index;
@@ -45,6 +47,13 @@ struct Sink
     bool muted;
 };
 
+static void unrefOperation(pa_operation *operation)
+{
+    // We are not interested in tracking operations
+    if (operation)
+        pa_operation_unref(operation);
+}
+
 PulseAudioMixerBackend::PulseAudioMixerBackend(Mixer *mixer)
     : MixerBackend()
     , m_mixer(mixer)
@@ -52,13 +61,16 @@ PulseAudioMixerBackend::PulseAudioMixerBackend(Mixer *mixer)
     , m_loopApi(Q_NULLPTR)
     , m_context(Q_NULLPTR)
     , m_sink(new Sink)
+    , m_volumeOperation(Q_NULLPTR)
+    , m_targetVolume(-1)
+    , m_volumePending(false)
 {
 }
 
 PulseAudioMixerBackend::~PulseAudioMixerBackend()
 {
-    delete m_sink;
     cleanup();
+    delete m_sink;
 }
 
 PulseAudioMixerBackend *PulseAudioMixerBackend::createBackend(Mixer *mixer)
@@ -111,11 +123,15 @@ void PulseAudioMixerBackend::contextStateCallback(pa_context *context)
         pa_context_set_subscribe_callback(context, [](pa_context *c, pa_subscription_event_type_t t, uint32_t index, void *data) {
             static_cast<PulseAudioMixerBackend *>(data)->subscribeCallback(c, t, index);
         }, this);
-        pa_context_subscribe(context, PA_SUBSCRIPTION_MASK_SINK, Q_NULLPTR, Q_NULLPTR);
+        unrefOperation(pa_context_subscribe(context,
+                                            (pa_subscription_mask_t)(PA_SUBSCRIPTION_MASK_SINK |
+                                                                     PA_SUBSCRIPTION_MASK_SERVER),
+                                            Q_NULLPTR, Q_NULLPTR));
 
-        pa_context_get_sink_info_list(context, [](pa_context *c, const pa_sink_info *i, int eol, void *data) {
-            static_cast<PulseAudioMixerBackend *>(data)->sinkCallback(c, i, eol);
-        }, this);
+        // Find out the default sink, we'll fetch it afterwards
+        unrefOperation(pa_context_get_server_info(context, [](pa_context *c, const pa_server_info *i, void *data) {
+            static_cast<PulseAudioMixerBackend *>(data)->serverInfoCallback(c, i);
+        }, this));
         break;
     case PA_CONTEXT_TERMINATED:
         cleanup();
@@ -133,16 +149,53 @@ void PulseAudioMixerBackend::contextStateCallback(pa_context *context)
 void PulseAudioMixerBackend::subscribeCallback(pa_context *context, pa_subscription_event_type_t t, uint32_t index)
 {
     switch (t & PA_SUBSCRIPTION_EVENT_FACILITY_MASK) {
+    case PA_SUBSCRIPTION_EVENT_SERVER:
+        // The default sink might have changed
+        unrefOperation(pa_context_get_server_info(context, [](pa_context *c, const pa_server_info *i, void *data) {
+            static_cast<PulseAudioMixerBackend *>(data)->serverInfoCallback(c, i);
+        }, this));
+        break;
     case PA_SUBSCRIPTION_EVENT_SINK:
-        pa_context_get_sink_info_list(context, [](pa_context *c, const pa_sink_info *i, int eol, void *data) {
+        // Only the default sink is of any interest
+        if (index != m_sink->index)
+            break;
+
+        // When the default sink goes away the server picks another
+        // one and notifies us with a server event
+        if ((t & PA_SUBSCRIPTION_EVENT_TYPE_MASK) == PA_SUBSCRIPTION_EVENT_REMOVE) {
+            m_sink->index = PA_INVALID_INDEX;
+            break;
+        }
+
+        unrefOperation(pa_context_get_sink_info_by_index(context, index, [](pa_context *c, const pa_sink_info *i, int eol, void *data) {
             static_cast<PulseAudioMixerBackend *>(data)->sinkCallback(c, i, eol);
-        }, this);
+        }, this));
         break;
     default:
         break;
     }
 }
 
+void PulseAudioMixerBackend::serverInfoCallback(pa_context *context, const pa_server_info *i)
+{
+    if (!i) {
+        qCWarning(PULSEAUDIO) << "Server info callback failure";
+        return;
+    }
+
+    const QByteArray name(i->default_sink_name);
+    if (name == m_defaultSinkName && m_sink->index != PA_INVALID_INDEX)
+        return;
+
+    qCDebug(PULSEAUDIO) << "Default sink is" << name;
+
+    m_defaultSinkName = name;
+    if (!m_defaultSinkName.isEmpty())
+        unrefOperation(pa_context_get_sink_info_by_name(context, m_defaultSinkName.constData(), [](pa_context *c, const pa_sink_info *i, int eol, void *data) {
+            static_cast<PulseAudioMixerBackend *>(data)->sinkCallback(c, i, eol);
+        }, this));
+}
+
 void PulseAudioMixerBackend::sinkCallback(pa_context *context, const pa_sink_info *i, int eol)
 {
     if (eol < 0) {
@@ -156,17 +209,32 @@ void PulseAudioMixerBackend::sinkCallback(pa_context *context, const pa_sink_inf
     if (eol > 0)
         return;
 
+    // Ignore replies for a sink that is no longer the default
+    if (m_defaultSinkName != i->name)
+        return;
+
     m_sink->index = i->index;
     if (m_sink->muted != (bool)i->mute) {
         m_sink->muted = (bool)i->mute;
         Q_EMIT m_mixer->mutedChanged();
     }
-    m_sink->volume = i->volume;
-    Q_EMIT m_mixer->masterChanged();
+    if (!pa_cvolume_equal(&m_sink->volume, &i->volume)) {
+        m_sink->volume = i->volume;
+        Q_EMIT m_mixer->masterChanged();
+    }
 }
 
 void PulseAudioMixerBackend::cleanup()
 {
+    // Operations on a dead context never complete
+    if (m_volumeOperation) {
+        pa_operation_cancel(m_volumeOperation);
+        pa_operation_unref(m_volumeOperation);
+        m_volumeOperation = Q_NULLPTR;
+    }
+    m_volumePending = false;
+    m_targetVolume = -1;
+    m_sink->index = PA_INVALID_INDEX;
 }
 
 QString PulseAudioMixerBackend::name() const
@@ -184,22 +252,67 @@ void PulseAudioMixerBackend::boundaries(int *min, int *max) const
 
 int PulseAudioMixerBackend::volume() const
 {
+    // Relative changes build on the volume we are setting
+    if (m_targetVolume >= 0)
+        return m_targetVolume;
     return pa_cvolume_avg(&m_sink->volume);
 }
 
 void PulseAudioMixerBackend::setVolume(int value)
 {
-    setMuted(false);
+    m_targetVolume = value;
+
+    // Dragging a slider sets the volume many times in a row, keep
+    // only one operation in flight and send the latest value
+    // when it completes
+    if (m_volumeOperation) {
+        m_volumePending = true;
+        return;
+    }
+
+    if (m_sink->muted)
+        setMuted(false);
+
+    sendVolume();
+}
+
+void PulseAudioMixerBackend::volumeCallback(pa_context *context, int success)
+{
+    if (!success)
+        qCWarning(PULSEAUDIO,
+                  "Failed to set volume: %s",
+                  pa_strerror(pa_context_errno(context)));
+
+    pa_operation_unref(m_volumeOperation);
+    m_volumeOperation = Q_NULLPTR;
+
+    if (m_volumePending)
+        sendVolume();
+    else
+        m_targetVolume = -1;
+}
+
+void PulseAudioMixerBackend::sendVolume()
+{
+    m_volumePending = false;
 
 #if PA_CHECK_VERSION(5, 0, 0)
     bool valid = pa_channels_valid(m_sink->volume.channels) == 1;
 #else
     bool valid = true;
 #endif
-    if (valid) {
-        pa_cvolume_set(&m_sink->volume, m_sink->volume.channels, value);
-        pa_context_set_sink_volume_by_index(m_context, m_sink->index, &m_sink->volume, Q_NULLPTR, Q_NULLPTR);
+    if (valid && m_sink->index != PA_INVALID_INDEX) {
+        // Our copy is updated, and masterChanged emitted, when
+        // the server notifies the change
+        pa_cvolume volume = m_sink->volume;
+        pa_cvolume_set(&volume, volume.channels, m_targetVolume);
+        m_volumeOperation = pa_context_set_sink_volume_by_index(m_context, m_sink->index, &volume, [](pa_context *c, int success, void *data) {
+            static_cast<PulseAudioMixerBackend *>(data)->volumeCallback(c, success);
+        }, this);
     }
+
+    if (!m_volumeOperation)
+        m_targetVolume = -1;
 }
 
 bool PulseAudioMixerBackend::isMuted() const
@@ -209,5 +322,7 @@ bool PulseAudioMixerBackend::isMuted() const
 
 void PulseAudioMixerBackend::setMuted(bool value)
 {
-    pa_context_set_sink_mute_by_index(m_context, m_sink->index, value, Q_NULLPTR, Q_NULLPTR);
+    if (m_sink->index != PA_INVALID_INDEX)
+        unrefOperation(pa_context_set_sink_mute_by_index(m_context, m_sink->index, value,
+                                                         Q_NULLPTR, Q_NULLPTR));
 }
@@ -62,14 +62,21 @@ private:
     pa_glib_mainloop *m_loop;
     pa_mainloop_api *m_loopApi;
     pa_context *m_context;
+    QByteArray m_defaultSinkName;
     Sink *m_sink;
+    pa_operation *m_volumeOperation;
+    int m_targetVolume;
+    bool m_volumePending;
 
     PulseAudioMixerBackend(Mixer *mixer);
 
     void contextStateCallback(pa_context *context);
     void subscribeCallback(pa_context *context,
                            pa_subscription_event_type_t t, uint32_t index);
+    void serverInfoCallback(pa_context *context, const pa_server_info *i);
     void sinkCallback(pa_context *context, const pa_sink_info *i, int eol);
+    void volumeCallback(pa_context *context, int success);
+    void sendVolume();
     void cleanup();
 };
 
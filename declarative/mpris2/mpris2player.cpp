@@ -30,10 +30,10 @@
  */
 
 #include <QtCore/QUrl>
-#include <QtCore/QSettings>
 #include <QtDBus/QDBusArgument>
 #include <QtDBus/QDBusMetaType>
 
+#include "desktopentryiconresolver.h"
 #include "mpris2player.h"
 #include "mprisadaptor.h"
 #include "mprisplayeradaptor.h"
@@ -171,6 +171,10 @@ Mpris2Player::Mpris2Player(const QString &service, QObject *parent)
         Q_EMIT positionChanged();
     });
 
+    // Installed applications changed, the icon might be different
+    connect(DesktopEntryIconResolver::instance(), &DesktopEntryIconResolver::iconNamesChanged,
+            this, &Mpris2Player::updateIconName);
+
     // Retrieve data
     retrieveData();
 }
@@ -504,14 +508,8 @@ void Mpris2Player::copyProperty(const QString &name, const QVariant &value,
             Q_EMIT identityChanged();
         }
     } else if (name == QStringLiteral("DesktopEntry")) {
-        QSettings desktopFile(value.toString() + QStringLiteral(".desktop"), QSettings::IniFormat);
-        desktopFile.setIniCodec("UTF-8");
-        desktopFile.beginGroup(QStringLiteral("Desktop Entry"));
-        QString iconName = desktopFile.value(QStringLiteral("Icon")).toString();
-        if (!iconName.isEmpty()) {
-            m_iconName = iconName;
-            Q_EMIT iconNameChanged();
-        }
+        m_desktopEntry = value.toString();
+        updateIconName();
     } else if (name == QStringLiteral("Fullscreen")) {
         if (m_fullScreen != value.toBool()) {
             m_fullScreen = value.toBool();
@@ -522,4 +520,13 @@ void Mpris2Player::copyProperty(const QString &name, const QVariant &value,
     }
 }
 
+void Mpris2Player::updateIconName()
+{
+    QString iconName = DesktopEntryIconResolver::instance()->iconName(m_desktopEntry);
+    if (!iconName.isEmpty() && m_iconName != iconName) {
+        m_iconName = iconName;
+        Q_EMIT iconNameChanged();
+    }
+}
+
 #include "moc_mpris2player.cpp"
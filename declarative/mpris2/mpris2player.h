@@ -137,6 +137,7 @@ private:
     int m_fetchesPending;
 
     QString m_identity;
+    QString m_desktopEntry;
     QString m_iconName;
 
     Capabilities m_capabilities;
@@ -166,6 +167,7 @@ private Q_SLOTS:
     void updateFromMap(const QVariantMap &map);
     void copyProperty(const QString &name, const QVariant &value,
                       const QVariant::Type &expectedType);
+    void updateIconName();
 };
 
 #endif // MPRIS2PLAYER_H
@@ -24,15 +24,36 @@
  * $END_LICENSE$
  ***************************************************************************/
 
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QThread>
+#include <QtCore/QTimer>
+
 #include "notifications.h"
 #include "notificationsdaemon.h"
+#include "notificationshistorymodel.h"
+#include "notificationsratelimiter.h"
 
 Notifications::Notifications(QObject *parent)
     : QObject(parent)
     , m_valid(true)
     , m_active(true)
+    , m_thread(new QThread(this))
     , m_daemon(new NotificationsDaemon(this))
+    , m_history(new NotificationsHistoryModel(m_daemon, this))
+    , m_drainScheduled(0)
+    , m_drainTimer(new QTimer(this))
 {
+    // Notifications are received and their images decoded on a
+    // thread of their own, we only pick up the results
+    m_thread->setObjectName(QStringLiteral("NotificationsIngest"));
+    m_daemon->moveToThread(m_thread);
+    m_thread->start();
+
+    // Drain what's left of a flood once per frame
+    m_drainTimer->setSingleShot(true);
+    m_drainTimer->setInterval(16);
+    connect(m_drainTimer, SIGNAL(timeout()), this, SLOT(drainEvents()));
+
     // Register service
     if (!m_daemon->registerService()) {
         m_valid = false;
@@ -40,6 +61,15 @@ Notifications::Notifications(QObject *parent)
     }
 }
 
+Notifications::~Notifications()
+{
+    // Stop receiving notifications before the daemon goes away
+    m_daemon->unregisterService();
+    m_thread->quit();
+    m_thread->wait();
+    delete m_daemon;
+}
+
 bool Notifications::isValid() const
 {
     return m_valid;
@@ -71,6 +101,11 @@ NotificationsDaemon *Notifications::daemon() const
     return m_daemon;
 }
 
+NotificationsHistoryModel *Notifications::history() const
+{
+    return m_history;
+}
+
 void Notifications::invokeAction(uint id, const QString &actionId)
 {
     Q_EMIT m_daemon->ActionInvoked(id, actionId);
@@ -78,8 +113,76 @@ void Notifications::invokeAction(uint id, const QString &actionId)
 
 void Notifications::closeNotification(uint id, const CloseReason &reason)
 {
-    if (m_daemon->m_notifications.remove(id) > 0)
+    if (m_daemon->removeNotification(id)) {
         Q_EMIT m_daemon->NotificationClosed(id, (uint)reason);
+        Q_EMIT notificationClosed(id, (uint)reason);
+    }
+}
+
+QString Notifications::imageSource(uint id) const
+{
+    return m_daemon->imageSource(id);
+}
+
+QVariantMap Notifications::imageStoreStatistics() const
+{
+    QSharedPointer<NotificationsImageStore> store = m_daemon->imageStore();
+
+    QVariantMap map;
+    map.insert(QStringLiteral("notifications"), store->notificationCount());
+    map.insert(QStringLiteral("images"), store->imageCount());
+    map.insert(QStringLiteral("memoryUsage"), store->memoryUsage());
+    map.insert(QStringLiteral("memoryBudget"), store->memoryBudget());
+    return map;
+}
+
+QVariantMap Notifications::rateLimitStatistics() const
+{
+    return m_daemon->rateLimiter()->statistics();
+}
+
+void Notifications::post(const NotificationsEvent &event)
+{
+    // Called from the ingest thread, schedule a drain unless
+    // one is already pending
+    m_events.enqueue(event);
+    if (m_drainScheduled.testAndSetOrdered(0, 1))
+        QMetaObject::invokeMethod(this, "drainEvents", Qt::QueuedConnection);
+}
+
+void Notifications::drainEvents()
+{
+    // Bubbles are created by QML and that is not cheap, spend
+    // only a few milliseconds and leave the rest to the next frame
+    const qint64 budget = 4;
+    QElapsedTimer timer;
+    timer.start();
+
+    NotificationsEvent event;
+    while (timer.elapsed() < budget && m_events.dequeue(&event)) {
+        if (event.type == NotificationsEvent::Received) {
+            Q_EMIT notificationReceived(event.id, event.appName, event.appIcon,
+                                        event.hasIcon, event.summary, event.body,
+                                        event.actions, event.isPersistent,
+                                        event.timeout, event.hints);
+            m_history->apply(event);
+        } else if (event.type == NotificationsEvent::Closed) {
+            Q_EMIT notificationClosed(event.id, event.reason);
+        } else {
+            m_history->apply(event);
+        }
+    }
+
+    if (!m_events.isEmpty()) {
+        m_drainTimer->start();
+        return;
+    }
+
+    // The ingest thread doesn't schedule a drain while the flag
+    // is set, check again for events posted before we cleared it
+    m_drainScheduled.fetchAndStoreOrdered(0);
+    if (!m_events.isEmpty() && m_drainScheduled.testAndSetOrdered(0, 1))
+        m_drainTimer->start();
 }
 
 #include "moc_notifications.cpp"
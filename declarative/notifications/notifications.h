@@ -27,16 +27,65 @@
 #ifndef NOTIFICATIONS_H
 #define NOTIFICATIONS_H
 
+#include <QtCore/QAtomicInt>
 #include <QtCore/QObject>
+#include <QtCore/QVariant>
+
+#include "notificationsqueue.h"
 
 class QQmlPropertyMap;
+class QThread;
+class QTimer;
 class NotificationsDaemon;
+class NotificationsHistoryModel;
+
+struct NotificationsEvent {
+    enum Type {
+        Received,
+        Closed,
+        HistoryChanged
+    };
+
+    enum HistoryChange {
+        HistoryUnchanged,
+        HistoryAppended,
+        HistoryUpdated,
+        HistoryRemoved,
+        HistoryReset
+    };
+
+    NotificationsEvent()
+        : type(Received), id(0), hasIcon(false)
+        , isPersistent(false), timeout(0), reason(0)
+        , historyChange(HistoryUnchanged), historyIndex(-1)
+        , historyCount(0), historyRevision(0) {}
+
+    Type type;
+    uint id;
+    QString appName;
+    QString appIcon;
+    bool hasIcon;
+    QString summary;
+    QString body;
+    QVariantList actions;
+    bool isPersistent;
+    int timeout;
+    QVariantMap hints;
+    uint reason;
+
+    // What happened to the history, already written
+    HistoryChange historyChange;
+    int historyIndex;
+    int historyCount;
+    quint64 historyRevision;
+};
 
 class Notifications : public QObject
 {
     Q_OBJECT
     Q_PROPERTY(bool valid READ isValid CONSTANT)
     Q_PROPERTY(bool active READ isActive WRITE setActive NOTIFY activeChanged)
+    Q_PROPERTY(NotificationsHistoryModel *history READ history CONSTANT)
     Q_ENUMS(CloseReason)
 public:
     enum CloseReason {
@@ -46,6 +95,7 @@ public:
     };
 
     Notifications(QObject *parent = 0);
+    ~Notifications();
 
     bool isValid() const;
 
@@ -54,10 +104,17 @@ public:
 
     NotificationsDaemon *daemon() const;
 
+    NotificationsHistoryModel *history() const;
+
     Q_INVOKABLE void invokeAction(uint id, const QString &actionId);
 
     Q_INVOKABLE void closeNotification(uint id, const Notifications::CloseReason &reason);
 
+    Q_INVOKABLE QString imageSource(uint id) const;
+
+    Q_INVOKABLE QVariantMap imageStoreStatistics() const;
+    Q_INVOKABLE QVariantMap rateLimitStatistics() const;
+
 Q_SIGNALS:
     void activeChanged();
 
@@ -73,7 +130,19 @@ Q_SIGNALS:
 private:
     bool m_valid;
     bool m_active;
+    QThread *m_thread;
     NotificationsDaemon *m_daemon;
+    NotificationsHistoryModel *m_history;
+    NotificationsQueue<NotificationsEvent> m_events;
+    QAtomicInt m_drainScheduled;
+    QTimer *m_drainTimer;
+
+    void post(const NotificationsEvent &event);
+
+    friend class NotificationsDaemon;
+
+private Q_SLOTS:
+    void drainEvents();
 };
 
 #endif // NOTIFICATIONS_H
@@ -25,7 +25,9 @@
  ***************************************************************************/
 
 #include <QtCore/QAtomicInt>
+#include <QtCore/QDateTime>
 #include <QtCore/QStandardPaths>
+#include <QtCore/QUrl>
 #include <QtGui/QGuiApplication>
 #include <QtDBus/QDBusConnection>
 #include <QtQml/QQmlEngine>
@@ -35,10 +37,12 @@
 #include <QtDBus/QDBusArgument>
 
 #include "config.h"
+#include "desktopentryiconresolver.h"
 #include "notifications.h"
 #include "notificationsdaemon.h"
 #include "notificationsadaptor.h"
 #include "notificationsimage.h"
+#include "notificationsratelimiter.h"
 
 /*
  * Latest specifications:
@@ -51,8 +55,11 @@ const QString servicePath("/org/freedesktop/Notifications");
 Q_LOGGING_CATEGORY(NOTIFICATIONS, "hawall.qml.notifications")
 
 NotificationsDaemon::NotificationsDaemon(Notifications *parent)
-    : QObject(parent)
+    : QObject()
     , m_parent(parent)
+    , m_bus(QDBusConnection::connectToBus(QDBusConnection::SessionBus,
+                                          QStringLiteral("hawaii-notifications")))
+    , m_imageStore(new NotificationsImageStore())
 {
     // Create the DBus adaptor
     new NotificationsAdaptor(this);
@@ -60,27 +67,39 @@ NotificationsDaemon::NotificationsDaemon(Notifications *parent)
     // Create a seed for notifications identifiers, starting from 1
     m_idSeed = new QAtomicInt(1);
 
-    // List of applications that will send us too many notifications
-    // TODO: Add more from configuration
-    m_spamApplications << QStringLiteral("Clementine") << QStringLiteral("Spotify");
+    // Limit applications that will send us too many notifications
+    m_rateLimiter = new NotificationsRateLimiter(this);
 
-    // Forward our signals to parent
-    connect(this, SIGNAL(NotificationClosed(uint,uint)),
-            m_parent, SIGNAL(notificationClosed(uint,uint)));
+    // Notifications history, written from our thread
+    m_history.open(QStandardPaths::writableLocation(QStandardPaths::GenericDataLocation) +
+                   QStringLiteral("/hawaii/notifications"));
+
+    // Forward our signals to parent, notifications closed by the
+    // application go through the parent queue instead to preserve
+    // their order with received notifications
     connect(this, SIGNAL(ActionInvoked(uint,QString)),
             m_parent, SIGNAL(actionInvoked(uint,QString)));
 }
 
 NotificationsDaemon::~NotificationsDaemon()
 {
-    qDeleteAll(m_images);
     unregisterService();
+    QDBusConnection::disconnectFromBus(m_bus.name());
     delete m_idSeed;
 }
 
 bool NotificationsDaemon::registerService()
 {
-    QDBusConnection bus = QDBusConnection::sessionBus();
+    // Method calls are delivered to the thread we live in, which
+    // is not the GUI thread, using our own connection to the bus
+    QDBusConnection &bus = m_bus;
+
+    if (!bus.isConnected()) {
+        qCWarning(NOTIFICATIONS,
+                  "Failed to connect to the session bus: \"%s\"",
+                  qPrintable(bus.lastError().message()));
+        return false;
+    }
 
     if (!bus.registerObject(servicePath, this)) {
         qCWarning(NOTIFICATIONS,
@@ -103,14 +122,60 @@ bool NotificationsDaemon::registerService()
 
 void NotificationsDaemon::unregisterService()
 {
-    QDBusConnection bus = QDBusConnection::sessionBus();
-    bus.unregisterObject(servicePath);
-    bus.unregisterService(serviceName);
+    m_bus.unregisterObject(servicePath);
+    m_bus.unregisterService(serviceName);
+}
+
+bool NotificationsDaemon::isOpen(uint id) const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_notifications.contains(id);
+}
+
+QSharedPointer<NotificationsImageStore> NotificationsDaemon::imageStore() const
+{
+    return m_imageStore;
+}
+
+QString NotificationsDaemon::imageSource(uint id) const
+{
+    // Images are identified by content, so that notifications with
+    // the same image share it and a different image is a different
+    // source, no need to force reloading
+    quint64 key;
+    if (m_imageStore->findKey(id, &key))
+        return QStringLiteral("image://notifications/image/%1").arg(key, 16, 16, QLatin1Char('0'));
+
+    // Otherwise icons in order of preference
+    QStringList iconNames;
+    QMutexLocker locker(&m_mutex);
+    QHash<uint, NotificationRecord>::const_iterator it = m_notifications.constFind(id);
+    if (it != m_notifications.constEnd()) {
+        if (!it->iconName.isEmpty())
+            iconNames.append(it->iconName);
+        if (!it->entryIconName.isEmpty())
+            iconNames.append(it->entryIconName);
+    }
+    locker.unlock();
+    return iconSource(iconNames);
+}
+
+QString NotificationsDaemon::iconSource(const QStringList &iconNames)
+{
+    QString source = QStringLiteral("image://notifications/icon");
+    Q_FOREACH (const QString &iconName, iconNames)
+        source += QLatin1Char('/') + QString::fromLatin1(QUrl::toPercentEncoding(iconName));
+    return source;
+}
+
+NotificationsRateLimiter *NotificationsDaemon::rateLimiter() const
+{
+    return m_rateLimiter;
 }
 
-NotificationImage *NotificationsDaemon::imageFor(uint id) const
+NotificationsHistory *NotificationsDaemon::history()
 {
-    return m_images.value(id);
+    return &m_history;
 }
 
 uint NotificationsDaemon::Notify(const QString &appName, uint replacesId,
@@ -119,22 +184,52 @@ uint NotificationsDaemon::Notify(const QString &appName, uint replacesId,
                                  const QStringList &actions,
                                  const QVariantMap &hints, int timeout)
 {
+    // We are called on the ingest thread, the lock protects our
+    // bookkeeping from the GUI thread closing notifications and
+    // is never held while decoding images
+    QMutexLocker locker(&m_mutex);
+
     // Don't create a new notification if it comes from the same source
-    if (m_notifications.values().contains(appName + summary))
-        replacesId = m_notifications.key(appName + summary);
+    QHash<QPair<QString, QString>, uint>::const_iterator it =
+            m_sourceIds.constFind(qMakePair(appName, summary));
+    if (it != m_sourceIds.constEnd())
+        replacesId = it.value();
+
+    // Some applications (mostly media players and chat clients) will send
+    // too many notifications, once over the limit we update their latest
+    // notification instead of creating a new one, or drop the notification
+    // when it was already closed; critical notifications are never limited
+    const QString source = hints.contains(QStringLiteral("desktop-entry"))
+            ? hints[QStringLiteral("desktop-entry")].toString() : appName;
+    const bool isCritical = hints.value(QStringLiteral("urgency")).toInt() == 2;
+    QString realSummary = summary;
+    int coalesced = 0;
+    if (!m_notifications.contains(replacesId) && !isCritical &&
+            !m_rateLimiter->acquire(source)) {
+        const uint latestId = m_latestIds.value(source);
+        QHash<uint, NotificationRecord>::const_iterator latest = m_notifications.constFind(latestId);
+        if (latest == m_notifications.constEnd()) {
+            // There is nothing the notification could be merged into,
+            // return 0 which never identifies a notification so that
+            // replacing it later creates a new one
+            qCDebug(NOTIFICATIONS) << "Dropping notification from" << source;
+            m_rateLimiter->recordDropped(source);
+            return 0;
+        }
+
+        qCDebug(NOTIFICATIONS) << "Coalescing notification from" << source
+                               << "into" << latestId;
+        m_rateLimiter->recordCoalesced(source);
+        replacesId = latestId;
+        coalesced = latest->coalesced + 1;
+        realSummary = tr("%1 (+%n more)", "", coalesced).arg(summary);
+    }
+
+    locker.unlock();
 
     // Calculate identifier
     uint id = replacesId > 0 ? replacesId : nextId();
 
-    // Some applications (mostly media players) will send too many notifications,
-    // for them we want to replace an older notification (if applicable)
-    if (m_spamApplications.contains(appName)) {
-        if (m_replaceableNotifications.contains(appName))
-            id = m_replaceableNotifications.value(appName);
-        else
-            m_replaceableNotifications.insert(appName, id);
-    }
-
     qCDebug(NOTIFICATIONS)
             << "Notification:"
             << "ID =" << id
@@ -154,32 +249,34 @@ uint NotificationsDaemon::Notify(const QString &appName, uint replacesId,
     int totalLength = summary.length() + body.length();
     timeout = 2000 + qMax(60000 * totalLength / averageWordLength / wordPerMinute, 3000);
 
-    // Notification image
-    NotificationImage *notificationImage = new NotificationImage();
-    if (m_images.contains(id))
-        delete m_images.take(id);
-    m_images[id] = notificationImage;
-    notificationImage->iconName = appIcon;
+    // Notification record
+    NotificationRecord notification;
+    notification.appName = appName;
+    notification.summary = summary;
+    notification.source = source;
+    notification.iconName = appIcon;
+    notification.coalesced = coalesced;
 
     // Fetch the image hint (we also support the obsolete icon_data hint which
     // is still used by applications compatible with the specification version
+    QImage image;
     if (hints.contains(QStringLiteral("image_data")))
-        notificationImage->image.convertFromImage(decodeImageHint(hints["image_data"].value<QDBusArgument>()));
+        image = decodeImageHint(hints["image_data"].value<QDBusArgument>());
     else if (hints.contains(QStringLiteral("image-data")))
-        notificationImage->image.convertFromImage(decodeImageHint(hints["image-data"].value<QDBusArgument>()));
+        image = decodeImageHint(hints["image-data"].value<QDBusArgument>());
     else if (hints.contains(QStringLiteral("image_path")))
-        notificationImage->image = QPixmap(hints["image_path"].toString());
+        image = QImage(hints["image_path"].toString());
     else if (hints.contains(QStringLiteral("image-path")))
-        notificationImage->image = QPixmap(hints["image-path"].toString());
+        image = QImage(hints["image-path"].toString());
     else if (hints.contains(QStringLiteral("icon_data")))
-        notificationImage->image.convertFromImage(decodeImageHint(hints["icon_data"].value<QDBusArgument>()));
+        image = decodeImageHint(hints["icon_data"].value<QDBusArgument>());
+    m_imageStore->insert(id, image);
 
     // Retrieve icon from desktop entry, if any
     if (hints.contains(QStringLiteral("desktop-entry"))) {
-        QString fileName = QStandardPaths::locate(QStandardPaths::ApplicationsLocation,
-                                                  hints[QStringLiteral("desktop-entry")].toString());
-        QSettings desktopEntry(fileName, QSettings::IniFormat);
-        notificationImage->entryIconName = desktopEntry.value(QStringLiteral("Icon"), appIcon).toString();
+        const QString iconName = DesktopEntryIconResolver::instance()->iconName(
+                    hints[QStringLiteral("desktop-entry")].toString());
+        notification.entryIconName = iconName.isEmpty() ? appIcon : iconName;
     }
 
     // Create actions property map
@@ -192,25 +289,61 @@ uint NotificationsDaemon::Notify(const QString &appName, uint replacesId,
     }
 
     // Create notification
-    m_notifications.insert(id, appName + summary);
-    bool hasIcon = !notificationImage->image.isNull() ||
-            !notificationImage->iconName.isEmpty() ||
-            !notificationImage->entryIconName.isEmpty();
-    Q_EMIT m_parent->notificationReceived(id, realAppName, appIcon, hasIcon,
-                                          summary, body, actionsList,
-                                          isPersistent, timeout, hints);
+    locker.relock();
+    insertNotification(id, notification);
+    locker.unlock();
+
+    // Image data was decoded already and can be large, don't
+    // copy it over to QML
+    QVariantMap realHints = hints;
+    realHints.remove(QStringLiteral("image-data"));
+    realHints.remove(QStringLiteral("image_data"));
+    realHints.remove(QStringLiteral("icon_data"));
+
+    // Hand the notification over to the GUI thread
+    NotificationsEvent event;
+    event.type = NotificationsEvent::Received;
+    event.id = id;
+    event.appName = realAppName;
+    event.appIcon = appIcon;
+    event.hasIcon = !image.isNull() ||
+            !notification.iconName.isEmpty() ||
+            !notification.entryIconName.isEmpty();
+    event.summary = realSummary;
+    event.body = body;
+    event.actions = actionsList;
+    event.isPersistent = isPersistent;
+    event.timeout = timeout;
+    event.hints = realHints;
+
+    // Record it in the history, bubbles show the body as
+    // summary when the latter is empty and so do we
+    NotificationsHistoryRecord record;
+    record.id = id;
+    record.timestamp = QDateTime::currentMSecsSinceEpoch();
+    record.appName = realAppName;
+    record.iconName = appIcon.isEmpty() ? notification.entryIconName : appIcon;
+    record.summary = realSummary.isEmpty() ? body : realSummary;
+    record.body = realSummary.isEmpty() ? QString() : body;
+    recordHistory(record, &event);
+
+    m_parent->post(event);
 
     return id;
 }
 
 void NotificationsDaemon::CloseNotification(uint id)
 {
-    if (m_notifications.remove(id) > 0) {
-        if (m_images.contains(id))
-            delete m_images.take(id);
+    if (!removeNotification(id))
+        return;
 
-        Q_EMIT NotificationClosed(id, (uint)Notifications::CloseReasonByApplication);
-    }
+    Q_EMIT NotificationClosed(id, (uint)Notifications::CloseReasonByApplication);
+
+    NotificationsEvent event;
+    event.type = NotificationsEvent::Closed;
+    event.id = id;
+    event.reason = (uint)Notifications::CloseReasonByApplication;
+    m_parent->post(event);
 }
 
 QStringList NotificationsDaemon::GetCapabilities()
@@ -237,4 +370,96 @@ uint NotificationsDaemon::nextId()
     return (uint)m_idSeed->fetchAndAddAcquire(1);
 }
 
+void NotificationsDaemon::insertNotification(uint id, const NotificationRecord &record)
+{
+    // A replaced notification might come from another source
+    QHash<uint, NotificationRecord>::iterator it = m_notifications.find(id);
+    if (it != m_notifications.end()) {
+        const QPair<QString, QString> oldSource = qMakePair(it->appName, it->summary);
+        if (m_sourceIds.value(oldSource) == id)
+            m_sourceIds.remove(oldSource);
+        if (m_latestIds.value(it->source) == id)
+            m_latestIds.remove(it->source);
+    }
+
+    // Latest notifications are tracked only while open, which
+    // keeps the table as small as the notifications on screen
+    m_notifications.insert(id, record);
+    m_sourceIds.insert(qMakePair(record.appName, record.summary), id);
+    m_latestIds.insert(record.source, id);
+}
+
+bool NotificationsDaemon::removeNotification(uint id)
+{
+    QMutexLocker locker(&m_mutex);
+
+    QHash<uint, NotificationRecord>::iterator it = m_notifications.find(id);
+    if (it == m_notifications.end())
+        return false;
+
+    const QPair<QString, QString> source = qMakePair(it->appName, it->summary);
+    if (m_sourceIds.value(source) == id)
+        m_sourceIds.remove(source);
+    if (m_latestIds.value(it->source) == id)
+        m_latestIds.remove(it->source);
+    m_notifications.erase(it);
+    locker.unlock();
+
+    m_imageStore->remove(id);
+
+    return true;
+}
+
+void NotificationsDaemon::recordHistory(const NotificationsHistoryRecord &record, NotificationsEvent *event)
+{
+    // Replaced and coalesced notifications update their record
+    const int index = m_history.indexOf(record.id);
+    if (index >= 0) {
+        if (m_history.update(index, record)) {
+            event->historyChange = NotificationsEvent::HistoryUpdated;
+            event->historyIndex = index;
+        }
+    } else if (m_history.append(record)) {
+        event->historyChange = NotificationsEvent::HistoryAppended;
+        event->historyIndex = m_history.count() - 1;
+    }
+
+    // Keep the history within limits, this is rare enough
+    // that the view can afford being reset
+    if (m_history.needsCompaction()) {
+        m_history.compact();
+        event->historyChange = NotificationsEvent::HistoryReset;
+    }
+
+    event->historyCount = m_history.count();
+    event->historyRevision = m_history.revision();
+}
+
+void NotificationsDaemon::removeHistory(int index, quint64 revision)
+{
+    // The record might have been moved by a compaction meanwhile
+    if (revision != m_history.revision() || !m_history.remove(index))
+        return;
+
+    NotificationsEvent event;
+    event.type = NotificationsEvent::HistoryChanged;
+    event.historyChange = NotificationsEvent::HistoryRemoved;
+    event.historyIndex = index;
+    event.historyCount = m_history.count();
+    event.historyRevision = m_history.revision();
+    m_parent->post(event);
+}
+
+void NotificationsDaemon::clearHistory()
+{
+    m_history.clear();
+
+    NotificationsEvent event;
+    event.type = NotificationsEvent::HistoryChanged;
+    event.historyChange = NotificationsEvent::HistoryReset;
+    event.historyCount = m_history.count();
+    event.historyRevision = m_history.revision();
+    m_parent->post(event);
+}
+
 #include "moc_notificationsdaemon.cpp"
@@ -27,20 +27,33 @@
 #ifndef NOTIFICATIONSDAEMON_H
 #define NOTIFICATIONSDAEMON_H
 
+#include <QtCore/QHash>
+#include <QtCore/QMutex>
 #include <QtCore/QObject>
-#include <QtCore/QSet>
+#include <QtCore/QPair>
+#include <QtCore/QSharedPointer>
 #include <QtCore/QLoggingCategory>
-#include <QtGui/QPixmap>
+#include <QtDBus/QDBusConnection>
+
+#include "notificationshistory.h"
+#include "notificationsimagestore.h"
 
 class QAtomicInt;
 class Notifications;
+struct NotificationsEvent;
+class NotificationsRateLimiter;
 
 Q_DECLARE_LOGGING_CATEGORY(NOTIFICATIONS)
 
-struct NotificationImage {
-    QPixmap image;
+struct NotificationRecord {
+    NotificationRecord() : coalesced(0) {}
+
+    QString appName;
+    QString summary;
+    QString source;
     QString iconName;
     QString entryIconName;
+    int coalesced;
 };
 
 class NotificationsDaemon : public QObject
@@ -53,7 +66,14 @@ public:
     bool registerService();
     void unregisterService();
 
-    NotificationImage *imageFor(uint id) const;
+    bool isOpen(uint id) const;
+    QSharedPointer<NotificationsImageStore> imageStore() const;
+    QString imageSource(uint id) const;
+
+    static QString iconSource(const QStringList &iconNames);
+    NotificationsRateLimiter *rateLimiter() const;
+
+    NotificationsHistory *history();
 
     uint Notify(const QString &appName, uint replacesId, const QString &appIcon,
                 const QString &summary, const QString &body, const QStringList &actions,
@@ -71,17 +91,30 @@ Q_SIGNALS:
 
 private:
     Notifications *m_parent;
+    QDBusConnection m_bus;
+    mutable QMutex m_mutex;
     QAtomicInt *m_idSeed;
     bool m_valid;
     bool m_active;
-    QSet<QString> m_spamApplications;
-    QHash<QString, uint> m_replaceableNotifications;
-    QHash<uint, QString> m_notifications;
-    QHash<uint, NotificationImage *> m_images;
+    NotificationsRateLimiter *m_rateLimiter;
+    QHash<QString, uint> m_latestIds;
+    QHash<uint, NotificationRecord> m_notifications;
+    QHash<QPair<QString, QString>, uint> m_sourceIds;
+    QSharedPointer<NotificationsImageStore> m_imageStore;
+    NotificationsHistory m_history;
 
     uint nextId();
 
+    void insertNotification(uint id, const NotificationRecord &record);
+    bool removeNotification(uint id);
+
+    void recordHistory(const NotificationsHistoryRecord &record, NotificationsEvent *event);
+
     friend class Notifications;
+
+private Q_SLOTS:
+    void removeHistory(int index, quint64 revision);
+    void clearHistory();
 };
 
 #endif // NOTIFICATIONSDAEMON_H
@@ -0,0 +1,647 @@
+/****************************************************************************
+ * This file is part of Hawaii.
+ *
+ * Copyright (C) 2016 Pier Luigi Fiorini
+ *
+ * Author(s):
+ *    Pier Luigi Fiorini <pierluigi.fiorini@gmail.com>
+ *
+ * $BEGIN_LICENSE:LGPL2.1+$
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * $END_LICENSE$
+ ***************************************************************************/
+
+#include <QtCore/QDataStream>
+#include <QtCore/QDateTime>
+#include <QtCore/QDir>
+
+#include "notificationsdaemon.h"
+#include "notificationshistory.h"
+
+static const quint32 dataMagic = 0x484e4844;  // HNHD
+static const quint32 indexMagic = 0x484e4849; // HNHI
+static const quint32 formatVersion = 2;
+static const qint64 headerSize = 16;
+static const qint64 indexEntrySize = 16;
+static const quint64 removedFlag = Q_UINT64_C(1) << 63;
+
+// Data records either hold a notification, possibly superseding the
+// record at the target offset, or remove the record at the target
+static const quint8 recordKind = 0;
+static const quint8 tombstoneKind = 1;
+
+static const QFile::Permissions privatePermissions = QFile::ReadOwner | QFile::WriteOwner;
+
+static const int defaultMaximumCount = 5000;
+static const int defaultMaximumAge = 30;
+
+static void writeHeader(QFile *file, quint32 magic, quint64 generation)
+{
+    file->resize(0);
+    file->seek(0);
+
+    QDataStream stream(file);
+    stream << magic << formatVersion << generation;
+}
+
+static bool readHeader(QFile *file, quint32 magic, quint64 *generation)
+{
+    if (file->size() < headerSize)
+        return false;
+
+    file->seek(0);
+
+    QDataStream stream(file);
+    quint32 fileMagic, version;
+    stream >> fileMagic >> version >> *generation;
+    return stream.status() == QDataStream::Ok &&
+            fileMagic == magic && version == formatVersion;
+}
+
+static QByteArray serializeRecord(const NotificationsHistoryRecord &record,
+                                  quint8 kind = recordKind, quint64 target = 0)
+{
+    QByteArray payload;
+    QDataStream stream(&payload, QIODevice::WriteOnly);
+    stream.setVersion(QDataStream::Qt_5_6);
+    stream << quint32(0) << kind << target
+           << quint32(record.id) << record.timestamp
+           << record.appName << record.iconName
+           << record.summary << record.body;
+
+    // Length prefix doesn't include itself
+    stream.device()->seek(0);
+    stream << quint32(payload.size() - sizeof(quint32));
+    return payload;
+}
+
+static bool deserializeRecord(QDataStream &stream, quint8 *kind, quint64 *target,
+                              NotificationsHistoryRecord *record)
+{
+    // Follows the length prefix
+    quint32 id;
+    stream >> *kind >> *target >> id >> record->timestamp
+           >> record->appName >> record->iconName
+           >> record->summary >> record->body;
+    if (stream.status() != QDataStream::Ok)
+        return false;
+
+    record->id = id;
+    return true;
+}
+
+NotificationsHistory::NotificationsHistory()
+    : m_generation(0)
+    , m_slots(0)
+    , m_revision(0)
+    , m_maximumCount(defaultMaximumCount)
+    , m_maximumAge(defaultMaximumAge)
+{
+}
+
+bool NotificationsHistory::open(const QString &path)
+{
+    QMutexLocker writeLocker(&m_writeMutex);
+    QMutexLocker locker(&m_mutex);
+
+    closeFiles();
+    m_sessionSlots.clear();
+    m_revision++;
+
+    if (!QDir().mkpath(path)) {
+        qCWarning(NOTIFICATIONS) << "Unable to create history directory" << path;
+        return false;
+    }
+
+    // Notifications often carry private messages
+    if (!QFile::setPermissions(path, QFile::ReadOwner | QFile::WriteOwner | QFile::ExeOwner))
+        qCWarning(NOTIFICATIONS) << "Unable to restrict access to" << path;
+
+    m_path = path;
+    if (!openFiles())
+        return false;
+
+    qCDebug(NOTIFICATIONS) << "History has" << m_entries.size() << "notifications";
+
+    if (isCompactionNeeded()) {
+        locker.unlock();
+        compactFiles();
+    }
+
+    return true;
+}
+
+void NotificationsHistory::close()
+{
+    QMutexLocker writeLocker(&m_writeMutex);
+    QMutexLocker locker(&m_mutex);
+    closeFiles();
+}
+
+int NotificationsHistory::maximumCount() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_maximumCount;
+}
+
+void NotificationsHistory::setMaximumCount(int count)
+{
+    QMutexLocker locker(&m_mutex);
+    m_maximumCount = qMax(1, count);
+}
+
+int NotificationsHistory::maximumAge() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_maximumAge;
+}
+
+void NotificationsHistory::setMaximumAge(int days)
+{
+    QMutexLocker locker(&m_mutex);
+    m_maximumAge = qMax(1, days);
+}
+
+int NotificationsHistory::count() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_entries.size();
+}
+
+quint64 NotificationsHistory::revision() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_revision;
+}
+
+int NotificationsHistory::indexOf(uint id) const
+{
+    QMutexLocker locker(&m_mutex);
+
+    // Only records appended since the history was opened are
+    // looked up, identifiers are reused across sessions
+    QHash<uint, quint32>::const_iterator it = m_sessionSlots.constFind(id);
+    if (it == m_sessionSlots.constEnd())
+        return -1;
+
+    // Entries are sorted by slot
+    int first = 0, last = m_entries.size() - 1;
+    while (first <= last) {
+        const int middle = (first + last) / 2;
+        const quint32 slot = m_entries.at(middle).slot;
+        if (slot == it.value())
+            return middle;
+        if (slot < it.value())
+            first = middle + 1;
+        else
+            last = middle - 1;
+    }
+
+    return -1;
+}
+
+bool NotificationsHistory::append(const NotificationsHistoryRecord &record)
+{
+    QMutexLocker writeLocker(&m_writeMutex);
+    QMutexLocker locker(&m_mutex);
+
+    if (!m_data.isOpen())
+        return false;
+
+    // Data goes first, a record without an index entry is just ignored
+    quint64 offset;
+    if (!appendData(serializeRecord(record), &offset))
+        return false;
+
+    if (!writeIndexEntry(m_slots, offset, record.timestamp))
+        return false;
+
+    Entry entry;
+    entry.offset = offset;
+    entry.timestamp = record.timestamp;
+    entry.slot = m_slots++;
+    m_entries.append(entry);
+    m_sessionSlots.insert(record.id, entry.slot);
+    return true;
+}
+
+bool NotificationsHistory::update(int index, const NotificationsHistoryRecord &record)
+{
+    QMutexLocker writeLocker(&m_writeMutex);
+    QMutexLocker locker(&m_mutex);
+
+    if (!m_data.isOpen() || index < 0 || index >= m_entries.size())
+        return false;
+
+    // The new record is appended and the index entry points to it,
+    // it also points to the old one so that a rebuilt index doesn't
+    // list both; compaction drops the old one
+    Entry &entry = m_entries[index];
+    quint64 offset;
+    if (!appendData(serializeRecord(record, recordKind, entry.offset), &offset))
+        return false;
+
+    if (!writeIndexEntry(entry.slot, offset, record.timestamp))
+        return false;
+
+    entry.offset = offset;
+    entry.timestamp = record.timestamp;
+    return true;
+}
+
+bool NotificationsHistory::read(int first, int count, quint64 revision,
+                                QVector<NotificationsHistoryRecord> *records)
+{
+    QMutexLocker locker(&m_mutex);
+
+    // Positions are meaningless for another revision
+    if (!m_data.isOpen() || first < 0 || revision != m_revision)
+        return false;
+
+    const int last = qMin(first + count, m_entries.size());
+    records->reserve(qMax(0, last - first));
+    for (int i = first; i < last; i++) {
+        NotificationsHistoryRecord record;
+
+        m_data.seek(m_entries.at(i).offset);
+        QDataStream stream(&m_data);
+        stream.setVersion(QDataStream::Qt_5_6);
+        quint32 length;
+        quint8 kind;
+        quint64 target;
+        stream >> length;
+        if (!deserializeRecord(stream, &kind, &target, &record) || kind != recordKind) {
+            qCWarning(NOTIFICATIONS) << "Corrupted history record" << i;
+            record = NotificationsHistoryRecord();
+        }
+
+        records->append(record);
+    }
+
+    return true;
+}
+
+bool NotificationsHistory::remove(int index)
+{
+    QMutexLocker writeLocker(&m_writeMutex);
+    QMutexLocker locker(&m_mutex);
+
+    if (!m_data.isOpen() || index < 0 || index >= m_entries.size())
+        return false;
+
+    // The tombstone keeps the record removed should the index be rebuilt
+    const Entry &entry = m_entries.at(index);
+    quint64 offset;
+    if (!appendData(serializeRecord(NotificationsHistoryRecord(), tombstoneKind, entry.offset), &offset))
+        return false;
+    if (!writeIndexEntry(entry.slot, entry.offset | removedFlag, entry.timestamp))
+        return false;
+
+    m_entries.remove(index);
+    m_revision++;
+    return true;
+}
+
+void NotificationsHistory::clear()
+{
+    QMutexLocker writeLocker(&m_writeMutex);
+    QMutexLocker locker(&m_mutex);
+
+    if (m_data.isOpen())
+        reset();
+}
+
+bool NotificationsHistory::needsCompaction() const
+{
+    QMutexLocker locker(&m_mutex);
+    return isCompactionNeeded();
+}
+
+bool NotificationsHistory::compact()
+{
+    QMutexLocker writeLocker(&m_writeMutex);
+    return compactFiles();
+}
+
+bool NotificationsHistory::openFiles()
+{
+    m_data.setFileName(m_path + QStringLiteral("/history.dat"));
+    m_index.setFileName(m_path + QStringLiteral("/history.idx"));
+
+    if (!m_data.open(QFile::ReadWrite) || !m_index.open(QFile::ReadWrite)) {
+        qCWarning(NOTIFICATIONS) << "Unable to open history:"
+                                 << m_data.errorString() << m_index.errorString();
+        closeFiles();
+        return false;
+    }
+
+    m_data.setPermissions(privatePermissions);
+    m_index.setPermissions(privatePermissions);
+
+    if (!load()) {
+        closeFiles();
+        return false;
+    }
+
+    return true;
+}
+
+void NotificationsHistory::closeFiles()
+{
+    m_data.close();
+    m_index.close();
+    m_entries.clear();
+    m_slots = 0;
+}
+
+bool NotificationsHistory::isCompactionNeeded() const
+{
+    if (m_entries.isEmpty())
+        return m_slots > 0;
+
+    // Allow some slack to avoid compacting after every notification
+    const qint64 cutoff = QDateTime::currentMSecsSinceEpoch() - qint64(m_maximumAge) * 24 * 3600 * 1000;
+    const int removed = m_slots - m_entries.size();
+    return m_entries.size() > m_maximumCount + m_maximumCount / 4 ||
+            removed > qMax(64, m_entries.size() / 4) ||
+            m_entries.first().timestamp < cutoff;
+}
+
+bool NotificationsHistory::compactFiles()
+{
+    // Called with the write lock held, writers can't change anything
+    // so the lock is only taken to snapshot and swap the files and
+    // readers are not blocked while records are copied
+    QVector<Entry> entries;
+    QString dataFileName, indexFileName;
+    quint64 generation;
+    {
+        QMutexLocker locker(&m_mutex);
+
+        if (!m_data.isOpen())
+            return false;
+
+        // Keep the most recent records within the retention limits
+        const qint64 cutoff = QDateTime::currentMSecsSinceEpoch() - qint64(m_maximumAge) * 24 * 3600 * 1000;
+        int first = qMax(0, m_entries.size() - m_maximumCount);
+        while (first < m_entries.size() && m_entries.at(first).timestamp < cutoff)
+            first++;
+
+        entries = m_entries.mid(first);
+        dataFileName = m_data.fileName();
+        indexFileName = m_index.fileName();
+
+        // A new generation tells apart files from different compactions,
+        // should we crash before both are renamed the index is rebuilt
+        generation = m_generation + 1;
+    }
+
+    QFile source(dataFileName);
+    QFile data(dataFileName + QStringLiteral(".new"));
+    QFile index(indexFileName + QStringLiteral(".new"));
+    if (!source.open(QFile::ReadOnly) ||
+            !data.open(QFile::ReadWrite | QFile::Truncate) ||
+            !index.open(QFile::ReadWrite | QFile::Truncate)) {
+        qCWarning(NOTIFICATIONS) << "Unable to compact history:" << source.errorString()
+                                 << data.errorString() << index.errorString();
+        return false;
+    }
+
+    data.setPermissions(privatePermissions);
+    index.setPermissions(privatePermissions);
+
+    writeHeader(&data, dataMagic, generation);
+    writeHeader(&index, indexMagic, generation);
+
+    // Slots are renumbered, keep track of those appended in this session
+    QHash<quint32, quint32> slotMap;
+    quint32 slot = 0;
+
+    // Records are written again, what they superseded is gone
+    QDataStream indexStream(&index);
+    for (int i = 0; i < entries.size(); i++) {
+        const Entry &entry = entries.at(i);
+
+        source.seek(entry.offset);
+        QDataStream stream(&source);
+        stream.setVersion(QDataStream::Qt_5_6);
+        NotificationsHistoryRecord record;
+        quint32 length;
+        quint8 kind;
+        quint64 target;
+        stream >> length;
+        if (!deserializeRecord(stream, &kind, &target, &record) || kind != recordKind)
+            continue;
+
+        const quint64 offset = data.pos();
+        data.write(serializeRecord(record));
+        indexStream << offset << entry.timestamp;
+        slotMap.insert(entry.slot, slot++);
+    }
+
+    const bool ok = data.flush() && index.flush();
+    data.close();
+    index.close();
+    source.close();
+    if (!ok) {
+        qCWarning(NOTIFICATIONS) << "Unable to compact history:"
+                                 << data.errorString() << index.errorString();
+        data.remove();
+        index.remove();
+        return false;
+    }
+
+    QMutexLocker locker(&m_mutex);
+
+    const int oldCount = m_entries.size();
+    closeFiles();
+    QFile::remove(dataFileName);
+    data.rename(dataFileName);
+    QFile::remove(indexFileName);
+    index.rename(indexFileName);
+
+    QHash<uint, quint32>::iterator it = m_sessionSlots.begin();
+    while (it != m_sessionSlots.end()) {
+        if (slotMap.contains(it.value())) {
+            it.value() = slotMap.value(it.value());
+            ++it;
+        } else {
+            it = m_sessionSlots.erase(it);
+        }
+    }
+    m_revision++;
+
+    if (!openFiles())
+        return false;
+
+    qCDebug(NOTIFICATIONS) << "History compacted from" << oldCount
+                           << "to" << m_entries.size() << "notifications";
+    return true;
+}
+
+bool NotificationsHistory::load()
+{
+    m_entries.clear();
+    m_slots = 0;
+
+    if (!readHeader(&m_data, dataMagic, &m_generation)) {
+        if (m_data.size() > 0)
+            qCWarning(NOTIFICATIONS) << "Discarding invalid history" << m_data.fileName();
+        return reset();
+    }
+
+    quint64 indexGeneration = 0;
+    if (!readHeader(&m_index, indexMagic, &indexGeneration) || indexGeneration != m_generation)
+        return rebuildIndex();
+
+    // Read the whole index at once, it's small enough
+    m_index.seek(headerSize);
+    const QByteArray buffer = m_index.readAll();
+    QDataStream stream(buffer);
+    const qint64 dataSize = m_data.size();
+    const int slots = buffer.size() / indexEntrySize;
+    m_entries.reserve(slots);
+    for (int i = 0; i < slots; i++) {
+        quint64 offset;
+        qint64 timestamp;
+        stream >> offset >> timestamp;
+
+        // Stop at entries pointing past the data we have
+        if (qint64(offset & ~removedFlag) + qint64(sizeof(quint32)) > dataSize)
+            break;
+
+        m_slots++;
+        if (offset & removedFlag)
+            continue;
+
+        Entry entry;
+        entry.offset = offset;
+        entry.timestamp = timestamp;
+        entry.slot = i;
+        m_entries.append(entry);
+    }
+
+    // Drop a partially written entry
+    if (m_index.size() != headerSize + m_slots * indexEntrySize)
+        m_index.resize(headerSize + m_slots * indexEntrySize);
+
+    return true;
+}
+
+bool NotificationsHistory::reset()
+{
+    m_entries.clear();
+    m_sessionSlots.clear();
+    m_revision++;
+    m_slots = 0;
+    m_generation = QDateTime::currentMSecsSinceEpoch();
+    writeHeader(&m_data, dataMagic, m_generation);
+    writeHeader(&m_index, indexMagic, m_generation);
+    return m_data.flush() && m_index.flush();
+}
+
+bool NotificationsHistory::rebuildIndex()
+{
+    qCWarning(NOTIFICATIONS) << "Rebuilding history index";
+
+    writeHeader(&m_index, indexMagic, m_generation);
+
+    // Replay records until the end or the first truncated one,
+    // updates take the position of what they supersede and
+    // tombstones remove their target; positions are stored plus
+    // one so that offsets we don't know about map to -1
+    QVector<Entry> entries;
+    QHash<quint64, int> positions;
+    const qint64 dataSize = m_data.size();
+    qint64 offset = headerSize;
+    while (offset + qint64(sizeof(quint32)) <= dataSize) {
+        m_data.seek(offset);
+        QDataStream stream(&m_data);
+        stream.setVersion(QDataStream::Qt_5_6);
+        NotificationsHistoryRecord record;
+        quint32 length;
+        quint8 kind;
+        quint64 target;
+        stream >> length;
+        if (offset + qint64(sizeof(quint32)) + length > dataSize)
+            break;
+        if (!deserializeRecord(stream, &kind, &target, &record))
+            break;
+
+        const int position = positions.take(target) - 1;
+        if (kind == tombstoneKind) {
+            if (position >= 0)
+                entries[position].offset = removedFlag;
+        } else if (position >= 0) {
+            entries[position].offset = offset;
+            entries[position].timestamp = record.timestamp;
+            positions.insert(offset, position + 1);
+        } else {
+            Entry entry;
+            entry.offset = offset;
+            entry.timestamp = record.timestamp;
+            entry.slot = 0;
+            entries.append(entry);
+            positions.insert(offset, entries.size());
+        }
+
+        offset += sizeof(quint32) + length;
+    }
+
+    if (offset < dataSize)
+        m_data.resize(offset);
+
+    Q_FOREACH (Entry entry, entries) {
+        if (entry.offset & removedFlag)
+            continue;
+
+        if (!writeIndexEntry(m_slots, entry.offset, entry.timestamp))
+            return false;
+
+        entry.slot = m_slots++;
+        m_entries.append(entry);
+    }
+
+    return m_index.flush();
+}
+
+bool NotificationsHistory::writeIndexEntry(quint32 slot, quint64 offset, qint64 timestamp)
+{
+    if (!m_index.seek(headerSize + slot * indexEntrySize)) {
+        qCWarning(NOTIFICATIONS) << "Unable to write history index:" << m_index.errorString();
+        return false;
+    }
+
+    QDataStream stream(&m_index);
+    stream << offset << timestamp;
+    if (stream.status() != QDataStream::Ok || !m_index.flush()) {
+        qCWarning(NOTIFICATIONS) << "Unable to write history index:" << m_index.errorString();
+        return false;
+    }
+
+    return true;
+}
+
+bool NotificationsHistory::appendData(const QByteArray &payload, quint64 *offset)
+{
+    *offset = m_data.size();
+    if (!m_data.seek(*offset) || m_data.write(payload) != payload.size() || !m_data.flush()) {
+        qCWarning(NOTIFICATIONS) << "Unable to write history:" << m_data.errorString();
+        return false;
+    }
+
+    return true;
+}
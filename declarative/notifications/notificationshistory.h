@@ -0,0 +1,126 @@
+/****************************************************************************
+ * This file is part of Hawaii.
+ *
+ * Copyright (C) 2016 Pier Luigi Fiorini
+ *
+ * Author(s):
+ *    Pier Luigi Fiorini <pierluigi.fiorini@gmail.com>
+ *
+ * $BEGIN_LICENSE:LGPL2.1+$
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * $END_LICENSE$
+ ***************************************************************************/
+
+#ifndef NOTIFICATIONSHISTORY_H
+#define NOTIFICATIONSHISTORY_H
+
+#include <QtCore/QFile>
+#include <QtCore/QHash>
+#include <QtCore/QMutex>
+#include <QtCore/QVector>
+
+struct NotificationsHistoryRecord {
+    NotificationsHistoryRecord() : id(0), timestamp(0) {}
+
+    uint id;
+    qint64 timestamp;
+    QString appName;
+    QString iconName;
+    QString summary;
+    QString body;
+};
+
+Q_DECLARE_TYPEINFO(NotificationsHistoryRecord, Q_MOVABLE_TYPE);
+
+/*
+ * Notifications are appended to a data file, an index file holds
+ * offset and timestamp of each record so that the history can be
+ * opened without reading the data and records read on demand.
+ * Updated records are appended again and point to the one they
+ * supersede, removed records get a tombstone in the data file and
+ * are flagged in the index; the data file alone is enough to
+ * rebuild the index.  Compaction drops them together with those
+ * exceeding the retention limits.
+ *
+ * Records are written by the ingest thread and read by the GUI
+ * thread, all methods are thread-safe.  Writers are serialized
+ * among themselves, readers only wait for the state to change and
+ * not for records being copied by a compaction.  The revision
+ * changes when records are moved to another position, that is
+ * when removing, clearing or compacting but not when appending
+ * or updating.
+ */
+class NotificationsHistory
+{
+public:
+    NotificationsHistory();
+
+    bool open(const QString &path);
+    void close();
+
+    int maximumCount() const;
+    void setMaximumCount(int count);
+
+    int maximumAge() const;
+    void setMaximumAge(int days);
+
+    int count() const;
+    quint64 revision() const;
+
+    int indexOf(uint id) const;
+
+    bool append(const NotificationsHistoryRecord &record);
+    bool update(int index, const NotificationsHistoryRecord &record);
+    bool read(int first, int count, quint64 revision,
+              QVector<NotificationsHistoryRecord> *records);
+    bool remove(int index);
+    void clear();
+
+    bool needsCompaction() const;
+    bool compact();
+
+private:
+    struct Entry {
+        quint64 offset;
+        qint64 timestamp;
+        quint32 slot;
+    };
+
+    QMutex m_writeMutex;
+    mutable QMutex m_mutex;
+    QString m_path;
+    QFile m_data;
+    QFile m_index;
+    quint64 m_generation;
+    quint32 m_slots;
+    QVector<Entry> m_entries;
+    QHash<uint, quint32> m_sessionSlots;
+    quint64 m_revision;
+    int m_maximumCount;
+    int m_maximumAge;
+
+    bool openFiles();
+    void closeFiles();
+    bool isCompactionNeeded() const;
+    bool compactFiles();
+    bool load();
+    bool reset();
+    bool rebuildIndex();
+    bool writeIndexEntry(quint32 slot, quint64 offset, qint64 timestamp);
+    bool appendData(const QByteArray &payload, quint64 *offset);
+};
+
+#endif // NOTIFICATIONSHISTORY_H
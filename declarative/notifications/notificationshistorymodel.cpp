@@ -0,0 +1,229 @@
+/****************************************************************************
+ * This file is part of Hawaii.
+ *
+ * Copyright (C) 2016 Pier Luigi Fiorini
+ *
+ * Author(s):
+ *    Pier Luigi Fiorini <pierluigi.fiorini@gmail.com>
+ *
+ * $BEGIN_LICENSE:LGPL2.1+$
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * $END_LICENSE$
+ ***************************************************************************/
+
+#include <QtCore/QDateTime>
+
+#include "notifications.h"
+#include "notificationsdaemon.h"
+#include "notificationshistorymodel.h"
+
+// Rows loaded at a time and pages kept in memory
+static const int pageSize = 50;
+static const int cachedPages = 8;
+
+NotificationsHistoryModel::NotificationsHistoryModel(NotificationsDaemon *daemon, QObject *parent)
+    : QAbstractListModel(parent)
+    , m_daemon(daemon)
+    , m_history(daemon->history())
+    , m_pages(cachedPages)
+    , m_count(0)
+    , m_revision(0)
+    , m_rows(0)
+    , m_sessionStart(QDateTime::currentMSecsSinceEpoch())
+{
+    // Nothing was received yet, the history can't change under us
+    m_count = m_history->count();
+    m_revision = m_history->revision();
+    m_rows = qMin(pageSize, m_count);
+}
+
+int NotificationsHistoryModel::count() const
+{
+    return m_count;
+}
+
+QHash<int, QByteArray> NotificationsHistoryModel::roleNames() const
+{
+    QHash<int, QByteArray> roles;
+    roles.insert(IdRole, "id");
+    roles.insert(AppNameRole, "appName");
+    roles.insert(AppIconRole, "appIcon");
+    roles.insert(SummaryRole, "summary");
+    roles.insert(BodyRole, "body");
+    roles.insert(TimestampRole, "timestamp");
+    roles.insert(HasIconRole, "hasIcon");
+    roles.insert(IconSourceRole, "iconSource");
+    return roles;
+}
+
+int NotificationsHistoryModel::rowCount(const QModelIndex &parent) const
+{
+    if (parent.isValid())
+        return 0;
+    return m_rows;
+}
+
+QVariant NotificationsHistoryModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= m_rows)
+        return QVariant();
+
+    const NotificationsHistoryRecord *item = record(index.row());
+    if (!item)
+        return QVariant();
+
+    // Images are available only while the notification is open, and
+    // identifiers are reused across sessions so check it's from this one
+    QString iconSource;
+    if (item->timestamp >= m_sessionStart && m_daemon->isOpen(item->id))
+        iconSource = m_daemon->imageSource(item->id);
+    else if (!item->iconName.isEmpty())
+        iconSource = NotificationsDaemon::iconSource(QStringList() << item->iconName);
+
+    switch (role) {
+    case IdRole:
+        return item->id;
+    case AppNameRole:
+        return item->appName;
+    case AppIconRole:
+        return item->iconName;
+    case SummaryRole:
+        return item->summary;
+    case BodyRole:
+        return item->body;
+    case TimestampRole:
+        return QDateTime::fromMSecsSinceEpoch(item->timestamp);
+    case HasIconRole:
+        return !iconSource.isEmpty();
+    case IconSourceRole:
+        return iconSource;
+    default:
+        break;
+    }
+
+    return QVariant();
+}
+
+bool NotificationsHistoryModel::canFetchMore(const QModelIndex &parent) const
+{
+    if (parent.isValid())
+        return false;
+    return m_rows < m_count;
+}
+
+void NotificationsHistoryModel::fetchMore(const QModelIndex &parent)
+{
+    if (parent.isValid())
+        return;
+
+    const int rows = qMin(pageSize, m_count - m_rows);
+    if (rows <= 0)
+        return;
+
+    beginInsertRows(QModelIndex(), m_rows, m_rows + rows - 1);
+    m_rows += rows;
+    endInsertRows();
+}
+
+void NotificationsHistoryModel::apply(const NotificationsEvent &event)
+{
+    switch (event.historyChange) {
+    case NotificationsEvent::HistoryAppended:
+        // The newest notification is the first row, only the page
+        // holding the last record in the history has changed
+        m_pages.remove(event.historyIndex / pageSize);
+        beginInsertRows(QModelIndex(), 0, 0);
+        m_count = event.historyCount;
+        m_rows++;
+        endInsertRows();
+        Q_EMIT countChanged();
+        break;
+    case NotificationsEvent::HistoryUpdated: {
+        m_pages.remove(event.historyIndex / pageSize);
+        const int row = m_count - 1 - event.historyIndex;
+        if (row >= 0 && row < m_rows)
+            Q_EMIT dataChanged(index(row), index(row));
+        break;
+    }
+    case NotificationsEvent::HistoryRemoved: {
+        const int row = m_count - 1 - event.historyIndex;
+        m_pages.clear();
+        m_revision = event.historyRevision;
+        if (row >= 0 && row < m_rows) {
+            beginRemoveRows(QModelIndex(), row, row);
+            m_count = event.historyCount;
+            m_rows--;
+            endRemoveRows();
+        } else {
+            m_count = event.historyCount;
+        }
+        Q_EMIT countChanged();
+        break;
+    }
+    case NotificationsEvent::HistoryReset:
+        beginResetModel();
+        m_pages.clear();
+        m_count = event.historyCount;
+        m_revision = event.historyRevision;
+        m_rows = qMin(qMax(m_rows, pageSize), m_count);
+        endResetModel();
+        Q_EMIT countChanged();
+        break;
+    default:
+        break;
+    }
+}
+
+void NotificationsHistoryModel::remove(int row)
+{
+    if (row < 0 || row >= m_rows)
+        return;
+
+    // Rows go away once the ingest thread is done with it
+    QMetaObject::invokeMethod(m_daemon, "removeHistory", Qt::QueuedConnection,
+                              Q_ARG(int, m_count - 1 - row),
+                              Q_ARG(quint64, m_revision));
+}
+
+void NotificationsHistoryModel::clear()
+{
+    QMetaObject::invokeMethod(m_daemon, "clearHistory", Qt::QueuedConnection);
+}
+
+const NotificationsHistoryRecord *NotificationsHistoryModel::record(int row) const
+{
+    // Rows are sorted from the newest, pages are numbered from the
+    // oldest record so that appending doesn't invalidate them
+    const int position = m_count - 1 - row;
+    const int page = position / pageSize;
+
+    // Records moved by the ingest thread are not read until we
+    // are told about it
+    QVector<NotificationsHistoryRecord> *records = m_pages.object(page);
+    if (!records) {
+        records = new QVector<NotificationsHistoryRecord>();
+        if (!m_history->read(page * pageSize, pageSize, m_revision, records)) {
+            delete records;
+            return Q_NULLPTR;
+        }
+        m_pages.insert(page, records);
+    }
+
+    const int offset = position - page * pageSize;
+    return offset < records->size() ? &records->at(offset) : Q_NULLPTR;
+}
+
+#include "moc_notificationshistorymodel.cpp"
@@ -0,0 +1,100 @@
+/****************************************************************************
+ * This file is part of Hawaii.
+ *
+ * Copyright (C) 2016 Pier Luigi Fiorini
+ *
+ * Author(s):
+ *    Pier Luigi Fiorini <pierluigi.fiorini@gmail.com>
+ *
+ * $BEGIN_LICENSE:LGPL2.1+$
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * $END_LICENSE$
+ ***************************************************************************/
+
+#ifndef NOTIFICATIONSHISTORYMODEL_H
+#define NOTIFICATIONSHISTORYMODEL_H
+
+#include <QtCore/QAbstractListModel>
+#include <QtCore/QCache>
+
+#include "notificationshistory.h"
+
+class NotificationsDaemon;
+struct NotificationsEvent;
+
+class NotificationsHistoryModel : public QAbstractListModel
+{
+    Q_OBJECT
+    Q_PROPERTY(int count READ count NOTIFY countChanged)
+    Q_ENUMS(Roles)
+public:
+    enum Roles {
+        IdRole = Qt::UserRole + 1,
+        AppNameRole,
+        AppIconRole,
+        SummaryRole,
+        BodyRole,
+        TimestampRole,
+        HasIconRole,
+        IconSourceRole
+    };
+
+    NotificationsHistoryModel(NotificationsDaemon *daemon, QObject *parent = 0);
+
+    /*!
+     * \brief Number of notifications in the history.
+     *
+     * Rows are loaded one page at a time as the view scrolls,
+     * so this might be more than rowCount().
+     */
+    int count() const;
+
+    QHash<int, QByteArray> roleNames() const;
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const;
+
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const;
+
+    bool canFetchMore(const QModelIndex &parent) const;
+    void fetchMore(const QModelIndex &parent);
+
+    /*!
+     * \brief Apply a change already written to the history.
+     *
+     * The history is written by the ingest thread, changes are
+     * applied in the same order as they happened.
+     */
+    void apply(const NotificationsEvent &event);
+
+    Q_INVOKABLE void remove(int row);
+    Q_INVOKABLE void clear();
+
+Q_SIGNALS:
+    void countChanged();
+
+private:
+    NotificationsDaemon *m_daemon;
+    NotificationsHistory *m_history;
+    mutable QCache<int, QVector<NotificationsHistoryRecord> > m_pages;
+    int m_count;
+    quint64 m_revision;
+    int m_rows;
+    qint64 m_sessionStart;
+
+    const NotificationsHistoryRecord *record(int row) const;
+};
+
+#endif // NOTIFICATIONSHISTORYMODEL_H
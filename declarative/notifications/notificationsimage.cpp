@@ -30,33 +30,240 @@
 
 #include "notificationsimage.h"
 
-inline void copyLineRGB32(QRgb *dst, const char *src, int width)
+#if defined(__SSE2__)
+#  include <emmintrin.h>
+#endif
+#if (defined(__x86_64__) || defined(__i386__)) && \
+    (defined(__clang__) || (defined(__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))))
+#  include <immintrin.h>
+#  define HAVE_AVX2_DISPATCH
+#endif
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#  include <arm_neon.h>
+#  define HAVE_NEON
+#endif
+
+/*
+ * Image hints are RGBA or RGB bytes, not premultiplied, while
+ * QImage::Format_ARGB32_Premultiplied and QImage::Format_RGB32
+ * are native endian 32-bit words.  Vectorized kernels assume the
+ * little endian BGRA memory layout.
+ */
+
+typedef void (*ConvertLineFunc)(QRgb *dst, const uchar *src, int width);
+
+static void convertLineRGBA_scalar(QRgb *dst, const uchar *src, int width)
+{
+    for (int i = 0; i < width; ++i, src += 4)
+        dst[i] = qPremultiply(qRgba(src[0], src[1], src[2], src[3]));
+}
+
+static void convertLineRGB_scalar(QRgb *dst, const uchar *src, int width)
+{
+    for (int i = 0; i < width; ++i, src += 3)
+        dst[i] = qRgb(src[0], src[1], src[2]);
+}
+
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+
+#if defined(__SSE2__)
+// Multiply 16-bit channels by alpha and divide by 255, rounding
+static inline __m128i premultiply_sse2(__m128i pixels)
+{
+    const __m128i colorMask = _mm_set_epi16(0, -1, -1, -1, 0, -1, -1, -1);
+    const __m128i alphaOne = _mm_set_epi16(255, 0, 0, 0, 255, 0, 0, 0);
+    const __m128i half = _mm_set1_epi16(0x80);
+
+    // RGBA to BGRA and alpha in every channel but alpha itself
+    pixels = _mm_shufflelo_epi16(pixels, _MM_SHUFFLE(3, 0, 1, 2));
+    pixels = _mm_shufflehi_epi16(pixels, _MM_SHUFFLE(3, 0, 1, 2));
+    __m128i alpha = _mm_shufflelo_epi16(pixels, _MM_SHUFFLE(3, 3, 3, 3));
+    alpha = _mm_shufflehi_epi16(alpha, _MM_SHUFFLE(3, 3, 3, 3));
+    alpha = _mm_or_si128(_mm_and_si128(alpha, colorMask), alphaOne);
+
+    __m128i t = _mm_add_epi16(_mm_mullo_epi16(pixels, alpha), half);
+    return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+}
+
+static void convertLineRGBA_sse2(QRgb *dst, const uchar *src, int width)
+{
+    const __m128i zero = _mm_setzero_si128();
+
+    int i = 0;
+    for (; i + 4 <= width; i += 4, src += 16) {
+        const __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src));
+        const __m128i lo = premultiply_sse2(_mm_unpacklo_epi8(pixels, zero));
+        const __m128i hi = premultiply_sse2(_mm_unpackhi_epi8(pixels, zero));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), _mm_packus_epi16(lo, hi));
+    }
+
+    convertLineRGBA_scalar(dst + i, src, width - i);
+}
+#endif
+
+#if defined(HAVE_AVX2_DISPATCH)
+__attribute__((target("avx2")))
+static inline __m256i premultiply_avx2(__m256i pixels)
 {
-    const char *end = src + width * 3;
-    for (; src != end; ++dst, src += 3)
-        * dst = qRgb(src[0], src[1], src[2]);
+    const __m256i colorMask = _mm256_set_epi16(0, -1, -1, -1, 0, -1, -1, -1,
+                                               0, -1, -1, -1, 0, -1, -1, -1);
+    const __m256i alphaOne = _mm256_set_epi16(255, 0, 0, 0, 255, 0, 0, 0,
+                                              255, 0, 0, 0, 255, 0, 0, 0);
+    const __m256i half = _mm256_set1_epi16(0x80);
+
+    pixels = _mm256_shufflelo_epi16(pixels, _MM_SHUFFLE(3, 0, 1, 2));
+    pixels = _mm256_shufflehi_epi16(pixels, _MM_SHUFFLE(3, 0, 1, 2));
+    __m256i alpha = _mm256_shufflelo_epi16(pixels, _MM_SHUFFLE(3, 3, 3, 3));
+    alpha = _mm256_shufflehi_epi16(alpha, _MM_SHUFFLE(3, 3, 3, 3));
+    alpha = _mm256_or_si256(_mm256_and_si256(alpha, colorMask), alphaOne);
+
+    __m256i t = _mm256_add_epi16(_mm256_mullo_epi16(pixels, alpha), half);
+    return _mm256_srli_epi16(_mm256_add_epi16(t, _mm256_srli_epi16(t, 8)), 8);
 }
 
-inline void copyLineARGB32(QRgb *dst, const char *src, int width)
+__attribute__((target("avx2")))
+static void convertLineRGBA_avx2(QRgb *dst, const uchar *src, int width)
 {
-    const char *end = src + width * 4;
-    for (; src != end; ++dst, src += 4)
-        * dst = qRgba(src[0], src[1], src[2], src[3]);
+    const __m256i zero = _mm256_setzero_si256();
+
+    // Unpacking and packing work on 128-bit lanes,
+    // so pixels come out in the original order
+    int i = 0;
+    for (; i + 8 <= width; i += 8, src += 32) {
+        const __m256i pixels = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src));
+        const __m256i lo = premultiply_avx2(_mm256_unpacklo_epi8(pixels, zero));
+        const __m256i hi = premultiply_avx2(_mm256_unpackhi_epi8(pixels, zero));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), _mm256_packus_epi16(lo, hi));
+    }
+
+    convertLineRGBA_scalar(dst + i, src, width - i);
+}
+
+__attribute__((target("avx2")))
+static void convertLineRGB_avx2(QRgb *dst, const uchar *src, int width)
+{
+    const __m128i shuffle = _mm_setr_epi8(2, 1, 0, -1, 5, 4, 3, -1,
+                                          8, 7, 6, -1, 11, 10, 9, -1);
+    const __m128i alpha = _mm_set1_epi32(int(0xff000000));
+
+    // Four pixels at a time, loading 16 bytes out of 12
+    // so stop before reading past the end of the line
+    int i = 0;
+    for (; (i + 4) * 3 + 4 <= width * 3; i += 4, src += 12) {
+        const __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i),
+                         _mm_or_si128(_mm_shuffle_epi8(pixels, shuffle), alpha));
+    }
+
+    convertLineRGB_scalar(dst + i, src, width - i);
+}
+#endif
+
+#if defined(HAVE_NEON)
+static void convertLineRGBA_neon(QRgb *dst, const uchar *src, int width)
+{
+    int i = 0;
+    for (; i + 8 <= width; i += 8, src += 32) {
+        const uint8x8x4_t rgba = vld4_u8(src);
+
+        // Exact division by 255 with rounding
+        uint8x8x4_t bgra;
+        uint16x8_t t;
+        t = vmull_u8(rgba.val[2], rgba.val[3]);
+        bgra.val[0] = vraddhn_u16(t, vrshrq_n_u16(t, 8));
+        t = vmull_u8(rgba.val[1], rgba.val[3]);
+        bgra.val[1] = vraddhn_u16(t, vrshrq_n_u16(t, 8));
+        t = vmull_u8(rgba.val[0], rgba.val[3]);
+        bgra.val[2] = vraddhn_u16(t, vrshrq_n_u16(t, 8));
+        bgra.val[3] = rgba.val[3];
+
+        vst4_u8(reinterpret_cast<uint8_t *>(dst + i), bgra);
+    }
+
+    convertLineRGBA_scalar(dst + i, src, width - i);
+}
+
+static void convertLineRGB_neon(QRgb *dst, const uchar *src, int width)
+{
+    int i = 0;
+    for (; i + 8 <= width; i += 8, src += 24) {
+        const uint8x8x3_t rgb = vld3_u8(src);
+
+        uint8x8x4_t bgra;
+        bgra.val[0] = rgb.val[2];
+        bgra.val[1] = rgb.val[1];
+        bgra.val[2] = rgb.val[0];
+        bgra.val[3] = vdup_n_u8(0xff);
+
+        vst4_u8(reinterpret_cast<uint8_t *>(dst + i), bgra);
+    }
+
+    convertLineRGB_scalar(dst + i, src, width - i);
+}
+#endif
+
+#endif // Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+
+static ConvertLineFunc resolveConvertLineRGBA()
+{
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+#  if defined(HAVE_AVX2_DISPATCH)
+    // Resolved during static initialization
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return convertLineRGBA_avx2;
+#  endif
+#  if defined(__SSE2__)
+    return convertLineRGBA_sse2;
+#  elif defined(HAVE_NEON)
+    return convertLineRGBA_neon;
+#  endif
+#endif
+    return convertLineRGBA_scalar;
+}
+
+static ConvertLineFunc resolveConvertLineRGB()
+{
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+#  if defined(HAVE_AVX2_DISPATCH)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return convertLineRGB_avx2;
+#  endif
+#  if defined(HAVE_NEON)
+    return convertLineRGB_neon;
+#  endif
+#endif
+    return convertLineRGB_scalar;
+}
+
+static const ConvertLineFunc convertLineRGBA = resolveConvertLineRGBA();
+static const ConvertLineFunc convertLineRGB = resolveConvertLineRGB();
+
+static void releasePixels(void *data)
+{
+    delete static_cast<QByteArray *>(data);
 }
 
 QImage decodeImageHint(const QDBusArgument &arg)
 {
-    int width, height, stride, hasAlpha, bitsPerSample, channels;
+    int width, height, stride, bitsPerSample, channels;
+    bool hasAlpha;
     QByteArray pixels;
 
-    // Decode hint
+    // Decode hint, the signature is (iiibiiay)
     arg.beginStructure();
     arg >> width >> height >> stride >> hasAlpha
         >> bitsPerSample >> channels >> pixels;
     arg.endStructure();
 
-    char *ptr, *end;
+    return decodeImageData(width, height, stride, hasAlpha,
+                           bitsPerSample, channels, pixels);
+}
 
+QImage decodeImageData(int width, int height, int stride, bool hasAlpha,
+                       int bitsPerSample, int channels, const QByteArray &pixels)
+{
     // Sanity check
     if ((width <= 0) || (width >= 2048) || (height <= 0) ||
             (height >= 2048) || (stride <= 0)) {
@@ -64,35 +271,74 @@ QImage decodeImageHint(const QDBusArgument &arg)
         return QImage();
     }
 
-    QImage::Format format = QImage::Format_Invalid;
-    void (*function)(QRgb *, const char *, int) = 0;
-    if (bitsPerSample == 8) {
-        if (channels == 4) {
-            format = QImage::Format_ARGB32;
-            function = copyLineARGB32;
-        } else if (channels == 3) {
-            format = QImage::Format_RGB32;
-            function = copyLineRGB32;
-        }
-    }
-
-    if (format == QImage::Format_Invalid) {
+    if (bitsPerSample != 8 || (channels != 3 && channels != 4)) {
         qWarning() << "Unsupported image format received from hint (hasAlpha:"
                    << hasAlpha << "bitsPerSample:" << bitsPerSample
                    << "channels:" << channels << ")";
         return QImage();
     }
 
-    QImage image(width, height, format);
-    ptr = pixels.data();
-    end = ptr + pixels.length();
-    for (int y = 0; y < height; ++y, ptr += stride) {
-        if (ptr + channels * width > end) {
-            qWarning() << "Image data is incomplete. y:" << y << "height:" << height;
-            break;
-        }
-        function((QRgb *)image.scanLine(y), ptr, width);
+    // Lines might be padded to any alignment, but not so much that
+    // stride times height could overflow; reads past the buffer are
+    // prevented by the size check below
+    const int lineLength = width * channels;
+    if (stride < lineLength || stride > lineLength + 4096) {
+        qWarning() << "Image hint stride is not valid:" << stride;
+        return QImage();
+    }
+
+    // Lines that are not in the buffer are left transparent
+    int lines = height;
+    if (pixels.size() < qint64(stride) * (height - 1) + lineLength) {
+        lines = pixels.size() >= lineLength ? (pixels.size() - lineLength) / stride + 1 : 0;
+        qWarning() << "Image data is incomplete. y:" << lines << "height:" << height;
     }
 
+    // Hints are already in a format that QImage understands, wrap the
+    // buffer we got from D-Bus when its lines are suitably aligned
+    const QImage::Format format = channels == 4 ? QImage::Format_RGBA8888 : QImage::Format_RGB888;
+    if (lines == height && stride % 4 == 0 &&
+            reinterpret_cast<quintptr>(pixels.constData()) % 4 == 0)
+        return QImage(reinterpret_cast<const uchar *>(pixels.constData()),
+                      width, height, stride, format,
+                      releasePixels, new QByteArray(pixels));
+
+    // Otherwise convert to the format used for rendering
+    QImage image(width, height, channels == 4 ? QImage::Format_ARGB32_Premultiplied : QImage::Format_RGB32);
+    if (lines < height)
+        image.fill(Qt::transparent);
+
+    const ConvertLineFunc function = channels == 4 ? convertLineRGBA : convertLineRGB;
+    const uchar *ptr = reinterpret_cast<const uchar *>(pixels.constData());
+    for (int y = 0; y < lines; ++y, ptr += stride)
+        function(reinterpret_cast<QRgb *>(image.scanLine(y)), ptr, width);
+
     return image;
 }
+
+QImage convertToDisplayImage(const QImage &image)
+{
+    ConvertLineFunc function = Q_NULLPTR;
+    QImage::Format format = QImage::Format_Invalid;
+
+    switch (image.format()) {
+    case QImage::Format_RGBA8888:
+        function = convertLineRGBA;
+        format = QImage::Format_ARGB32_Premultiplied;
+        break;
+    case QImage::Format_RGB888:
+        function = convertLineRGB;
+        format = QImage::Format_RGB32;
+        break;
+    case QImage::Format_ARGB32_Premultiplied:
+    case QImage::Format_RGB32:
+        return image;
+    default:
+        return image.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+    }
+
+    QImage result(image.width(), image.height(), format);
+    for (int y = 0; y < image.height(); ++y)
+        function(reinterpret_cast<QRgb *>(result.scanLine(y)), image.constScanLine(y), image.width());
+    return result;
+}
@@ -33,5 +33,8 @@
 #include <QtGui/QImage>
 
 QImage decodeImageHint(const QDBusArgument &arg);
+QImage decodeImageData(int width, int height, int stride, bool hasAlpha,
+                       int bitsPerSample, int channels, const QByteArray &pixels);
+QImage convertToDisplayImage(const QImage &image);
 
 #endif // NOTIFICATIONSIMAGE_H
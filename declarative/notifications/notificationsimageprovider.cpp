@@ -24,63 +24,200 @@
  * $END_LICENSE$
  ***************************************************************************/
 
+
+#include <QtCore/QCoreApplication>
+#include <QtCore/QEvent>
+#include <QtCore/QRunnable>
+#include <QtCore/QUrl>
 #include <QtGui/QIcon>
 
-#include "notificationsdaemon.h"
+#include "notificationsimage.h"
 #include "notificationsimageprovider.h"
+#include "notificationsimagestore.h"
+
+// Icons are small, this holds a few hundred of them
+static const int cacheBudget = 8 * 1024 * 1024;
+static const int defaultIconSize = 48;
+
+static const QString fallbackIcon = QStringLiteral("icon/dialog-information");
 
-NotificationsImageProvider::NotificationsImageProvider(NotificationsDaemon *daemon)
-    : QQuickImageProvider(QQuickImageProvider::Pixmap)
-    , m_daemon(daemon)
+class NotificationsImageResponse : public QQuickImageResponse, public QRunnable
 {
+public:
+    NotificationsImageResponse(NotificationsImageProvider *provider,
+                               const QString &id, const QSize &requestedSize)
+        : m_provider(provider)
+        , m_id(id)
+        , m_size(requestedSize)
+        , m_imageKey(0)
+    {
+        // Deleted by the engine
+        setAutoDelete(false);
+
+        // Sanitize requested size
+        if (m_size.width() < 1)
+            m_size.setWidth(defaultIconSize);
+        if (m_size.height() < 1)
+            m_size.setHeight(defaultIconSize);
+
+        m_key = QStringLiteral("%1@%2x%3").arg(id).arg(m_size.width()).arg(m_size.height());
+    }
+
+    QQuickTextureFactory *textureFactory() const
+    {
+        return QQuickTextureFactory::textureFactoryForImage(m_image);
+    }
+
+    void start()
+    {
+        const QStringList parts = m_id.split(QLatin1Char('/'), QString::SkipEmptyParts);
+        bool ok = false;
+        if (parts.size() == 2 && parts.at(0) == QStringLiteral("image"))
+            m_imageKey = parts.at(1).toULongLong(&ok, 16);
+
+        if (ok)
+            m_provider->m_pool.start(this);
+        else
+            requestIcon(m_id);
+    }
+
+    void run()
+    {
+        m_image = m_provider->renderImage(m_key, m_imageKey, m_size);
+
+        // Default icon when the image was evicted from the store
+        if (m_image.isNull())
+            requestIcon(fallbackIcon);
+        else
+            Q_EMIT finished();
+    }
+
+private:
+    NotificationsImageProvider *m_provider;
+    QString m_id;
+    QSize m_size;
+    QString m_key;
+    quint64 m_imageKey;
+    QImage m_image;
+
+    void requestIcon(const QString &id)
+    {
+        // The connection is queued and goes away with us
+        const QString key = QStringLiteral("%1@%2x%3").arg(id).arg(m_size.width()).arg(m_size.height());
+        QObject::connect(m_provider->m_iconLoader, &NotificationsIconLoader::iconLoaded, this,
+                         [this, key](const QString &loadedKey, const QImage &image) {
+            if (loadedKey != key)
+                return;
+            m_image = image;
+            Q_EMIT finished();
+        }, Qt::QueuedConnection);
+        QMetaObject::invokeMethod(m_provider->m_iconLoader, "load", Qt::QueuedConnection,
+                                  Q_ARG(QString, key), Q_ARG(QString, id), Q_ARG(QSize, m_size));
+    }
+};
+
+/*
+ * NotificationsIconLoader
+ */
+
+NotificationsIconLoader::NotificationsIconLoader(QObject *parent)
+    : QObject(parent)
+    , m_themeName(QIcon::themeName())
+    , m_cache(cacheBudget)
+{
+    QCoreApplication::instance()->installEventFilter(this);
 }
 
-QPixmap NotificationsImageProvider::requestPixmap(const QString &id, QSize *realSize, const QSize &requestedSize)
+void NotificationsIconLoader::load(const QString &key, const QString &id, const QSize &size)
 {
-    // Sanitize requested size
-    QSize size(requestedSize);
-    if (size.width() < 1)
-        size.setWidth(1);
-    if (size.height() < 1)
-        size.setHeight(1);
-
-    // Return real size
-    if (realSize)
-        *realSize = size;
-
-    // Convert identifier (the second part is just a timestamp to make sure Image
-    // is always reloaded)
-    QString realId = id.split('/', QString::SkipEmptyParts).at(0);
-    bool ok = false;
-    int notificationId = realId.toInt(&ok);
-    if (!ok)
-        return QPixmap();
-
-    // Get image from the daemon
-    NotificationImage *image = m_daemon->imageFor(notificationId);
-    if (!image)
-        return QPixmap();
-
-    // Pixmap
-    if (!image->image.isNull() && realSize) {
-        *realSize = image->image.size();
-        return image->image;
+    // Icons might have been installed or changed as well
+    if (m_themeName != QIcon::themeName()) {
+        m_themeName = QIcon::themeName();
+        m_cache.clear();
     }
 
-    // Icon
-    if (!image->iconName.isEmpty()) {
-        QIcon icon = QIcon::fromTheme(image->iconName);
-        if (!icon.isNull())
-            return icon.pixmap(size);
+    QImage *cached = m_cache.object(key);
+    if (cached) {
+        Q_EMIT iconLoaded(key, *cached);
+        return;
+    }
+
+    QImage image = loadIcon(id, size);
+    if (!image.isNull()) {
+        m_cache.insert(key, new QImage(image), image.byteCount());
+        Q_EMIT iconLoaded(key, image);
+        return;
     }
 
-    // Application icon
-    if (!image->entryIconName.isEmpty()) {
-        QIcon icon = QIcon::fromTheme(image->entryIconName);
+    // Don't cache the default icon, the icon might show up later
+    Q_EMIT iconLoaded(key, loadIcon(fallbackIcon, size));
+}
+
+QImage NotificationsIconLoader::loadIcon(const QString &id, const QSize &size)
+{
+    // First icon found in the theme
+    QImage image;
+    const QStringList parts = id.split(QLatin1Char('/'), QString::SkipEmptyParts);
+    for (int i = 1; i < parts.size() && image.isNull(); i++) {
+        QIcon icon = QIcon::fromTheme(QUrl::fromPercentEncoding(parts.at(i).toLatin1()));
         if (!icon.isNull())
-            return icon.pixmap(size);
+            image = icon.pixmap(size).toImage();
+    }
+    return image;
+}
+
+bool NotificationsIconLoader::eventFilter(QObject *object, QEvent *event)
+{
+    if (event->type() == QEvent::ThemeChange)
+        m_cache.clear();
+    return QObject::eventFilter(object, event);
+}
+
+/*
+ * NotificationsImageProvider
+ */
+
+NotificationsImageProvider::NotificationsImageProvider(const QSharedPointer<NotificationsImageStore> &store)
+    : QQuickAsyncImageProvider()
+    , m_store(store)
+    , m_cache(cacheBudget)
+    , m_iconLoader(new NotificationsIconLoader())
+{
+    m_pool.setMaxThreadCount(2);
+}
+
+NotificationsImageProvider::~NotificationsImageProvider()
+{
+    m_pool.waitForDone();
+    delete m_iconLoader;
+}
+
+QQuickImageResponse *NotificationsImageProvider::requestImageResponse(const QString &id, const QSize &requestedSize)
+{
+    NotificationsImageResponse *response = new NotificationsImageResponse(this, id, requestedSize);
+    response->start();
+    return response;
+}
+
+QImage NotificationsImageProvider::renderImage(const QString &key, quint64 imageKey, const QSize &size)
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        QImage *cached = m_cache.object(key);
+        if (cached)
+            return *cached;
     }
 
-    // Default icon
-    return QIcon::fromTheme(QStringLiteral("dialog-information")).pixmap(size);
+    // Image from the store, converted for upload and downscaled
+    QImage image = convertToDisplayImage(m_store->imageForKey(imageKey));
+    if (image.isNull())
+        return image;
+    if (image.width() > size.width() || image.height() > size.height())
+        image = image.scaled(size, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+
+    QMutexLocker locker(&m_mutex);
+    m_cache.insert(key, new QImage(image), image.byteCount());
+    return image;
 }
+
+#include "moc_notificationsimageprovider.cpp"
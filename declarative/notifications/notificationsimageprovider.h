@@ -27,19 +27,67 @@
 #ifndef NOTIFICATIONSIMAGEPROVIDER_H
 #define NOTIFICATIONSIMAGEPROVIDER_H
 
+#include <QtCore/QCache>
+#include <QtCore/QMutex>
+#include <QtCore/QObject>
+#include <QtCore/QSharedPointer>
+#include <QtCore/QThreadPool>
 #include <QtQuick/QQuickImageProvider>
 
-class NotificationsDaemon;
+class NotificationsImageStore;
 
-class NotificationsImageProvider : public QQuickImageProvider
+/*
+ * Icon themes are not thread-safe, icons are loaded by this
+ * object living in the GUI thread and handed over to responses
+ * with iconLoaded().  The cache is cleared when the theme changes.
+ */
+class NotificationsIconLoader : public QObject
 {
+    Q_OBJECT
 public:
-    NotificationsImageProvider(NotificationsDaemon *daemon);
+    NotificationsIconLoader(QObject *parent = Q_NULLPTR);
 
-    QPixmap requestPixmap(const QString &id, QSize *realSize, const QSize &requestedSize);
+Q_SIGNALS:
+    void iconLoaded(const QString &key, const QImage &image);
+
+public Q_SLOTS:
+    void load(const QString &key, const QString &id, const QSize &size);
+
+protected:
+    bool eventFilter(QObject *object, QEvent *event);
+
+private:
+    QString m_themeName;
+    QCache<QString, QImage> m_cache;
+
+    static QImage loadIcon(const QString &id, const QSize &size);
+};
+
+/*
+ * Sources are either "image/<key>", where the key identifies the
+ * image content in the store, or "icon/<name>[/<name>...]" with
+ * percent encoded icon names in order of preference.  Images are
+ * rendered on a thread pool and cached by source and size, icons
+ * are loaded on the GUI thread.
+ */
+class NotificationsImageProvider : public QQuickAsyncImageProvider
+{
+public:
+    NotificationsImageProvider(const QSharedPointer<NotificationsImageStore> &store);
+    ~NotificationsImageProvider();
+
+    QQuickImageResponse *requestImageResponse(const QString &id, const QSize &requestedSize);
 
 private:
-    NotificationsDaemon *m_daemon;
+    QSharedPointer<NotificationsImageStore> m_store;
+    QThreadPool m_pool;
+    QMutex m_mutex;
+    QCache<QString, QImage> m_cache;
+    NotificationsIconLoader *m_iconLoader;
+
+    QImage renderImage(const QString &key, quint64 imageKey, const QSize &size);
+
+    friend class NotificationsImageResponse;
 };
 
 #endif // NOTIFICATIONSIMAGEPROVIDER_H
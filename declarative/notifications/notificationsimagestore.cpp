@@ -0,0 +1,206 @@
+/****************************************************************************
+ * This file is part of Hawaii.
+ *
+ * Copyright (C) 2016 Pier Luigi Fiorini
+ *
+ * Author(s):
+ *    Pier Luigi Fiorini <pierluigi.fiorini@gmail.com>
+ *
+ * $BEGIN_LICENSE:LGPL2.1+$
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * $END_LICENSE$
+ ***************************************************************************/
+
+#include "notificationsdaemon.h"
+#include "notificationsimagestore.h"
+
+/*
+ * Bubbles show images at most at the large icon size, leave room
+ * for outputs with a high scale factor and downscale anything bigger.
+ */
+static const int defaultMaximumSize = 256;
+
+// Enough for a few hundred downscaled images
+static const int defaultMemoryBudget = 16 * 1024 * 1024;
+
+NotificationsImageStore::NotificationsImageStore()
+    : m_maximumSize(defaultMaximumSize)
+    , m_cache(defaultMemoryBudget)
+{
+}
+
+int NotificationsImageStore::maximumSize() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_maximumSize;
+}
+
+void NotificationsImageStore::setMaximumSize(int size)
+{
+    // Only applies to images inserted from now on
+    QMutexLocker locker(&m_mutex);
+    m_maximumSize = size;
+}
+
+int NotificationsImageStore::memoryBudget() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_cache.maxCost();
+}
+
+void NotificationsImageStore::setMemoryBudget(int bytes)
+{
+    QMutexLocker locker(&m_mutex);
+    m_cache.setMaxCost(bytes);
+}
+
+int NotificationsImageStore::memoryUsage() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_cache.totalCost();
+}
+
+int NotificationsImageStore::imageCount() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_cache.count();
+}
+
+int NotificationsImageStore::notificationCount() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_keys.size();
+}
+
+QImage NotificationsImageStore::image(uint id)
+{
+    QMutexLocker locker(&m_mutex);
+
+    // Also marks the image as recently used
+    QHash<uint, quint64>::const_iterator it = m_keys.constFind(id);
+    if (it == m_keys.constEnd())
+        return QImage();
+
+    QImage *image = m_cache.object(it.value());
+    return image ? *image : QImage();
+}
+
+QImage NotificationsImageStore::imageForKey(quint64 key)
+{
+    QMutexLocker locker(&m_mutex);
+    QImage *image = m_cache.object(key);
+    return image ? *image : QImage();
+}
+
+bool NotificationsImageStore::findKey(uint id, quint64 *key) const
+{
+    QMutexLocker locker(&m_mutex);
+    QHash<uint, quint64>::const_iterator it = m_keys.constFind(id);
+    if (it == m_keys.constEnd() || !m_cache.contains(it.value()))
+        return false;
+
+    *key = it.value();
+    return true;
+}
+
+void NotificationsImageStore::insert(uint id, const QImage &image)
+{
+    // Scale and hash without holding the lock
+    const int maximumSize = this->maximumSize();
+    QImage scaled = image;
+    if (image.width() > maximumSize || image.height() > maximumSize)
+        scaled = image.scaled(maximumSize, maximumSize,
+                              Qt::KeepAspectRatio, Qt::SmoothTransformation);
+    quint64 key = scaled.isNull() ? 0 : imageKey(scaled);
+
+    QMutexLocker locker(&m_mutex);
+
+    // Replaced notifications release their previous image
+    removeLocked(id);
+
+    if (scaled.isNull())
+        return;
+
+    // Applications often send the same image over and over again,
+    // keep only one copy around for all their notifications; on
+    // hash collisions probe the next key, never overwrite an image
+    // that is still referenced, even when it was evicted
+    QImage *cached = m_cache.object(key);
+    while (cached ? *cached != scaled : m_refs.contains(key)) {
+        qCDebug(NOTIFICATIONS) << "Image key" << key << "already taken, probing the next one";
+        cached = m_cache.object(++key);
+    }
+    if (!cached) {
+        if (!m_cache.insert(key, new QImage(scaled), scaled.byteCount())) {
+            qCWarning(NOTIFICATIONS) << "Image of" << scaled.byteCount()
+                                     << "bytes exceeds the memory budget";
+            return;
+        }
+    }
+
+    m_keys.insert(id, key);
+    m_refs[key]++;
+
+    qCDebug(NOTIFICATIONS) << "Image store:" << m_cache.count() << "images for"
+                           << m_keys.size() << "notifications using"
+                           << m_cache.totalCost() << "of" << m_cache.maxCost() << "bytes";
+}
+
+void NotificationsImageStore::remove(uint id)
+{
+    QMutexLocker locker(&m_mutex);
+    removeLocked(id);
+}
+
+void NotificationsImageStore::removeLocked(uint id)
+{
+    QHash<uint, quint64>::iterator it = m_keys.find(id);
+    if (it == m_keys.end())
+        return;
+
+    const quint64 key = it.value();
+    m_keys.erase(it);
+
+    // Free the image as soon as no notification refers to it,
+    // otherwise least recently used images are evicted when over budget
+    QHash<quint64, int>::iterator refIt = m_refs.find(key);
+    if (refIt != m_refs.end() && --refIt.value() == 0) {
+        m_refs.erase(refIt);
+        m_cache.remove(key);
+    }
+}
+
+void NotificationsImageStore::clear()
+{
+    QMutexLocker locker(&m_mutex);
+    m_keys.clear();
+    m_refs.clear();
+    m_cache.clear();
+}
+
+quint64 NotificationsImageStore::imageKey(const QImage &image)
+{
+    // Two independently seeded hashes of visible pixels, padding
+    // at the end of lines is not guaranteed to be initialized
+    const int lineLength = (image.width() * image.depth() + 7) / 8;
+    uint h1 = qHash(image.width()) ^ uint(image.format());
+    uint h2 = qHash(image.height()) ^ 0x9e3779b9u;
+    for (int y = 0; y < image.height(); ++y) {
+        h1 = qHashBits(image.constScanLine(y), lineLength, h1);
+        h2 = qHashBits(image.constScanLine(y), lineLength, h2 * 31 + 1);
+    }
+    return (quint64(h1) << 32) | h2;
+}
@@ -0,0 +1,73 @@
+/****************************************************************************
+ * This file is part of Hawaii.
+ *
+ * Copyright (C) 2016 Pier Luigi Fiorini
+ *
+ * Author(s):
+ *    Pier Luigi Fiorini <pierluigi.fiorini@gmail.com>
+ *
+ * $BEGIN_LICENSE:LGPL2.1+$
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * $END_LICENSE$
+ ***************************************************************************/
+
+#ifndef NOTIFICATIONSIMAGESTORE_H
+#define NOTIFICATIONSIMAGESTORE_H
+
+#include <QtCore/QCache>
+#include <QtCore/QHash>
+#include <QtCore/QMutex>
+#include <QtGui/QImage>
+
+/*
+ * Shared with the image provider, which reads from other threads.
+ */
+class NotificationsImageStore
+{
+public:
+    NotificationsImageStore();
+
+    int maximumSize() const;
+    void setMaximumSize(int size);
+
+    int memoryBudget() const;
+    void setMemoryBudget(int bytes);
+
+    int memoryUsage() const;
+    int imageCount() const;
+    int notificationCount() const;
+
+    QImage image(uint id);
+    QImage imageForKey(quint64 key);
+    bool findKey(uint id, quint64 *key) const;
+
+    void insert(uint id, const QImage &image);
+    void remove(uint id);
+    void clear();
+
+private:
+    mutable QMutex m_mutex;
+    int m_maximumSize;
+    QHash<uint, quint64> m_keys;
+    QHash<quint64, int> m_refs;
+    QCache<quint64, QImage> m_cache;
+
+    void removeLocked(uint id);
+
+    static quint64 imageKey(const QImage &image);
+};
+
+#endif // NOTIFICATIONSIMAGESTORE_H
@@ -0,0 +1,101 @@
+/****************************************************************************
+ * This file is part of Hawaii.
+ *
+ * Copyright (C) 2016 Pier Luigi Fiorini
+ *
+ * Author(s):
+ *    Pier Luigi Fiorini <pierluigi.fiorini@gmail.com>
+ *
+ * $BEGIN_LICENSE:LGPL2.1+$
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * $END_LICENSE$
+ ***************************************************************************/
+
+#ifndef NOTIFICATIONSQUEUE_H
+#define NOTIFICATIONSQUEUE_H
+
+#include <QtCore/QAtomicPointer>
+
+/*
+ * Lock-free queue with a single producer and a single consumer.
+ * The consumer always holds a dummy node whose successor is the
+ * head, so that producer and consumer never touch the same node
+ * except for the next pointer which is published atomically.
+ */
+template <typename T>
+class NotificationsQueue
+{
+public:
+    NotificationsQueue()
+        : m_first(new Node())
+        , m_last(m_first)
+    {
+    }
+
+    ~NotificationsQueue()
+    {
+        while (m_first) {
+            Node *node = m_first;
+            m_first = node->next.load();
+            delete node;
+        }
+    }
+
+    // Producer side only
+    void enqueue(const T &value)
+    {
+        Node *node = new Node(value);
+        m_last->next.storeRelease(node);
+        m_last = node;
+    }
+
+    // Consumer side only
+    bool dequeue(T *value)
+    {
+        Node *next = m_first->next.loadAcquire();
+        if (!next)
+            return false;
+
+        // The head becomes the new dummy, release its value now
+        *value = next->value;
+        next->value = T();
+        delete m_first;
+        m_first = next;
+        return true;
+    }
+
+    // Consumer side only
+    bool isEmpty() const
+    {
+        return !m_first->next.loadAcquire();
+    }
+
+private:
+    struct Node {
+        Node() {}
+        explicit Node(const T &v) : value(v) {}
+
+        T value;
+        QAtomicPointer<Node> next;
+    };
+
+    Node *m_first;
+    Node *m_last;
+
+    Q_DISABLE_COPY(NotificationsQueue)
+};
+
+#endif // NOTIFICATIONSQUEUE_H
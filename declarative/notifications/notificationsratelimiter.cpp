@@ -0,0 +1,185 @@
+/****************************************************************************
+ * This file is part of Hawaii.
+ *
+ * Copyright (C) 2016 Pier Luigi Fiorini
+ *
+ * Author(s):
+ *    Pier Luigi Fiorini <pierluigi.fiorini@gmail.com>
+ *
+ * $BEGIN_LICENSE:LGPL2.1+$
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * $END_LICENSE$
+ ***************************************************************************/
+
+#include "notificationsdaemon.h"
+#include "notificationsratelimiter.h"
+
+/*
+ * Anything can send notifications with any application name, keep
+ * the number of buckets bounded; buckets that refilled completely
+ * are dropped along with their counters.
+ */
+static const int maximumBuckets = 256;
+static const qint64 purgeInterval = 60000;
+
+NotificationsRateLimiter::NotificationsRateLimiter(QObject *parent)
+    : QObject(parent)
+    , m_settings(Q_NULLPTR)
+    , m_enabled(true)
+    , m_burstSize(5)
+    , m_rate(12)
+    , m_lastPurge(0)
+    , m_coalesced(0)
+    , m_dropped(0)
+{
+    m_clock.start();
+
+    // Fall back to defaults when the schema is not installed
+    if (Hawaii::QGSettings::isSchemaInstalled(QStringLiteral("org.hawaiios.shell.notifications"))) {
+        m_settings = new Hawaii::QGSettings(QStringLiteral("org.hawaiios.shell.notifications"),
+                                            QStringLiteral("/org/hawaiios/shell/notifications/"),
+                                            this);
+        connect(m_settings, SIGNAL(settingChanged(QString)),
+                this, SLOT(loadSettings()));
+        loadSettings();
+    }
+}
+
+bool NotificationsRateLimiter::isEnabled() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_enabled;
+}
+
+bool NotificationsRateLimiter::acquire(const QString &source)
+{
+    // Statistics are read from the GUI thread
+    QMutexLocker locker(&m_mutex);
+
+    if (!m_enabled || m_exempt.contains(source))
+        return true;
+
+    const qint64 now = m_clock.elapsed();
+
+    if (now - m_lastPurge >= purgeInterval)
+        purge(now);
+
+    // New sources start with a full bucket
+    QHash<QString, Bucket>::iterator it = m_buckets.find(source);
+    if (it == m_buckets.end()) {
+        if (m_buckets.size() >= maximumBuckets) {
+            purge(now);
+            if (m_buckets.size() >= maximumBuckets)
+                evictOldest();
+        }
+        it = m_buckets.insert(source, Bucket());
+        it->tokens = m_burstSize;
+    } else {
+        const qreal refill = (now - it->lastRefill) * m_rate / 60000.0;
+        it->tokens = qMin<qreal>(m_burstSize, it->tokens + refill);
+    }
+    it->lastRefill = now;
+
+    if (it->tokens < 1)
+        return false;
+
+    it->tokens -= 1;
+    return true;
+}
+
+void NotificationsRateLimiter::recordCoalesced(const QString &source)
+{
+    QMutexLocker locker(&m_mutex);
+    QHash<QString, Bucket>::iterator it = m_buckets.find(source);
+    if (it != m_buckets.end())
+        it->coalesced++;
+    m_coalesced++;
+}
+
+void NotificationsRateLimiter::recordDropped(const QString &source)
+{
+    QMutexLocker locker(&m_mutex);
+    QHash<QString, Bucket>::iterator it = m_buckets.find(source);
+    if (it != m_buckets.end())
+        it->dropped++;
+    m_dropped++;
+}
+
+QVariantMap NotificationsRateLimiter::statistics() const
+{
+    QMutexLocker locker(&m_mutex);
+
+    QVariantMap sources;
+    QHash<QString, Bucket>::const_iterator it;
+    for (it = m_buckets.constBegin(); it != m_buckets.constEnd(); ++it) {
+        if (it->coalesced == 0 && it->dropped == 0)
+            continue;
+
+        QVariantMap counters;
+        counters.insert(QStringLiteral("coalesced"), it->coalesced);
+        counters.insert(QStringLiteral("dropped"), it->dropped);
+        sources.insert(it.key(), counters);
+    }
+
+    QVariantMap map;
+    map.insert(QStringLiteral("enabled"), m_enabled);
+    map.insert(QStringLiteral("coalesced"), m_coalesced);
+    map.insert(QStringLiteral("dropped"), m_dropped);
+    map.insert(QStringLiteral("sources"), sources);
+    return map;
+}
+
+void NotificationsRateLimiter::purge(qint64 now)
+{
+    // A full bucket behaves just like a new one
+    QHash<QString, Bucket>::iterator it = m_buckets.begin();
+    while (it != m_buckets.end()) {
+        const qreal refill = (now - it->lastRefill) * m_rate / 60000.0;
+        if (it->tokens + refill >= m_burstSize)
+            it = m_buckets.erase(it);
+        else
+            ++it;
+    }
+    m_lastPurge = now;
+}
+
+void NotificationsRateLimiter::evictOldest()
+{
+    QHash<QString, Bucket>::iterator oldest = m_buckets.begin();
+    QHash<QString, Bucket>::iterator it;
+    for (it = m_buckets.begin(); it != m_buckets.end(); ++it) {
+        if (it->lastRefill < oldest->lastRefill)
+            oldest = it;
+    }
+    if (oldest != m_buckets.end())
+        m_buckets.erase(oldest);
+}
+
+void NotificationsRateLimiter::loadSettings()
+{
+    QMutexLocker locker(&m_mutex);
+
+    m_enabled = m_settings->value(QStringLiteral("rateLimit")).toBool();
+    m_burstSize = qMax(1, m_settings->value(QStringLiteral("burstSize")).toInt());
+    m_rate = qMax(1, m_settings->value(QStringLiteral("rate")).toInt());
+    m_exempt = m_settings->value(QStringLiteral("exemptApplications")).toStringList().toSet();
+
+    qCDebug(NOTIFICATIONS) << "Rate limit" << (m_enabled ? "enabled:" : "disabled:")
+                           << m_burstSize << "notifications in a row, then"
+                           << m_rate << "per minute";
+}
+
+#include "moc_notificationsratelimiter.cpp"
@@ -0,0 +1,96 @@
+/****************************************************************************
+ * This file is part of Hawaii.
+ *
+ * Copyright (C) 2016 Pier Luigi Fiorini
+ *
+ * Author(s):
+ *    Pier Luigi Fiorini <pierluigi.fiorini@gmail.com>
+ *
+ * $BEGIN_LICENSE:LGPL2.1+$
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * $END_LICENSE$
+ ***************************************************************************/
+
+#ifndef NOTIFICATIONSRATELIMITER_H
+#define NOTIFICATIONSRATELIMITER_H
+
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QHash>
+#include <QtCore/QMutex>
+#include <QtCore/QObject>
+#include <QtCore/QSet>
+#include <QtCore/QVariant>
+
+#include <Hawaii/GSettings/QGSettings>
+
+class NotificationsRateLimiter : public QObject
+{
+    Q_OBJECT
+public:
+    NotificationsRateLimiter(QObject *parent = Q_NULLPTR);
+
+    bool isEnabled() const;
+
+    /*!
+     * \brief Take a token from the bucket of \a source.
+     *
+     * Returns false when \a source, an application name or
+     * desktop entry, already used up its burst and is sending
+     * notifications faster than the configured rate.
+     */
+    bool acquire(const QString &source);
+
+    void recordCoalesced(const QString &source);
+    void recordDropped(const QString &source);
+
+    /*!
+     * \brief Counters of coalesced and dropped notifications.
+     *
+     * Totals cover the whole session, per source counters only
+     * sources that are still being limited.
+     */
+    QVariantMap statistics() const;
+
+private:
+    struct Bucket {
+        Bucket() : tokens(0), lastRefill(0), coalesced(0), dropped(0) {}
+
+        qreal tokens;
+        qint64 lastRefill;
+        quint64 coalesced;
+        quint64 dropped;
+    };
+
+    mutable QMutex m_mutex;
+    Hawaii::QGSettings *m_settings;
+    bool m_enabled;
+    int m_burstSize;
+    int m_rate;
+    QSet<QString> m_exempt;
+    QElapsedTimer m_clock;
+    QHash<QString, Bucket> m_buckets;
+    qint64 m_lastPurge;
+    quint64 m_coalesced;
+    quint64 m_dropped;
+
+    void purge(qint64 now);
+    void evictOldest();
+
+private Q_SLOTS:
+    void loadSettings();
+};
+
+#endif // NOTIFICATIONSRATELIMITER_H
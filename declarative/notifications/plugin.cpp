@@ -27,6 +27,8 @@
 #include <QtQml/QtQml>
 
 #include "notifications.h"
+#include "notificationsdaemon.h"
+#include "notificationshistorymodel.h"
 #include "notificationsimageprovider.h"
 
 class NotificationsPlugin : public QQmlExtensionPlugin
@@ -39,9 +41,11 @@ public:
         // @uri org.hawaiios.notifications
         Q_ASSERT(uri == QStringLiteral("org.hawaiios.notifications"));
 
+        qmlRegisterUncreatableType<NotificationsHistoryModel>(uri, 0, 1, "NotificationsHistoryModel",
+                                                              QStringLiteral("Use NotificationsService.history"));
         qmlRegisterSingletonType<Notifications>(uri, 0, 1, "NotificationsService", [](QQmlEngine *engine, QJSEngine *) {
             Notifications *notifications = new Notifications();
-            engine->addImageProvider(QStringLiteral("notifications"), new NotificationsImageProvider(notifications->daemon()));
+            engine->addImageProvider(QStringLiteral("notifications"), new NotificationsImageProvider(notifications->daemon()->imageStore()));
             return static_cast<QObject *>(notifications);
         });
     }
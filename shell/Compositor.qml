@@ -27,6 +27,7 @@
 import QtQuick 2.0
 import GreenIsland 1.0 as GreenIsland
 import org.hawaiios.misc 0.1
+import org.hawaiios.compositor 0.1 as CppCompositor
 import org.hawaiios.launcher 0.1 as CppLauncher
 import "desktop"
 
@@ -68,6 +69,7 @@ GreenIsland.WaylandCompositor {
                 view = chromeComponent.createObject(d.outputs[i].surfacesArea, {"shellSurface": shellSurface, "window": window, "decorated": true});
                 view.moveItem = window.moveItem;
                 window.addWindowView(view);
+                CppCompositor.WindowThumbnails.addView(window, view);
             }
         }
     }
@@ -86,6 +88,7 @@ GreenIsland.WaylandCompositor {
                     viewsBySurface[xdgSurface.surface] = new Array();
                 viewsBySurface[xdgSurface.surface].push({"output": d.outputs[i], "view": view});
                 window.addWindowView(view);
+                CppCompositor.WindowThumbnails.addView(window, view);
             }
         }
         onXdgPopupCreated: {
@@ -153,6 +156,7 @@ GreenIsland.WaylandCompositor {
         id: d
 
         property variant outputs: []
+        property int pendingLockScreenFrames: 0
     }
 
     // Settings
@@ -197,16 +201,35 @@ GreenIsland.WaylandCompositor {
     }
 
     // Idle manager
-    Timer {
-        id: idleTimer
-        interval: settings.session.idleDelay * 1000
-        running: true
-        repeat: true
-        onTriggered: {
+    QtObject {
+        id: idleManager
+
+        property int blankThreshold: -1
+        readonly property int blankTimeout: settings.session.idleDelay * 1000
+
+        onBlankTimeoutChanged: {
+            if (blankThreshold >= 0)
+                SessionInterface.idleMonitor.setThresholdTimeout(blankThreshold, blankTimeout);
+        }
+        Component.onCompleted: blankThreshold = SessionInterface.idleMonitor.addThreshold(blankTimeout)
+    }
+
+    Binding {
+        target: SessionInterface.idleMonitor
+        property: "inhibited"
+        value: idleInhibit > 0
+    }
+
+    Connections {
+        target: SessionInterface.idleMonitor
+        onThresholdReached: {
+            if (threshold !== idleManager.blankThreshold)
+                return;
+
             var i, output, idleHint = false;
             for (i = 0; i < d.outputs.length; i++) {
                 output = d.outputs[i];
-                if (idleInhibit + output.idleInhibit == 0) {
+                if (output.idleInhibit == 0) {
                     output.idle();
                     idleHint = true;
                 }
@@ -214,10 +237,26 @@ GreenIsland.WaylandCompositor {
 
             SessionInterface.idle = idleHint;
         }
+        onResumed: wake()
     }
 
-    // Windows
-    ListModel {
+    // Wait for the lock screen on all outputs before sleeping
+    Connections {
+        target: SessionInterface
+        onLockScreenFrameRequested: {
+            var i;
+            d.pendingLockScreenFrames = d.outputs.length;
+            if (d.pendingLockScreenFrames == 0) {
+                SessionInterface.lockScreenRendered();
+                return;
+            }
+            for (i = 0; i < d.outputs.length; i++)
+                d.outputs[i].requestLockScreenFrame();
+        }
+    }
+
+    // Windows sorted by focus recency
+    CppCompositor.WindowsModel {
         id: windowsModel
     }
 
@@ -248,14 +287,9 @@ GreenIsland.WaylandCompositor {
                     if (isMapped) {
                         var window = applicationManager.windowForSurface(surface);
                         if (window)
-                            windowsModel.append({"window": window});
+                            windowsModel.addWindow(window);
                     } else {
-                        for (var i = 0; i < windowsModel.count; i++) {
-                            if (windowsModel.get(i).window.surface === surface) {
-                                windowsModel.remove(i, 1);
-                                break;
-                            }
-                        }
+                        windowsModel.removeSurface(surface);
                     }
                 }
             }
@@ -291,10 +325,8 @@ GreenIsland.WaylandCompositor {
 
     function wake() {
         var i;
-        for (i = 0; i < d.outputs.length; i++) {
-            idleTimer.restart();
+        for (i = 0; i < d.outputs.length; i++)
             d.outputs[i].wake();
-        }
 
         SessionInterface.idle = false;
     }
@@ -306,4 +338,11 @@ GreenIsland.WaylandCompositor {
 
         SessionInterface.idle = true;
     }
+
+    function lockScreenFrameSwapped() {
+        if (d.pendingLockScreenFrames <= 0)
+            return;
+        if (--d.pendingLockScreenFrames == 0)
+            SessionInterface.lockScreenRendered();
+    }
 }
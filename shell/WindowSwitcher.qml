@@ -28,8 +28,8 @@ import QtQuick 2.0
 import QtQuick.Layouts 1.0
 import QtQuick.Controls 2.0
 import QtQuick.Controls.Material 2.0
-import GreenIsland 1.0 as GreenIsland
 import Fluid.Ui 1.0 as FluidUi
+import org.hawaiios.compositor 0.1 as CppCompositor
 
 Popup {
     readonly property real thumbnailSize: FluidUi.Units.dp(200)
@@ -42,6 +42,10 @@ Popup {
 
     Material.theme: Material.Dark
 
+    // Refresh thumbnails only while visible
+    onAboutToShow: CppCompositor.WindowThumbnails.hold()
+    onClosed: CppCompositor.WindowThumbnails.release()
+
     Component {
         id: thumbnailComponent
 
@@ -55,16 +59,15 @@ Popup {
             color: wrapper.ListView.isCurrentItem ? Material.accent : "transparent"
             radius: FluidUi.Units.dp(4)
 
-            GreenIsland.WaylandQuickItem {
+            Image {
                 id: windowItem
                 anchors {
                     fill: parent
                     margins: FluidUi.Units.smallSpacing
                 }
-                surface: window.surface
-                sizeFollowsSurface: false
-                inputEventsEnabled: false
-                view.discardFrontBuffers: true
+                source: CppCompositor.WindowThumbnails.url(window, CppCompositor.WindowThumbnails.revision)
+                fillMode: Image.PreserveAspectFit
+                smooth: true
                 z: 0
 
                 MouseArea {
@@ -122,12 +125,12 @@ Popup {
 
     function activate() {
         var window = listView.model.get(listView.currentIndex);
-        if (window && window)
-            window.window.activate();
+        if (window)
+            window.activate();
     }
 
     function previous() {
-        if (windowsModel.count < 2)
+        if (hawaiiCompositor.windowsModel.count < 2)
             return;
 
         if (listView.currentIndex == 0)
@@ -138,7 +141,7 @@ Popup {
     }
 
     function next() {
-        if (windowsModel.count < 2)
+        if (hawaiiCompositor.windowsModel.count < 2)
             return;
 
         if (listView.currentIndex == listView.count - 1)
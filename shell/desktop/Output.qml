@@ -37,6 +37,7 @@ GreenIsland.ExtendedOutput {
     readonly property bool primary: hawaiiCompositor.primaryScreen === nativeScreen
 
     property int idleInhibit: 0
+    property bool lockScreenFrameRequested: false
 
     readonly property alias surfacesArea: screenView.currentWorkspace
     readonly property alias screenView: screenView
@@ -56,7 +57,8 @@ GreenIsland.ExtendedOutput {
     transform: nativeScreen.transform
     scaleFactor: nativeScreen.scaleFactor
     sizeFollowsWindow: false
-    automaticFrameCallback: powerState === GreenIsland.ExtendedOutput.PowerStateOn
+    automaticFrameCallback: powerState === GreenIsland.ExtendedOutput.PowerStateOn &&
+                            !SessionInterface.renderThrottle.throttled
     onPowerStateChanged: {
         // Show the screen when the power goes back
         if (output.powerState === GreenIsland.ExtendedOutput.PowerStateOn)
@@ -86,6 +88,34 @@ GreenIsland.ExtendedOutput {
             onRestartRequested: if (mainItem.state != "lock") mainItem.state = "restart"
         }
 
+        /*
+         * Lock screen frames
+         */
+
+        Connections {
+            target: window
+            enabled: output.lockScreenFrameRequested
+            onFrameSwapped: {
+                if (lockScreenLoader.item && lockScreenLoader.item.visible) {
+                    output.lockScreenFrameRequested = false;
+                    hawaiiCompositor.lockScreenFrameSwapped();
+                }
+            }
+        }
+
+        /*
+         * Render throttling
+         */
+
+        Connections {
+            target: SessionInterface.renderThrottle
+            onFrame: {
+                // Clients are paced by the throttle rather than by repaints
+                if (output.powerState === GreenIsland.ExtendedOutput.PowerStateOn)
+                    output.sendFrameCallbacks();
+            }
+        }
+
         /*
          * Idle manager
          */
@@ -154,9 +184,6 @@ GreenIsland.ExtendedOutput {
 
         GreenIsland.KeyEventFilter {
             Keys.onPressed: {
-                // Input wakes the output
-                hawaiiCompositor.wake();
-
                 // Handle Meta modifier
                 if (event.modifiers & Qt.MetaModifier) {
                     // Open window switcher
@@ -177,9 +204,6 @@ GreenIsland.ExtendedOutput {
             }
 
             Keys.onReleased: {
-                // Input wakes the output
-                hawaiiCompositor.wake();
-
                 // Handle Meta modifier
                 if (event.modifiers & Qt.MetaModifier) {
                     // Close window switcher
@@ -215,14 +239,6 @@ GreenIsland.ExtendedOutput {
             id: localPointerTracker
             anchors.fill: parent
             windowSystemCursorEnabled: true
-            onMouseXChanged: {
-                // Input wakes the output
-                hawaiiCompositor.wake();
-            }
-            onMouseYChanged: {
-                // Input wakes the output
-                hawaiiCompositor.wake();
-            }
 
             Item {
                 id: mainItem
@@ -260,7 +276,7 @@ GreenIsland.ExtendedOutput {
                         name: "lock"
                         PropertyChanges { target: cursor; visible: true }
                         PropertyChanges { target: logoutLoader; loadComponent: false }
-                        PropertyChanges { target: lockScreenLoader; loadComponent: true }
+                        PropertyChanges { target: lockScreenLoader; showComponent: true }
                         // FIXME: Before suspend we lock the screen, but turning the output off has a side effect:
                         // when the system is resumed it won't flip so we comment this out but unfortunately
                         // it means that the lock screen will not turn off the screen
@@ -323,8 +339,10 @@ GreenIsland.ExtendedOutput {
                     SecondaryLockScreen {}
                 }
 
-                FluidUi.Loadable {
-                    property bool loadComponent: false
+                // Instantiated at startup and only shown when locking, so
+                // that it can be rendered right before the system sleeps
+                Loader {
+                    property bool showComponent: false
 
                     id: lockScreenLoader
                     x: 0
@@ -332,9 +350,17 @@ GreenIsland.ExtendedOutput {
                     width: parent.width
                     height: parent.height
                     asynchronous: true
-                    component: output.primary ? primaryLockScreenComponent : secondaryLockScreenComponent
+                    sourceComponent: output.primary ? primaryLockScreenComponent : secondaryLockScreenComponent
                     z: 900
-                    onLoadComponentChanged: if (loadComponent) show(); else hide();
+                    onLoaded: if (showComponent) item.show();
+                    onShowComponentChanged: {
+                        if (!item)
+                            return;
+                        if (showComponent)
+                            item.show();
+                        else
+                            item.hide();
+                    }
                 }
 
                 /*
@@ -448,4 +474,15 @@ GreenIsland.ExtendedOutput {
     function idle() {
         blackRect.fadeIn();
     }
+
+    function requestLockScreenFrame() {
+        // A blanked output shows nothing that needs hiding
+        if (output.powerState !== GreenIsland.ExtendedOutput.PowerStateOn) {
+            hawaiiCompositor.lockScreenFrameSwapped();
+            return;
+        }
+
+        output.lockScreenFrameRequested = true;
+        window.update();
+    }
 }
@@ -25,11 +25,17 @@
  ***************************************************************************/
 
 import QtQuick 2.0
+import QtQuick.Templates 2.0 as ControlsTemplates
 import Fluid.Ui 1.0 as FluidUi
+import org.hawaiios.compositor 0.1 as CppCompositor
 
 Item {
     readonly property alias animateWindows: __private.animationsEnabled
 
+    // Only workspaces in a view have an index, others show
+    // all windows of the output
+    readonly property int workspaceIndex: ControlsTemplates.SwipeView.index
+
     id: workspace
     state: "normal"
     states: [
@@ -84,6 +90,14 @@ Item {
         property var storage: ({})
         property var chromes: ({})
         property bool animationsEnabled: false
+        readonly property var screenOutput: output
+    }
+
+    CppCompositor.WindowsProxyModel {
+        id: outputWindows
+        model: hawaiiCompositor.windowsModel
+        output: __private.screenOutput
+        workspace: workspaceIndex
     }
 
     Component {
@@ -94,12 +108,9 @@ Item {
 
     function windowsList() {
         var windows = [];
-        var i, window;
-        for (i = 0; i < applicationManager.windows.length; i++) {
-            window = applicationManager.windows[i];
-            if (window.designedOutput === output)
-                windows.push(window);
-        }
+        var i;
+        for (i = 0; i < outputWindows.count; i++)
+            windows.push(outputWindows.get(i));
         return windows;
     }
 
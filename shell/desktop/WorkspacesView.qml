@@ -80,15 +80,20 @@ ControlsTemplates.SwipeView {
     }
 
     function remove(index) {
-        // Reparent all windows to the previous or next workspace
+        // Reparent all windows to the previous or next workspace,
+        // copy the list because reparenting changes it
         var workspace = swipeView.itemAt(index);
         var prevIndex = index === 0 ? swipeView.count - 1 : index - 1;
         var prevWorkspace = swipeView.itemAt(prevIndex);
+        var windows = [];
         var i;
-        for (i = 0; i < workspace.children.length; i++) {
-            var window = workspace.children[i];
-            window.parent = prevWorkspace;
-        }
+        for (i = 0; i < workspace.children.length; i++)
+            windows.push(workspace.children[i]);
+        for (i = 0; i < windows.length; i++)
+            windows[i].parent = prevWorkspace;
+
+        // Keep the model in sync, indexes are those after the removal
+        hawaiiCompositor.windowsModel.removeWorkspace(index, prevIndex > index ? prevIndex - 1 : prevIndex);
 
         // Remove item
         swipeView.currentIndex = prevIndex;
@@ -37,7 +37,6 @@ import "events" as EventsIndicator
 
 Indicator {
     property int notificationId: 0
-    property var pendingRemovals: []
 
     name: "events"
     iconName: "dialog-information-symbolic"
@@ -59,7 +58,7 @@ Indicator {
                 id: notificationView
                 spacing: FluidUi.Units.largeSpacing
                 clip: true
-                model: notificationsModel
+                model: NotificationsService.history
                 delegate: EventsIndicator.EventItem {}
                 add: Transition {
                     NumberAnimation {
@@ -101,25 +100,6 @@ Indicator {
     }
     onTriggered: badgeCount = 0
 
-    Timer {
-        id: pendingTimer
-        interval: 5000
-        repeat: false
-        onTriggered: {
-            var i;
-            for (i = 0; i < pendingRemovals.length; ++i) {
-                var id = pendingRemovals[i];
-                var j;
-                for (j = 0; j < notificationsModel.count; ++j) {
-                    if (notificationsModel.get(j) == id)
-                        notificationsModel.remove(j);
-                }
-            }
-
-            pendingRemovals = [];
-        }
-    }
-
     Connections {
         target: NotificationsService
         onNotificationReceived: addNotification({id: notificationId, appName: appName,
@@ -130,10 +110,6 @@ Indicator {
         onNotificationClosed: repositionNotifications()
     }
 
-    ListModel {
-        id: notificationsModel
-    }
-
     Component.onCompleted: {
         // Move notifications every time the available geometry changes
         //_greenisland_output.availableGeometryChanged.connect(repositionNotifications);
@@ -153,64 +129,32 @@ Indicator {
          - hints
     */
     function addNotification(data) {
-        // Do not show duplicated notifications
-        // Remove notifications that are sent again (odd, but true)
-        var i;
-        for (i = 0; i < notificationsModel.count; ++i) {
-            var tmp = notificationsModel.get(i);
-            var matches = (tmp.appName === data.appName &&
-                           tmp.summary === data.summary &&
-                           tmp.body === data.body);
-            var sameSource = tmp.id === data["id"];
-
-            if (sameSource && matches)
-                return;
-
-            if (sameSource || matches) {
-                notificationsModel.remove(i)
-                break;
-            }
-        }
-
-        if (!sameSource && !matches)
-            badgeCount++;
-
         if (data["summary"].length < 1) {
             data["summary"] = data["body"];
             data["body"] = "";
         }
 
-        notificationsModel.insert(0, data);
-        if (!data["isPersistent"]) {
-            pendingRemovals.push(data["id"]);
-            pendingTimer.start();
-        }
-
         // Print notification data
         console.debug(JSON.stringify(data));
 
         // Update notification window if it's the same source
-        // otherwise create a new window
-        if (sameSource) {
-            var i, found = false;
-            var popups = screenView.layers.notifications.children;
-            for (i = 0; i < popups.length; i++) {
-                var popup = popups[i];
-                if (popup.objectName !== "notificationWindow")
-                    continue;
+        // otherwise create a new window, the events panel shows
+        // the history which is kept by the notifications service
+        var i;
+        var popups = screenView.layers.notifications.children;
+        for (i = 0; i < popups.length; i++) {
+            var popup = popups[i];
+            if (popup.objectName !== "notificationWindow" || popup.closing)
+                continue;
 
-                if (popup.notificationData.id === data["id"]) {
-                    popup.populateNotification(data);
-                    found = true;
-                    break;
-                }
+            if (popup.notificationData.id === data["id"]) {
+                popup.populateNotification(data);
+                return;
             }
-
-            if (!found)
-                createNotificationWindow(data);
-        } else {
-            createNotificationWindow(data);
         }
+
+        badgeCount++;
+        createNotificationWindow(data);
     }
 
     function createNotificationWindow(data) {
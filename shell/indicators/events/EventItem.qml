@@ -29,6 +29,7 @@ import QtQuick.Layouts 1.0
 import QtQuick.Controls 2.0
 import Hawaii.Controls 1.0 as Controls
 import Fluid.Ui 1.0 as FluidUi
+import org.hawaiios.notifications 0.1
 
 MouseArea {
     property bool expanded: false
@@ -89,7 +90,7 @@ MouseArea {
     onReleased: {
         if (drag.active) {
             if (x > width / 4 || x < width / -4)
-                notificationsModel.remove(index);
+                NotificationsService.history.remove(index);
             else
                 x = 0;
         } else if (model.body) {
@@ -121,11 +122,10 @@ MouseArea {
         }
         width: FluidUi.Units.iconSizes.medium
         height: width
-        source: width > 0 && height > 0 && model.hasIcon ? "image://notifications/" + model.id : ""
+        source: width > 0 && height > 0 && model.hasIcon ? model.iconSource : ""
         sourceSize.width: width
         sourceSize.height: height
         fillMode: Image.PreserveAspectFit
-        cache: false
         smooth: false
         visible: model.hasIcon
     }
@@ -103,7 +103,6 @@ Item {
         sourceSize.width: width
         sourceSize.height: height
         fillMode: Image.PreserveAspectFit
-        cache: false
         smooth: false
         visible: hasIcon
     }
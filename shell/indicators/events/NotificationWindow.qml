@@ -28,6 +28,7 @@ import QtQuick 2.0
 import QtQuick.Controls.Material 2.0
 import Hawaii.Themes 1.0 as Themes
 import Fluid.Ui 1.0 as FluidUi
+import org.hawaiios.notifications 0.1
 import "../../components" as ShellComponents
 
 Item {
@@ -156,7 +157,7 @@ Item {
         notificationItem.summary = notification.summary;
         notificationItem.body = notification.body;
         notificationItem.hasIcon = notification.hasIcon;
-        notificationItem.icon = "image://notifications/%1/%2".arg(notification.id).arg(Date.now() / 1000 | 0);
+        notificationItem.icon = NotificationsService.imageSource(notification.id);
         timer.interval = notification.expireTimeout;
         timer.restart();
         notificationItem.actions.clear();
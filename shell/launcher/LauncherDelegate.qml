@@ -175,7 +175,7 @@ Item {
         // Activate all windows of this application and unminimize
         var i, window;
         for (i = 0; i < hawaiiCompositor.windowsModel.count; i++) {
-            window = hawaiiCompositor.windowsModel.get(i).window;
+            window = hawaiiCompositor.windowsModel.get(i);
             if (window.appId === model.appId) {
                 window.minimized = false;
                 window.activate();
@@ -193,7 +193,7 @@ Item {
         // Minimize or unminimize windows
         var i, window;
         for (i = 0; i < hawaiiCompositor.windowsModel.count; i++) {
-            window = hawaiiCompositor.windowsModel.get(i).window;
+            window = hawaiiCompositor.windowsModel.get(i);
             if (window.appId === model.appId) {
                 var pt = screenView.mapFromItem(root, root.width * 0.5, root.height * 0.5);
                 pt.x += output.position.x;
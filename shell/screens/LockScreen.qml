@@ -37,18 +37,18 @@ FluidUi.Showable {
     showAnimation: YAnimator {
         target: root
         easing.type: Easing.OutQuad
-        duration: FluidUi.Units.longDuration
+        duration: SessionInterface.renderThrottle.throttled ? 0 : FluidUi.Units.longDuration
         from: -root.height
         to: 0
     }
     hideAnimation: YAnimator {
         target: root
         easing.type: Easing.OutQuad
-        duration: FluidUi.Units.longDuration
+        duration: SessionInterface.renderThrottle.throttled ? 0 : FluidUi.Units.longDuration
         from: 0
         to: -root.height
     }
-    visible: true
+    visible: false
     onVisibleChanged: {
         // Activate password field
         if (visible)
@@ -57,6 +57,23 @@ FluidUi.Showable {
 
     Material.theme: Material.Dark
 
+    Connections {
+        target: SessionInterface
+        onAuthenticationPrompt: {
+            // Modules might ask for something other than the password
+            passwordField.placeholderText = message.replace(/:\s*$/, "");
+            passwordField.echoMode = secret ? TextInput.Password : TextInput.Normal;
+            passwordField.text = "";
+        }
+        onAuthenticationMessage: {
+            // Informational messages (e.g. password about to expire)
+            // are worth reading too, errors stand out
+            errorLabel.error = error;
+            errorLabel.text = text;
+            errorTimer.restart();
+        }
+    }
+
     QtObject {
         id: __priv
 
@@ -90,7 +107,8 @@ FluidUi.Showable {
 
     Timer {
         id: timer
-        running: false
+        running: root.visible
+        repeat: true
         triggeredOnStart: true
         interval: 30000
         onTriggered: {
@@ -144,6 +162,7 @@ FluidUi.Showable {
                         SessionInterface.unlockSession(text, function(succeded) {
                             if (!succeded) {
                                 text = "";
+                                errorLabel.error = true;
                                 errorLabel.text = qsTr("Sorry, wrong password. Please try again.");
                                 errorTimer.start();
                             }
@@ -153,7 +172,10 @@ FluidUi.Showable {
 
                 Label {
                     id: errorLabel
-                    color: "red"
+
+                    property bool error: true
+
+                    color: error ? "red" : Material.primaryTextColor
                     text: " "
                     height: paintedHeight
 
@@ -186,11 +208,5 @@ FluidUi.Showable {
     Component.onCompleted: {
         // Remove seconds from time format
         __priv.timeFormat = Qt.locale().timeFormat(Locale.ShortFormat).replace(/.ss?/i, "");
-
-        // Start timer
-        timer.start();
-
-        // Activate password field
-        passwordField.forceActiveFocus();
     }
 }
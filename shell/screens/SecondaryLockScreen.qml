@@ -34,19 +34,19 @@ FluidUi.Showable {
     showAnimation: OpacityAnimator {
         target: root
         easing.type: Easing.InSine
-        duration: FluidUi.Units.longDuration
+        duration: SessionInterface.renderThrottle.throttled ? 0 : FluidUi.Units.longDuration
         from: 0.0
         to: 1.0
     }
     hideAnimation: OpacityAnimator {
         target: root
         easing.type: Easing.OutSine
-        duration: FluidUi.Units.longDuration
+        duration: SessionInterface.renderThrottle.throttled ? 0 : FluidUi.Units.longDuration
         from: 1.0
         to: 0.0
     }
     opacity: 0.0
-    visible: true
+    visible: false
 
     Image {
         id: picture
@@ -0,0 +1,94 @@
+/****************************************************************************
+ * This file is part of Hawaii.
+ *
+ * Copyright (C) 2016 Pier Luigi Fiorini
+ *
+ * Author(s):
+ *    Pier Luigi Fiorini <pierluigi.fiorini@gmail.com>
+ *
+ * $BEGIN_LICENSE:LGPL2.1+$
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * $END_LICENSE$
+ ***************************************************************************/
+
+
+#include <QtCore/QFile>
+#include <QtCore/QStandardPaths>
+#include <QtCore/QTextStream>
+
+#include "privatebus.h"
+
+PrivateBus::PrivateBus()
+{
+}
+
+PrivateBus::~PrivateBus()
+{
+    if (m_daemon.state() != QProcess::NotRunning) {
+        m_daemon.terminate();
+        m_daemon.waitForFinished();
+    }
+}
+
+bool PrivateBus::start()
+{
+    const QString executable = QStandardPaths::findExecutable(QStringLiteral("dbus-daemon"));
+    if (executable.isEmpty() || !m_dir.isValid())
+        return false;
+
+    // Everybody is allowed to do anything, the bus is ours
+    const QString configFileName = m_dir.path() + QStringLiteral("/bus.conf");
+    QFile configFile(configFileName);
+    if (!configFile.open(QFile::WriteOnly | QFile::Text))
+        return false;
+    QTextStream stream(&configFile);
+    stream << "<!DOCTYPE busconfig PUBLIC \"-//freedesktop//DTD D-Bus Bus Configuration 1.0//EN\"\n"
+           << " \"http://www.freedesktop.org/standards/dbus/1.0/busconfig.dtd\">\n"
+           << "<busconfig>\n"
+           << "  <type>session</type>\n"
+           << "  <listen>unix:dir=" << m_dir.path() << "</listen>\n"
+           << "  <auth>EXTERNAL</auth>\n"
+           << "  <policy context=\"default\">\n"
+           << "    <allow send_destination=\"*\" eavesdrop=\"true\"/>\n"
+           << "    <allow eavesdrop=\"true\"/>\n"
+           << "    <allow own=\"*\"/>\n"
+           << "  </policy>\n"
+           << "</busconfig>\n";
+    configFile.close();
+
+    m_daemon.setProcessChannelMode(QProcess::ForwardedErrorChannel);
+    m_daemon.start(executable, QStringList()
+                   << QStringLiteral("--nofork")
+                   << QStringLiteral("--print-address")
+                   << QStringLiteral("--config-file=") + configFileName);
+    if (!m_daemon.waitForStarted())
+        return false;
+
+    // The address is printed when the bus is ready
+    while (!m_daemon.canReadLine()) {
+        if (!m_daemon.waitForReadyRead(5000))
+            return false;
+    }
+    m_address = QString::fromLocal8Bit(m_daemon.readLine()).trimmed();
+    qputenv("DBUS_SESSION_BUS_ADDRESS", m_address.toLocal8Bit());
+
+    return true;
+}
+
+QString PrivateBus::address() const
+{
+    return m_address;
+}
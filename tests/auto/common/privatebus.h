@@ -0,0 +1,60 @@
+/****************************************************************************
+ * This file is part of Hawaii.
+ *
+ * Copyright (C) 2016 Pier Luigi Fiorini
+ *
+ * Author(s):
+ *    Pier Luigi Fiorini <pierluigi.fiorini@gmail.com>
+ *
+ * $BEGIN_LICENSE:LGPL2.1+$
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * $END_LICENSE$
+ ***************************************************************************/
+
+#ifndef PRIVATEBUS_H
+#define PRIVATEBUS_H
+
+#include <QtCore/QProcess>
+#include <QtCore/QTemporaryDir>
+
+/*!
+ * \brief Private dbus-daemon for tests.
+ *
+ * Anybody is allowed to own names and call anything on it, the
+ * daemon is terminated when the object goes away.
+ */
+class PrivateBus
+{
+public:
+    PrivateBus();
+    ~PrivateBus();
+
+    /*!
+     * \brief Start a dbus-daemon and make it the session bus.
+     *
+     * Must be called before anything connects to the session bus.
+     */
+    bool start();
+
+    QString address() const;
+
+private:
+    QTemporaryDir m_dir;
+    QProcess m_daemon;
+    QString m_address;
+};
+
+#endif // PRIVATEBUS_H
@@ -0,0 +1,302 @@
+/****************************************************************************
+ * This file is part of Hawaii.
+ *
+ * Copyright (C) 2016 Pier Luigi Fiorini
+ *
+ * Author(s):
+ *    Pier Luigi Fiorini <pierluigi.fiorini@gmail.com>
+ *
+ * $BEGIN_LICENSE:LGPL2.1+$
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * $END_LICENSE$
+ ***************************************************************************/
+
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QLocale>
+#include <QtCore/QTemporaryDir>
+#include <QtCore/QTextStream>
+#include <QtTest/QtTest>
+
+#include "appidmapping_p.h"
+#include "applicationinfo.h"
+#include "appsmodel.h"
+#include "appsproxymodel.h"
+#include "categoriesmodel.h"
+#include "launchermodel.h"
+
+static const char *const categories[] = {
+    "Development", "Education", "Game", "Graphics",
+    "Network", "Office", "AudioVideo", "System", "Utility"
+};
+static const int categoriesCount = sizeof(categories) / sizeof(categories[0]);
+
+class TestLauncherBenchmark : public QObject
+{
+    Q_OBJECT
+public:
+    TestLauncherBenchmark(QObject *parent = 0)
+        : QObject(parent)
+    {
+    }
+
+private Q_SLOTS:
+    void initTestCase()
+    {
+        QVERIFY(m_tempDir.isValid());
+
+        // Exercise localized keys
+        QLocale::setDefault(QLocale(QStringLiteral("it_IT")));
+
+        const QList<int> sizes = QList<int>() << 100 << 1000 << 10000;
+        Q_FOREACH (int size, sizes)
+            QVERIFY(generateCorpus(size));
+    }
+
+    void appsModelRefresh_data()
+    {
+        corpusData();
+    }
+
+    void appsModelRefresh()
+    {
+        QFETCH(int, size);
+        useCorpus(size);
+
+        // The constructor refreshes the model
+        QBENCHMARK {
+            AppsModel model;
+            Q_UNUSED(model);
+        }
+
+        AppsModel model;
+        QCOMPARE(model.rowCount(), size);
+    }
+
+    void categoriesModelRefresh_data()
+    {
+        corpusData();
+    }
+
+    void categoriesModelRefresh()
+    {
+        QFETCH(int, size);
+        useCorpus(size);
+
+        QBENCHMARK {
+            CategoriesModel model;
+            Q_UNUSED(model);
+        }
+    }
+
+    void appsProxyModelFilter_data()
+    {
+        corpusData();
+    }
+
+    void appsProxyModelFilter()
+    {
+        QFETCH(int, size);
+        useCorpus(size);
+
+        AppsModel model;
+        AppsProxyModel proxy;
+        proxy.setModel(&model);
+
+        // Simulate the user typing one key at a time and the view
+        // asking for the number of rows after each keystroke
+        const QString query = QStringLiteral("applicazione 42");
+        QBENCHMARK {
+            for (int i = 1; i <= query.size(); i++) {
+                proxy.setQuery(query.left(i));
+                proxy.rowCount();
+            }
+            proxy.setQuery(QString());
+        }
+    }
+
+    void desktopFileName_data()
+    {
+        QTest::addColumn<int>("size");
+        QTest::addColumn<QString>("appId");
+
+        Q_FOREACH (int size, m_corpora.keys()) {
+            const QByteArray prefix = QByteArray::number(size);
+            QTest::newRow(prefix + "-file-name") << size << appId(42) + QStringLiteral(".desktop");
+            QTest::newRow(prefix + "-base-name") << size << appId(42);
+            QTest::newRow(prefix + "-upper-case") << size << QStringLiteral("Benchapp%1").arg(42, 5, 10, QLatin1Char('0'));
+            QTest::newRow(prefix + "-missing") << size << QStringLiteral("missing-app");
+        }
+    }
+
+    void desktopFileName()
+    {
+        QFETCH(int, size);
+        QFETCH(QString, appId);
+        useCorpus(size);
+
+        QBENCHMARK {
+            AppIdMapping::desktopFileName(appId);
+        }
+    }
+
+    void applicationInfoProperties_data()
+    {
+        corpusData();
+    }
+
+    void applicationInfoProperties()
+    {
+        QFETCH(int, size);
+        useCorpus(size);
+
+        ApplicationInfo info(appId(42));
+        QVERIFY(!info.fileName().isEmpty());
+
+        QBENCHMARK {
+            info.name();
+            info.comment();
+            info.iconName();
+            info.actions();
+        }
+    }
+
+    void launcherModelStorm_data()
+    {
+        corpusData();
+    }
+
+    void launcherModelStorm()
+    {
+        QFETCH(int, size);
+        useCorpus(size);
+
+        if (!QGSettings::isSchemaInstalled(QStringLiteral("org.hawaiios.desktop.panel")))
+            QSKIP("org.hawaiios.desktop.panel settings schema is not installed");
+
+        LauncherModel model;
+
+        // Handlers are private slots connected to the application manager,
+        // invoke them directly to simulate a storm of notifications
+        QBENCHMARK {
+            for (int i = 0; i < size; i++)
+                QMetaObject::invokeMethod(&model, "handleApplicationAdded", Qt::DirectConnection,
+                                          Q_ARG(QString, appId(i)), Q_ARG(pid_t, 1000 + i));
+            for (int i = 0; i < size; i++)
+                QMetaObject::invokeMethod(&model, "handleApplicationFocused", Qt::DirectConnection,
+                                          Q_ARG(QString, appId(i)));
+            for (int i = 0; i < size; i++)
+                QMetaObject::invokeMethod(&model, "handleApplicationRemoved", Qt::DirectConnection,
+                                          Q_ARG(QString, appId(i)), Q_ARG(pid_t, 1000 + i));
+        }
+    }
+
+private:
+    QTemporaryDir m_tempDir;
+    QMap<int, QString> m_corpora;
+
+    static QString appId(int i)
+    {
+        return QStringLiteral("benchapp%1").arg(i, 5, 10, QLatin1Char('0'));
+    }
+
+    void corpusData()
+    {
+        QTest::addColumn<int>("size");
+
+        Q_FOREACH (int size, m_corpora.keys())
+            QTest::newRow(QByteArray::number(size)) << size;
+    }
+
+    bool generateCorpus(int size)
+    {
+        const QString path = m_tempDir.path() + QStringLiteral("/corpus-%1").arg(size);
+        const QString appsPath = path + QStringLiteral("/data/applications");
+        const QString menusPath = path + QStringLiteral("/config/menus");
+
+        QDir dir;
+        if (!dir.mkpath(appsPath) || !dir.mkpath(menusPath) ||
+                !dir.mkpath(path + QStringLiteral("/data-home")) ||
+                !dir.mkpath(path + QStringLiteral("/config-home")))
+            return false;
+
+        // Desktop entries with localized keys and actions
+        for (int i = 0; i < size; i++) {
+            QFile file(appsPath + QLatin1Char('/') + appId(i) + QStringLiteral(".desktop"));
+            if (!file.open(QFile::WriteOnly | QFile::Text))
+                return false;
+
+            QTextStream stream(&file);
+            stream.setCodec("UTF-8");
+            stream << "[Desktop Entry]\n"
+                   << "Type=Application\n"
+                   << "Name=Benchmark Application " << i << "\n"
+                   << "Name[it]=Applicazione di prova " << i << "\n"
+                   << "Name[de]=Testanwendung " << i << "\n"
+                   << "GenericName=Benchmark\n"
+                   << "GenericName[it]=Prova\n"
+                   << "Comment=Synthetic application number " << i << "\n"
+                   << "Comment[it]=Applicazione sintetica numero " << i << "\n"
+                   << "Icon=" << appId(i) << "\n"
+                   << "Exec=/bin/true\n"
+                   << "Categories=" << categories[i % categoriesCount] << ";\n"
+                   << "Actions=NewWindow;\n"
+                   << "\n"
+                   << "[Desktop Action NewWindow]\n"
+                   << "Name=New Window\n"
+                   << "Name[it]=Nuova finestra\n"
+                   << "Exec=/bin/true --new-window\n";
+        }
+
+        // Menu file with one submenu per category
+        QFile menuFile(menusPath + QStringLiteral("/hawaii-bench-applications.menu"));
+        if (!menuFile.open(QFile::WriteOnly | QFile::Text))
+            return false;
+
+        QTextStream stream(&menuFile);
+        stream << "<!DOCTYPE Menu PUBLIC \"-//freedesktop//DTD Menu 1.0//EN\"\n"
+               << " \"http://www.freedesktop.org/standards/menu-spec/1.0/menu.dtd\">\n"
+               << "<Menu>\n"
+               << "  <Name>Applications</Name>\n"
+               << "  <DefaultAppDirs/>\n"
+               << "  <DefaultDirectoryDirs/>\n";
+        for (int i = 0; i < categoriesCount; i++)
+            stream << "  <Menu>\n"
+                   << "    <Name>" << categories[i] << "</Name>\n"
+                   << "    <Include><Category>" << categories[i] << "</Category></Include>\n"
+                   << "  </Menu>\n";
+        stream << "</Menu>\n";
+
+        m_corpora.insert(size, path);
+        return true;
+    }
+
+    void useCorpus(int size)
+    {
+        // Both QStandardPaths and XdgMenu read the environment every
+        // time, switching corpus is just a matter of changing it
+        const QString path = m_corpora.value(size);
+        qputenv("XDG_DATA_HOME", QFile::encodeName(path + QStringLiteral("/data-home")));
+        qputenv("XDG_DATA_DIRS", QFile::encodeName(path + QStringLiteral("/data")));
+        qputenv("XDG_CONFIG_HOME", QFile::encodeName(path + QStringLiteral("/config-home")));
+        qputenv("XDG_CONFIG_DIRS", QFile::encodeName(path + QStringLiteral("/config")));
+        qputenv("XDG_MENU_PREFIX", "hawaii-bench-");
+    }
+};
+
+QTEST_GUILESS_MAIN(TestLauncherBenchmark)
+
+#include "tst_launcherbenchmark.moc"
@@ -0,0 +1,402 @@
+/****************************************************************************
+ * This file is part of Hawaii.
+ *
+ * Copyright (C) 2016 Pier Luigi Fiorini
+ *
+ * Author(s):
+ *    Pier Luigi Fiorini <pierluigi.fiorini@gmail.com>
+ *
+ * $BEGIN_LICENSE:LGPL2.1+$
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * $END_LICENSE$
+ ***************************************************************************/
+
+
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QFile>
+#include <QtCore/QTemporaryDir>
+#include <QtCore/QThread>
+#include <QtCore/QTimer>
+#include <QtDBus/QDBusConnection>
+#include <QtDBus/QDBusMetaType>
+#include <QtDBus/QDBusPendingCallWatcher>
+#include <QtDBus/QDBusPendingReply>
+#include <QtTest/QtTest>
+
+#include <algorithm>
+
+#include <time.h>
+
+#include "notifications.h"
+#include "notificationsdaemon.h"
+#include "notificationsimagestore.h"
+#include "privatebus.h"
+#include "testutils.h"
+
+static const QString sentHint = QStringLiteral("x-hawaii-bench-sent");
+
+struct ImageData {
+    int width;
+    int height;
+    int stride;
+    bool hasAlpha;
+    int bitsPerSample;
+    int channels;
+    QByteArray data;
+};
+
+Q_DECLARE_METATYPE(ImageData)
+
+QDBusArgument &operator<<(QDBusArgument &argument, const ImageData &image)
+{
+    argument.beginStructure();
+    argument << image.width << image.height << image.stride << image.hasAlpha
+             << image.bitsPerSample << image.channels << image.data;
+    argument.endStructure();
+    return argument;
+}
+
+const QDBusArgument &operator>>(const QDBusArgument &argument, ImageData &image)
+{
+    argument.beginStructure();
+    argument >> image.width >> image.height >> image.stride >> image.hasAlpha
+             >> image.bitsPerSample >> image.channels >> image.data;
+    argument.endStructure();
+    return argument;
+}
+
+enum Mix {
+    TextMix = 0,
+    ImageMix,
+    ReplaceMix,
+    ActionsMix,
+    MixedMix
+};
+
+Q_DECLARE_METATYPE(Mix)
+
+struct Flood {
+    int count;
+    int rate;
+    int sources;
+    int imageSize;
+    Mix mix;
+};
+
+/*
+ * Sends notifications at the given rate from its own thread and
+ * connection, just like applications do, and measures how long it
+ * takes for each call to be answered.
+ */
+class FloodClient : public QObject
+{
+    Q_OBJECT
+public:
+    FloodClient(const QString &address, const Flood &flood, const QElapsedTimer &clock)
+        : QObject()
+        , m_address(address)
+        , m_flood(flood)
+        , m_clock(clock)
+        , m_bus(QString())
+        , m_timer(Q_NULLPTR)
+        , m_sent(0)
+        , m_replies(0)
+        , m_lastId(0)
+    {
+        // Gradient with some transparency
+        const int size = flood.imageSize;
+        m_image.width = size;
+        m_image.height = size;
+        m_image.stride = size * 4;
+        m_image.hasAlpha = true;
+        m_image.bitsPerSample = 8;
+        m_image.channels = 4;
+        m_image.data.resize(m_image.stride * size);
+        for (int i = 0; i < m_image.data.size(); i++)
+            m_image.data[i] = char(i * 7);
+    }
+
+    ~FloodClient()
+    {
+        QDBusConnection::disconnectFromBus(connectionName());
+    }
+
+    QVector<qint64> latencies() const
+    {
+        return m_latencies;
+    }
+
+public Q_SLOTS:
+    void start()
+    {
+        m_bus = QDBusConnection::connectToBus(m_address, connectionName());
+
+        m_timer = new QTimer(this);
+        m_timer->setTimerType(Qt::PreciseTimer);
+        m_timer->setInterval(1);
+        connect(m_timer, &QTimer::timeout, this, &FloodClient::send);
+
+        m_started.start();
+        m_timer->start();
+        send();
+    }
+
+Q_SIGNALS:
+    void finished();
+
+private:
+    QString m_address;
+    Flood m_flood;
+    const QElapsedTimer &m_clock;
+    QDBusConnection m_bus;
+    QTimer *m_timer;
+    QElapsedTimer m_started;
+    ImageData m_image;
+    int m_sent;
+    int m_replies;
+    uint m_lastId;
+    QVector<qint64> m_latencies;
+
+    QString connectionName() const
+    {
+        return QStringLiteral("flood-client-%1").arg(quintptr(this));
+    }
+
+    void send()
+    {
+        // Catch up with the rate, timers are not that precise
+        const qint64 due = qMin<qint64>(m_flood.count, m_started.elapsed() * m_flood.rate / 1000 + 1);
+        while (m_sent < due)
+            sendOne(m_sent++);
+        if (m_sent == m_flood.count)
+            m_timer->stop();
+    }
+
+    void sendOne(int i)
+    {
+        QString appName = QStringLiteral("Flood %1").arg(i % m_flood.sources);
+        QString summary = QStringLiteral("Message %1").arg(i);
+        QString body = QStringLiteral("Body of message %1 with <b>markup</b>").arg(i);
+        uint replacesId = 0;
+        QStringList actions;
+        QVariantMap hints;
+
+        const Mix mix = m_flood.mix == MixedMix ? Mix(i % MixedMix) : m_flood.mix;
+        switch (mix) {
+        case ImageMix:
+            if (m_flood.imageSize > 0)
+                hints.insert(QStringLiteral("image-data"), QVariant::fromValue(m_image));
+            break;
+        case ReplaceMix:
+            // Like a progress notification
+            replacesId = m_lastId;
+            summary = QStringLiteral("Progress");
+            body = QStringLiteral("%1%").arg(i % 100);
+            break;
+        case ActionsMix:
+            actions << QStringLiteral("default") << QStringLiteral("Open")
+                    << QStringLiteral("reply") << QStringLiteral("Reply");
+            break;
+        default:
+            break;
+        }
+
+        const qint64 sent = m_clock.nsecsElapsed();
+        hints.insert(sentHint, sent);
+
+        QDBusMessage msg = QDBusMessage::createMethodCall(QStringLiteral("org.freedesktop.Notifications"),
+                                                          QStringLiteral("/org/freedesktop/Notifications"),
+                                                          QStringLiteral("org.freedesktop.Notifications"),
+                                                          QStringLiteral("Notify"));
+        msg << appName << replacesId << QStringLiteral("dialog-information")
+            << summary << body << actions << hints << int(-1);
+
+        QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(m_bus.asyncCall(msg), this);
+        connect(watcher, &QDBusPendingCallWatcher::finished, this, [this, sent](QDBusPendingCallWatcher *self) {
+            m_latencies.append(m_clock.nsecsElapsed() - sent);
+
+            QDBusPendingReply<uint> reply = *self;
+            if (!reply.isError())
+                m_lastId = reply.value();
+            self->deleteLater();
+
+            if (++m_replies == m_flood.count)
+                Q_EMIT finished();
+        });
+    }
+};
+
+class TestNotificationsFlood : public QObject
+{
+    Q_OBJECT
+public:
+    TestNotificationsFlood(QObject *parent = 0)
+        : QObject(parent)
+    {
+    }
+
+private Q_SLOTS:
+    void initTestCase()
+    {
+        QVERIFY(m_dataDir.isValid());
+
+        // Keep the history away from the user data
+        qputenv("XDG_DATA_HOME", QFile::encodeName(m_dataDir.path()));
+
+        if (!m_bus.start())
+            QSKIP("Unable to start a private dbus-daemon");
+
+        qDBusRegisterMetaType<ImageData>();
+        m_clock.start();
+    }
+
+    void flood_data()
+    {
+        QTest::addColumn<int>("count");
+        QTest::addColumn<int>("rate");
+        QTest::addColumn<int>("sources");
+        QTest::addColumn<int>("imageSize");
+        QTest::addColumn<Mix>("mix");
+
+        // One source per notification unless we want the rate limiter in
+        QTest::newRow("text-100/s") << 500 << 100 << 500 << 0 << TextMix;
+        QTest::newRow("text-1000/s") << 2000 << 1000 << 2000 << 0 << TextMix;
+        QTest::newRow("image-64-100/s") << 300 << 100 << 300 << 64 << ImageMix;
+        QTest::newRow("image-256-100/s") << 300 << 100 << 300 << 256 << ImageMix;
+        QTest::newRow("image-1024-20/s") << 60 << 20 << 60 << 1024 << ImageMix;
+        QTest::newRow("replace-1000/s") << 1000 << 1000 << 1 << 0 << ReplaceMix;
+        QTest::newRow("actions-100/s") << 500 << 100 << 500 << 0 << ActionsMix;
+        QTest::newRow("mixed-200/s") << 1000 << 200 << 100 << 128 << MixedMix;
+        QTest::newRow("single-source-1000/s") << 1000 << 1000 << 1 << 0 << TextMix;
+    }
+
+    void flood()
+    {
+        QFETCH(int, count);
+        QFETCH(int, rate);
+        QFETCH(int, sources);
+        QFETCH(int, imageSize);
+        QFETCH(Mix, mix);
+
+        Notifications *notifications = new Notifications();
+        QVERIFY(notifications->isValid());
+
+        QVector<qint64> received;
+        received.reserve(count);
+        connect(notifications, &Notifications::notificationReceived, this,
+                [this, &received](uint, const QString &, const QString &, bool,
+                                  const QString &, const QString &, const QVariantList &,
+                                  bool, int, const QVariantMap &hints) {
+            received.append(m_clock.nsecsElapsed() - hints.value(sentHint).toLongLong());
+        });
+
+        const qint64 rssBefore = residentMemory();
+        const qint64 cpuBefore = threadCpuTime();
+
+        Flood flood;
+        flood.count = count;
+        flood.rate = rate;
+        flood.sources = sources;
+        flood.imageSize = imageSize;
+        flood.mix = mix;
+
+        QThread thread;
+        FloodClient *client = new FloodClient(m_bus.address(), flood, m_clock);
+        client->moveToThread(&thread);
+        bool done = false;
+        connect(client, &FloodClient::finished, this, [&done] { done = true; });
+        thread.start();
+        QMetaObject::invokeMethod(client, "start", Qt::QueuedConnection);
+
+        // The daemon runs on its own thread and hands notifications
+        // over to this one, wait until everything was drained
+        QVERIFY(TestUtils::waitFor([&done] { return done; }, 120000));
+        QVERIFY(TestUtils::waitFor([notifications, &received, count] {
+            const QVariantMap limits = notifications->rateLimitStatistics();
+            return received.size() + limits.value(QStringLiteral("dropped")).toInt() == count;
+        }, 120000));
+
+        const qint64 cpuTime = threadCpuTime() - cpuBefore;
+        const qint64 rssGrowth = residentMemory() - rssBefore;
+        const QVector<qint64> latencies = client->latencies();
+
+        client->deleteLater();
+        thread.quit();
+        thread.wait();
+
+        const QVariantMap limits = notifications->rateLimitStatistics();
+        const QVariantMap images = notifications->imageStoreStatistics();
+        const int dropped = limits.value(QStringLiteral("dropped")).toInt();
+        const int coalesced = limits.value(QStringLiteral("coalesced")).toInt();
+
+        qDebug("Notify latency (ms): median %.3f, 99th percentile %.3f, max %.3f",
+               percentile(latencies, 50), percentile(latencies, 99), percentile(latencies, 100));
+        qDebug("Notify to notificationReceived (ms): median %.3f, 99th percentile %.3f, max %.3f",
+               percentile(received, 50), percentile(received, 99), percentile(received, 100));
+        qDebug("GUI thread CPU per notification (us): %.1f", cpuTime / 1000.0 / count);
+        qDebug("Resident memory growth (KiB): %lld, images: %d using %d bytes",
+               rssGrowth / 1024,
+               images.value(QStringLiteral("images")).toInt(),
+               images.value(QStringLiteral("memoryUsage")).toInt());
+        qDebug("Received: %d, coalesced: %d, dropped: %d", received.size(), coalesced, dropped);
+
+        QCOMPARE(latencies.size(), count);
+        QCOMPARE(received.size() + dropped, count);
+
+        QTest::setBenchmarkResult(percentile(received, 50), QTest::WalltimeMilliseconds);
+
+        delete notifications;
+    }
+
+private:
+    QTemporaryDir m_dataDir;
+    PrivateBus m_bus;
+    QElapsedTimer m_clock;
+
+    static qreal percentile(QVector<qint64> values, int percent)
+    {
+        if (values.isEmpty())
+            return 0;
+
+        std::sort(values.begin(), values.end());
+        const int index = qMin(values.size() - 1, values.size() * percent / 100);
+        return values.at(index) / 1000000.0;
+    }
+
+    static qint64 threadCpuTime()
+    {
+        struct timespec ts;
+        clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+        return qint64(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+    }
+
+    static qint64 residentMemory()
+    {
+        QFile file(QStringLiteral("/proc/self/status"));
+        if (!file.open(QFile::ReadOnly | QFile::Text))
+            return 0;
+
+        Q_FOREACH (const QByteArray &line, file.readAll().split('\n')) {
+            if (line.startsWith("VmRSS:"))
+                return line.mid(6).trimmed().split(' ').value(0).toLongLong() * 1024;
+        }
+        return 0;
+    }
+};
+
+QTEST_GUILESS_MAIN(TestNotificationsFlood)
+
+#include "tst_notificationsflood.moc"
@@ -0,0 +1,191 @@
+/****************************************************************************
+ * This file is part of Hawaii.
+ *
+ * Copyright (C) 2016 Pier Luigi Fiorini
+ *
+ * Author(s):
+ *    Pier Luigi Fiorini <pierluigi.fiorini@gmail.com>
+ *
+ * $BEGIN_LICENSE:LGPL2.1+$
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * $END_LICENSE$
+ ***************************************************************************/
+
+#include <QtTest/QtTest>
+
+#include "notificationsimage.h"
+
+class TestNotificationsImageBenchmark : public QObject
+{
+    Q_OBJECT
+public:
+    TestNotificationsImageBenchmark(QObject *parent = 0)
+        : QObject(parent)
+    {
+    }
+
+private Q_SLOTS:
+    void decodeImageData_data()
+    {
+        imageData();
+    }
+
+    void decodeImageData()
+    {
+        QFETCH(int, size);
+        QFETCH(int, channels);
+
+        // Aligned lines are wrapped without copying
+        const int stride = size * channels;
+        const QByteArray pixels = generatePixels(size, stride, channels);
+        QImage image;
+        QBENCHMARK {
+            image = ::decodeImageData(size, size, stride, channels == 4, 8, channels, pixels);
+        }
+
+        QCOMPARE(image.constBits(), reinterpret_cast<const uchar *>(pixels.constData()));
+        QVERIFY(sameImage(image, reference(size, stride, channels, pixels)));
+    }
+
+    void decodeImageDataUnaligned_data()
+    {
+        imageData();
+    }
+
+    void decodeImageDataUnaligned()
+    {
+        QFETCH(int, size);
+        QFETCH(int, channels);
+
+        // Padding lines by one byte forces a conversion
+        const int stride = size * channels + 1;
+        const QByteArray pixels = generatePixels(size, stride, channels);
+        QImage image;
+        QBENCHMARK {
+            image = ::decodeImageData(size, size, stride, channels == 4, 8, channels, pixels);
+        }
+
+        QVERIFY(sameImage(image, reference(size, stride, channels, pixels)));
+    }
+
+    void convertToDisplayImage_data()
+    {
+        imageData();
+    }
+
+    void convertToDisplayImage()
+    {
+        QFETCH(int, size);
+        QFETCH(int, channels);
+
+        const int stride = size * channels;
+        const QByteArray pixels = generatePixels(size, stride, channels);
+        const QImage image = ::decodeImageData(size, size, stride, channels == 4, 8, channels, pixels);
+        QImage result;
+        QBENCHMARK {
+            result = ::convertToDisplayImage(image);
+        }
+
+        QVERIFY(sameImage(result, reference(size, stride, channels, pixels)));
+    }
+
+    void convertToFormat_data()
+    {
+        imageData();
+    }
+
+    void convertToFormat()
+    {
+        QFETCH(int, size);
+        QFETCH(int, channels);
+
+        // Baseline for convertToDisplayImage()
+        const int stride = size * channels;
+        const QByteArray pixels = generatePixels(size, stride, channels);
+        const QImage image = ::decodeImageData(size, size, stride, channels == 4, 8, channels, pixels);
+        const QImage::Format format = channels == 4
+                ? QImage::Format_ARGB32_Premultiplied : QImage::Format_RGB32;
+        QImage result;
+        QBENCHMARK {
+            result = image.convertToFormat(format);
+        }
+    }
+
+private:
+    void imageData()
+    {
+        QTest::addColumn<int>("size");
+        QTest::addColumn<int>("channels");
+
+        QTest::newRow("256x256-rgba") << 256 << 4;
+        QTest::newRow("256x256-rgb") << 256 << 3;
+        QTest::newRow("1024x1024-rgba") << 1024 << 4;
+        QTest::newRow("1024x1024-rgb") << 1024 << 3;
+    }
+
+    static QByteArray generatePixels(int size, int stride, int channels)
+    {
+        // Gradients with every alpha value
+        QByteArray pixels(stride * size, '\0');
+        for (int y = 0; y < size; y++) {
+            uchar *line = reinterpret_cast<uchar *>(pixels.data()) + y * stride;
+            for (int x = 0; x < size; x++) {
+                uchar *pixel = line + x * channels;
+                pixel[0] = x;
+                pixel[1] = y;
+                pixel[2] = x ^ y;
+                if (channels == 4)
+                    pixel[3] = x + y;
+            }
+        }
+        return pixels;
+    }
+
+    static QImage reference(int size, int stride, int channels, const QByteArray &pixels)
+    {
+        const QImage::Format format = channels == 4 ? QImage::Format_RGBA8888 : QImage::Format_RGB888;
+        const QImage image(reinterpret_cast<const uchar *>(pixels.constData()),
+                           size, size, stride, format);
+        return image.convertToFormat(channels == 4
+                                     ? QImage::Format_ARGB32_Premultiplied
+                                     : QImage::Format_RGB32);
+    }
+
+    static bool sameImage(const QImage &image, const QImage &expected)
+    {
+        if (image.size() != expected.size())
+            return false;
+
+        // Premultiplication is allowed to round differently
+        const QImage converted = image.convertToFormat(expected.format());
+        for (int y = 0; y < expected.height(); y++) {
+            const QRgb *a = reinterpret_cast<const QRgb *>(converted.constScanLine(y));
+            const QRgb *b = reinterpret_cast<const QRgb *>(expected.constScanLine(y));
+            for (int x = 0; x < expected.width(); x++) {
+                if (qAbs(qRed(a[x]) - qRed(b[x])) > 1 ||
+                        qAbs(qGreen(a[x]) - qGreen(b[x])) > 1 ||
+                        qAbs(qBlue(a[x]) - qBlue(b[x])) > 1 ||
+                        qAlpha(a[x]) != qAlpha(b[x]))
+                    return false;
+            }
+        }
+        return true;
+    }
+};
+
+QTEST_GUILESS_MAIN(TestNotificationsImageBenchmark)
+
+#include "tst_notificationsimagebenchmark.moc"
@@ -0,0 +1,261 @@
+/****************************************************************************
+ * This file is part of Hawaii.
+ *
+ * Copyright (C) 2016 Pier Luigi Fiorini
+ *
+ * Author(s):
+ *    Pier Luigi Fiorini <pierluigi.fiorini@gmail.com>
+ *
+ * $BEGIN_LICENSE:LGPL2.1+$
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * $END_LICENSE$
+ ***************************************************************************/
+
+#include <QtCore/QSocketNotifier>
+#include <QtDBus/QDBusConnection>
+#include <QtDBus/QDBusError>
+#include <QtDBus/QDBusMessage>
+
+#include "mocklogin1.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+/*
+ * MockLogin1Manager
+ */
+
+MockLogin1Manager::MockLogin1Manager(QObject *parent)
+    : MockService(parent)
+{
+}
+
+QString MockLogin1Manager::sessionPath(int vt)
+{
+    return QStringLiteral("/org/freedesktop/login1/session/_3%1").arg(vt);
+}
+
+QDBusObjectPath MockLogin1Manager::GetSessionByPID(uint pid)
+{
+    Q_UNUSED(pid);
+
+    const QDBusObjectPath path(sessionPath(1));
+    delayReply(QVariantList() << QVariant::fromValue(path),
+               QStringLiteral("GetSessionByPID"));
+    return path;
+}
+
+SessionInfoList MockLogin1Manager::ListSessions()
+{
+    SessionInfoList sessions;
+    for (int vt = 1; vt <= 2; vt++) {
+        SessionInfo info;
+        info.sessionId = QString::number(vt);
+        info.userId = 1000 + vt;
+        info.userName = QStringLiteral("user%1").arg(vt);
+        info.seatId = QStringLiteral("seat0");
+        info.sessionPath = QDBusObjectPath(sessionPath(vt));
+        sessions.append(info);
+    }
+
+    delayReply(QVariantList() << QVariant::fromValue(sessions),
+               QStringLiteral("ListSessions"));
+    return sessions;
+}
+
+void MockLogin1Manager::ActivateSession(const QString &id)
+{
+    Q_UNUSED(id);
+    delayReply(QVariantList(), QStringLiteral("ActivateSession"));
+}
+
+QDBusUnixFileDescriptor MockLogin1Manager::Inhibit(const QString &what, const QString &who,
+                                                   const QString &why, const QString &mode)
+{
+    Q_UNUSED(what);
+    Q_UNUSED(who);
+    Q_UNUSED(why);
+    Q_UNUSED(mode);
+
+    // Like logind we keep the read end and the inhibitor
+    // is released when all copies of the write end are closed
+    int fds[2];
+    if (::pipe2(fds, O_CLOEXEC) < 0) {
+        sendErrorReply(QDBusError::Failed, QStringLiteral("Unable to create pipe"));
+        return QDBusUnixFileDescriptor();
+    }
+
+    QDBusUnixFileDescriptor fd(fds[1]);
+    ::close(fds[1]);
+
+    const int readFd = fds[0];
+    QSocketNotifier *notifier = new QSocketNotifier(readFd, QSocketNotifier::Read, this);
+    connect(notifier, &QSocketNotifier::activated, this, [this, notifier, readFd] {
+        char buffer[16];
+        if (::read(readFd, buffer, sizeof(buffer)) > 0)
+            return;
+
+        notifier->setEnabled(false);
+        notifier->deleteLater();
+        ::close(readFd);
+        Q_EMIT handled(QStringLiteral("InhibitorReleased"));
+    });
+
+    delayReply(QVariantList() << QVariant::fromValue(fd), QStringLiteral("Inhibit"));
+    return fd;
+}
+
+QString MockLogin1Manager::CanPowerOff()
+{
+    return capability(QStringLiteral("CanPowerOff"));
+}
+
+QString MockLogin1Manager::CanReboot()
+{
+    return capability(QStringLiteral("CanReboot"));
+}
+
+QString MockLogin1Manager::CanSuspend()
+{
+    return capability(QStringLiteral("CanSuspend"));
+}
+
+QString MockLogin1Manager::CanHibernate()
+{
+    return capability(QStringLiteral("CanHibernate"));
+}
+
+QString MockLogin1Manager::CanHybridSleep()
+{
+    return capability(QStringLiteral("CanHybridSleep"));
+}
+
+void MockLogin1Manager::PowerOff(bool interactive)
+{
+    Q_UNUSED(interactive);
+    action(QStringLiteral("PowerOff"));
+}
+
+void MockLogin1Manager::Reboot(bool interactive)
+{
+    Q_UNUSED(interactive);
+    action(QStringLiteral("Reboot"));
+}
+
+void MockLogin1Manager::Suspend(bool interactive)
+{
+    Q_UNUSED(interactive);
+    action(QStringLiteral("Suspend"));
+}
+
+void MockLogin1Manager::Hibernate(bool interactive)
+{
+    Q_UNUSED(interactive);
+    action(QStringLiteral("Hibernate"));
+}
+
+void MockLogin1Manager::HybridSleep(bool interactive)
+{
+    Q_UNUSED(interactive);
+    action(QStringLiteral("HybridSleep"));
+}
+
+QString MockLogin1Manager::capability(const QString &event)
+{
+    const QString answer = QStringLiteral("yes");
+    delayReply(QVariantList() << answer, event);
+    return answer;
+}
+
+void MockLogin1Manager::action(const QString &event)
+{
+    // Nobody wants the CI box to actually go to sleep
+    delayReply(QVariantList(), event);
+}
+
+/*
+ * MockLogin1Session
+ */
+
+MockLogin1Session::MockLogin1Session(int vt, QObject *parent)
+    : MockService(parent)
+    , m_vt(vt)
+    , m_idleHint(false)
+{
+}
+
+QString MockLogin1Session::id() const
+{
+    return QString::number(m_vt);
+}
+
+uint MockLogin1Session::vtNr() const
+{
+    return m_vt;
+}
+
+bool MockLogin1Session::idleHint() const
+{
+    return m_idleHint;
+}
+
+void MockLogin1Session::Activate()
+{
+    delayReply(QVariantList(), QStringLiteral("Activate"));
+}
+
+void MockLogin1Session::Lock()
+{
+    const QDBusConnection bus = connection();
+    delayReply(QVariantList(), QStringLiteral("Lock"), [this, bus] {
+        emitSignal(bus, QStringLiteral("Lock"));
+    });
+}
+
+void MockLogin1Session::Unlock()
+{
+    const QDBusConnection bus = connection();
+    delayReply(QVariantList(), QStringLiteral("Unlock"), [this, bus] {
+        emitSignal(bus, QStringLiteral("Unlock"));
+    });
+}
+
+void MockLogin1Session::SetIdleHint(bool idle)
+{
+    m_idleHint = idle;
+    delayReply(QVariantList(), QStringLiteral("SetIdleHint"));
+}
+
+void MockLogin1Session::TakeControl(bool force)
+{
+    Q_UNUSED(force);
+    delayReply(QVariantList(), QStringLiteral("TakeControl"));
+}
+
+void MockLogin1Session::ReleaseControl()
+{
+    delayReply(QVariantList(), QStringLiteral("ReleaseControl"));
+}
+
+void MockLogin1Session::emitSignal(const QDBusConnection &bus, const QString &name)
+{
+    QDBusMessage msg = QDBusMessage::createSignal(MockLogin1Manager::sessionPath(m_vt),
+                                                  QStringLiteral("org.freedesktop.login1.Session"),
+                                                  name);
+    bus.send(msg);
+}
+
+#include "moc_mocklogin1.cpp"
@@ -0,0 +1,116 @@
+/****************************************************************************
+ * This file is part of Hawaii.
+ *
+ * Copyright (C) 2016 Pier Luigi Fiorini
+ *
+ * Author(s):
+ *    Pier Luigi Fiorini <pierluigi.fiorini@gmail.com>
+ *
+ * $BEGIN_LICENSE:LGPL2.1+$
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * $END_LICENSE$
+ ***************************************************************************/
+
+#ifndef MOCKLOGIN1_H
+#define MOCKLOGIN1_H
+
+#include <QtDBus/QDBusConnection>
+#include <QtDBus/QDBusObjectPath>
+#include <QtDBus/QDBusUnixFileDescriptor>
+
+#include "mockservice.h"
+#include "qlogind/src/types.h"
+
+class MockLogin1Session;
+
+/*!
+ * \brief Mock of the org.freedesktop.login1 manager.
+ *
+ * The current process owns session "1" on vt 1, session "2"
+ * on vt 2 belongs to another user.  Power management methods
+ * say "yes" to everything and inhibitors are real file
+ * descriptors, whose release is reported as "InhibitorReleased".
+ */
+class MockLogin1Manager : public MockService
+{
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "org.freedesktop.login1.Manager")
+public:
+    MockLogin1Manager(QObject *parent = Q_NULLPTR);
+
+    static QString sessionPath(int vt);
+
+public Q_SLOTS:
+    QDBusObjectPath GetSessionByPID(uint pid);
+    SessionInfoList ListSessions();
+    void ActivateSession(const QString &id);
+
+    QDBusUnixFileDescriptor Inhibit(const QString &what, const QString &who,
+                                    const QString &why, const QString &mode);
+
+    QString CanPowerOff();
+    QString CanReboot();
+    QString CanSuspend();
+    QString CanHibernate();
+    QString CanHybridSleep();
+
+    void PowerOff(bool interactive);
+    void Reboot(bool interactive);
+    void Suspend(bool interactive);
+    void Hibernate(bool interactive);
+    void HybridSleep(bool interactive);
+
+private:
+    QString capability(const QString &event);
+    void action(const QString &event);
+};
+
+/*!
+ * \brief Mock of an org.freedesktop.login1 session.
+ *
+ * Lock and Unlock emit the corresponding signals once
+ * the call has been answered, like logind does.
+ */
+class MockLogin1Session : public MockService
+{
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "org.freedesktop.login1.Session")
+    Q_PROPERTY(QString Id READ id)
+    Q_PROPERTY(uint VTNr READ vtNr)
+    Q_PROPERTY(bool IdleHint READ idleHint)
+public:
+    MockLogin1Session(int vt, QObject *parent = Q_NULLPTR);
+
+    QString id() const;
+    uint vtNr() const;
+    bool idleHint() const;
+
+public Q_SLOTS:
+    void Activate();
+    void Lock();
+    void Unlock();
+    void SetIdleHint(bool idle);
+    void TakeControl(bool force);
+    void ReleaseControl();
+
+private:
+    int m_vt;
+    bool m_idleHint;
+
+    void emitSignal(const QDBusConnection &bus, const QString &name);
+};
+
+#endif // MOCKLOGIN1_H
@@ -0,0 +1,65 @@
+/****************************************************************************
+ * This file is part of Hawaii.
+ *
+ * Copyright (C) 2016 Pier Luigi Fiorini
+ *
+ * Author(s):
+ *    Pier Luigi Fiorini <pierluigi.fiorini@gmail.com>
+ *
+ * $BEGIN_LICENSE:LGPL2.1+$
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * $END_LICENSE$
+ ***************************************************************************/
+
+#include <QtCore/QTimer>
+#include <QtDBus/QDBusConnection>
+#include <QtDBus/QDBusMessage>
+
+#include "mockservice.h"
+
+MockService::MockService(QObject *parent)
+    : QObject(parent)
+    , m_latency(0)
+{
+}
+
+int MockService::latency() const
+{
+    return m_latency.load();
+}
+
+void MockService::setLatency(int msecs)
+{
+    m_latency.store(msecs);
+}
+
+void MockService::delayReply(const QVariantList &arguments, const QString &event,
+                             const std::function<void()> &then)
+{
+    setDelayedReply(true);
+
+    QDBusConnection bus = connection();
+    QDBusMessage reply = message().createReply(arguments);
+
+    QTimer::singleShot(latency(), Qt::PreciseTimer, this, [this, bus, reply, event, then]() {
+        bus.send(reply);
+        if (then)
+            then();
+        Q_EMIT handled(event);
+    });
+}
+
+#include "moc_mockservice.cpp"
@@ -0,0 +1,64 @@
+/****************************************************************************
+ * This file is part of Hawaii.
+ *
+ * Copyright (C) 2016 Pier Luigi Fiorini
+ *
+ * Author(s):
+ *    Pier Luigi Fiorini <pierluigi.fiorini@gmail.com>
+ *
+ * $BEGIN_LICENSE:LGPL2.1+$
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * $END_LICENSE$
+ ***************************************************************************/
+
+#ifndef MOCKSERVICE_H
+#define MOCKSERVICE_H
+
+#include <QtCore/QAtomicInt>
+#include <QtCore/QObject>
+#include <QtCore/QVariantList>
+#include <QtDBus/QDBusContext>
+
+#include <functional>
+
+/*!
+ * \brief Base class for mock system services.
+ *
+ * Replies are always delayed by the configured latency,
+ * to simulate a busy or slow system service.
+ */
+class MockService : public QObject, protected QDBusContext
+{
+    Q_OBJECT
+public:
+    MockService(QObject *parent = Q_NULLPTR);
+
+    int latency() const;
+    void setLatency(int msecs);
+
+Q_SIGNALS:
+    // Emitted from the mock thread after replying to a call
+    void handled(const QString &event);
+
+protected:
+    void delayReply(const QVariantList &arguments, const QString &event,
+                    const std::function<void()> &then = std::function<void()>());
+
+private:
+    QAtomicInt m_latency;
+};
+
+#endif // MOCKSERVICE_H
@@ -0,0 +1,177 @@
+/****************************************************************************
+ * This file is part of Hawaii.
+ *
+ * Copyright (C) 2016 Pier Luigi Fiorini
+ *
+ * Author(s):
+ *    Pier Luigi Fiorini <pierluigi.fiorini@gmail.com>
+ *
+ * $BEGIN_LICENSE:LGPL2.1+$
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * $END_LICENSE$
+ ***************************************************************************/
+
+#include <QtCore/QCoreApplication>
+#include <QtCore/QThread>
+#include <QtDBus/QDBusConnection>
+#include <QtDBus/QDBusMessage>
+
+#include "mocklogin1.h"
+#include "mocksystembus.h"
+#include "mockupower.h"
+#include "testutils.h"
+
+static const QString connectionName = QStringLiteral("hawaii-mock-system-services");
+
+MockSystemBus::MockSystemBus(QObject *parent)
+    : QObject(parent)
+    , m_thread(new QThread(this))
+{
+}
+
+MockSystemBus::~MockSystemBus()
+{
+    QDBusConnection::disconnectFromBus(connectionName);
+
+    // Deferred deletions are processed when the thread finishes
+    Q_FOREACH (MockService *service, m_services)
+        service->deleteLater();
+    m_thread->quit();
+    m_thread->wait();
+}
+
+bool MockSystemBus::start()
+{
+    // The private bus is the session bus already
+    if (!m_bus.start())
+        return false;
+    const QString address = m_bus.address();
+
+    // Must be set before QtDBus connects to the system bus
+    qputenv("DBUS_SYSTEM_BUS_ADDRESS", address.toLocal8Bit());
+
+    // Mock methods use qlogind types
+    registerTypes();
+
+    QDBusConnection bus = QDBusConnection::connectToBus(address, connectionName);
+    if (!bus.isConnected())
+        return false;
+
+    MockLogin1Manager *manager = new MockLogin1Manager;
+    MockLogin1Session *session = new MockLogin1Session(1);
+    MockLogin1Session *otherSession = new MockLogin1Session(2);
+    MockUPower *upower = new MockUPower;
+    m_services << manager << session << otherSession << upower;
+
+    Q_FOREACH (MockService *service, m_services) {
+        service->moveToThread(m_thread);
+        connect(service, &MockService::handled,
+                this, &MockSystemBus::recordEvent);
+    }
+    m_thread->start();
+
+    return registerObject(QStringLiteral("/org/freedesktop/login1"), manager) &&
+            registerObject(MockLogin1Manager::sessionPath(1), session) &&
+            registerObject(MockLogin1Manager::sessionPath(2), otherSession) &&
+            registerObject(QStringLiteral("/org/freedesktop/UPower"), upower) &&
+            registerService(QStringLiteral("org.freedesktop.login1")) &&
+            registerService(QStringLiteral("org.freedesktop.UPower"));
+}
+
+QString MockSystemBus::address() const
+{
+    return m_bus.address();
+}
+
+void MockSystemBus::setLatency(int msecs)
+{
+    Q_FOREACH (MockService *service, m_services)
+        service->setLatency(msecs);
+}
+
+int MockSystemBus::events(const QString &name) const
+{
+    return m_events.value(name);
+}
+
+bool MockSystemBus::waitForEvents(const QString &name, int count, int timeout)
+{
+    return TestUtils::waitFor([this, name, count] {
+        return m_events.value(name) >= count;
+    }, timeout);
+}
+
+void MockSystemBus::emitManagerSignal(const QString &name, const QVariantList &arguments)
+{
+    QDBusMessage msg = QDBusMessage::createSignal(QStringLiteral("/org/freedesktop/login1"),
+                                                  QStringLiteral("org.freedesktop.login1.Manager"),
+                                                  name);
+    msg.setArguments(arguments);
+    QDBusConnection(connectionName).send(msg);
+}
+
+void MockSystemBus::callSession(int vt, const QString &method)
+{
+    // Like loginctl would do
+    QDBusMessage msg = QDBusMessage::createMethodCall(QStringLiteral("org.freedesktop.login1"),
+                                                      MockLogin1Manager::sessionPath(vt),
+                                                      QStringLiteral("org.freedesktop.login1.Session"),
+                                                      method);
+    QDBusConnection::systemBus().asyncCall(msg);
+}
+
+void MockSystemBus::flush()
+{
+    // Messages from the mock services are delivered in order, once
+    // the answer to a ping is back every previous reply has been
+    // received and only needs to be dispatched
+    QDBusMessage msg = QDBusMessage::createMethodCall(QStringLiteral("org.freedesktop.login1"),
+                                                      QStringLiteral("/org/freedesktop/login1"),
+                                                      QStringLiteral("org.freedesktop.DBus.Peer"),
+                                                      QStringLiteral("Ping"));
+    QDBusConnection::systemBus().call(msg);
+    QCoreApplication::processEvents();
+}
+
+void MockSystemBus::recordEvent(const QString &name)
+{
+    m_events[name]++;
+}
+
+bool MockSystemBus::registerService(const QString &service)
+{
+    QDBusConnection bus(connectionName);
+    if (!bus.registerService(service)) {
+        qWarning("Unable to register %s on the mock bus", qPrintable(service));
+        return false;
+    }
+
+    return true;
+}
+
+bool MockSystemBus::registerObject(const QString &path, MockService *object)
+{
+    QDBusConnection bus(connectionName);
+    if (!bus.registerObject(path, object, QDBusConnection::ExportAllSlots |
+                            QDBusConnection::ExportAllProperties)) {
+        qWarning("Unable to register %s on the mock bus", qPrintable(path));
+        return false;
+    }
+
+    return true;
+}
+
+#include "moc_mocksystembus.cpp"
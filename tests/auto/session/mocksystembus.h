@@ -0,0 +1,85 @@
+/****************************************************************************
+ * This file is part of Hawaii.
+ *
+ * Copyright (C) 2016 Pier Luigi Fiorini
+ *
+ * Author(s):
+ *    Pier Luigi Fiorini <pierluigi.fiorini@gmail.com>
+ *
+ * $BEGIN_LICENSE:LGPL2.1+$
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * $END_LICENSE$
+ ***************************************************************************/
+
+#ifndef MOCKSYSTEMBUS_H
+#define MOCKSYSTEMBUS_H
+
+#include <QtCore/QHash>
+#include <QtCore/QObject>
+#include <QtCore/QVariantList>
+
+#include "privatebus.h"
+
+class QThread;
+
+class MockService;
+
+/*!
+ * \brief Private D-Bus daemon with mock system services.
+ *
+ * Spawns a dbus-daemon that serves as both the system and the
+ * session bus of the test process, and registers mock logind and
+ * UPower services on it.  Mock services run in their own thread,
+ * so that blocking calls made by the code under test are answered.
+ *
+ * Every answered call is recorded as an event named after the
+ * method, tests wait for events to know when a round trip is over.
+ */
+class MockSystemBus : public QObject
+{
+    Q_OBJECT
+public:
+    MockSystemBus(QObject *parent = Q_NULLPTR);
+    ~MockSystemBus();
+
+    bool start();
+
+    QString address() const;
+
+    void setLatency(int msecs);
+
+    int events(const QString &name) const;
+    bool waitForEvents(const QString &name, int count, int timeout = 5000);
+
+    void emitManagerSignal(const QString &name, const QVariantList &arguments);
+    void callSession(int vt, const QString &method);
+
+    void flush();
+
+private Q_SLOTS:
+    void recordEvent(const QString &name);
+
+private:
+    PrivateBus m_bus;
+    QThread *m_thread;
+    QList<MockService *> m_services;
+    QHash<QString, int> m_events;
+
+    bool registerService(const QString &service);
+    bool registerObject(const QString &path, MockService *object);
+};
+
+#endif // MOCKSYSTEMBUS_H
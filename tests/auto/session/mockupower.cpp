@@ -0,0 +1,56 @@
+/****************************************************************************
+ * This file is part of Hawaii.
+ *
+ * Copyright (C) 2016 Pier Luigi Fiorini
+ *
+ * Author(s):
+ *    Pier Luigi Fiorini <pierluigi.fiorini@gmail.com>
+ *
+ * $BEGIN_LICENSE:LGPL2.1+$
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * $END_LICENSE$
+ ***************************************************************************/
+
+#include "mockupower.h"
+
+MockUPower::MockUPower(QObject *parent)
+    : MockService(parent)
+{
+}
+
+bool MockUPower::SuspendAllowed()
+{
+    delayReply(QVariantList() << true, QStringLiteral("SuspendAllowed"));
+    return true;
+}
+
+bool MockUPower::HibernateAllowed()
+{
+    delayReply(QVariantList() << true, QStringLiteral("HibernateAllowed"));
+    return true;
+}
+
+void MockUPower::Suspend()
+{
+    delayReply(QVariantList(), QStringLiteral("Suspend"));
+}
+
+void MockUPower::Hibernate()
+{
+    delayReply(QVariantList(), QStringLiteral("Hibernate"));
+}
+
+#include "moc_mockupower.cpp"
@@ -0,0 +1,50 @@
+/****************************************************************************
+ * This file is part of Hawaii.
+ *
+ * Copyright (C) 2016 Pier Luigi Fiorini
+ *
+ * Author(s):
+ *    Pier Luigi Fiorini <pierluigi.fiorini@gmail.com>
+ *
+ * $BEGIN_LICENSE:LGPL2.1+$
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * $END_LICENSE$
+ ***************************************************************************/
+
+#ifndef MOCKUPOWER_H
+#define MOCKUPOWER_H
+
+#include "mockservice.h"
+
+/*!
+ * \brief Mock of the legacy UPower power management methods.
+ */
+class MockUPower : public MockService
+{
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "org.freedesktop.UPower")
+public:
+    MockUPower(QObject *parent = Q_NULLPTR);
+
+public Q_SLOTS:
+    bool SuspendAllowed();
+    bool HibernateAllowed();
+
+    void Suspend();
+    void Hibernate();
+};
+
+#endif // MOCKUPOWER_H
@@ -0,0 +1,264 @@
+/****************************************************************************
+ * This file is part of Hawaii.
+ *
+ * Copyright (C) 2016 Pier Luigi Fiorini
+ *
+ * Author(s):
+ *    Pier Luigi Fiorini <pierluigi.fiorini@gmail.com>
+ *
+ * $BEGIN_LICENSE:LGPL2.1+$
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * $END_LICENSE$
+ ***************************************************************************/
+
+#include <QtDBus/QDBusConnection>
+#include <QtTest/QtTest>
+
+#include <Hawaii/GSettings/QGSettings>
+
+#include "mocksystembus.h"
+#include "testutils.h"
+#include "sessionmanager/dbuscallcounter.h"
+#include "sessionmanager/sessionmanager.h"
+#include "sessionmanager/loginmanager/logindbackend.h"
+#include "sessionmanager/powermanager/powermanager.h"
+
+static const QString logind = QStringLiteral("logind");
+static const QString power = QStringLiteral("power");
+
+class TestSessionBenchmark : public QObject
+{
+    Q_OBJECT
+public:
+    TestSessionBenchmark(QObject *parent = 0)
+        : QObject(parent)
+        , m_sessionManager(Q_NULLPTR)
+    {
+    }
+
+private Q_SLOTS:
+    void initTestCase()
+    {
+        if (!m_bus.start())
+            QSKIP("Unable to start a private dbus-daemon");
+
+        if (!Hawaii::QGSettings::isSchemaInstalled(QStringLiteral("org.hawaiios.shell.throttle")))
+            QSKIP("org.hawaiios.shell.throttle settings schema is not installed");
+
+        // Wait for the session manager to settle: session object,
+        // idle hint, inhibitors and the list of sessions
+        m_sessionManager = new SessionManager(this);
+        QVERIFY(m_bus.waitForEvents(QStringLiteral("GetSessionByPID"), 1));
+        QVERIFY(m_bus.waitForEvents(QStringLiteral("SetIdleHint"), 1));
+        QVERIFY(m_bus.waitForEvents(QStringLiteral("Inhibit"), 1));
+        QVERIFY(m_bus.waitForEvents(QStringLiteral("ListSessions"), 1));
+    }
+
+    void cleanupTestCase()
+    {
+        // Before the bus goes away
+        delete m_sessionManager;
+        m_sessionManager = Q_NULLPTR;
+    }
+
+    void cleanup()
+    {
+        m_bus.setLatency(0);
+    }
+
+    void capabilities_data()
+    {
+        latencyData();
+    }
+
+    void capabilities()
+    {
+        QFETCH(int, latency);
+        m_bus.setLatency(latency);
+
+        const PowerManager::Capabilities expected =
+                PowerManager::PowerOff | PowerManager::Restart |
+                PowerManager::Suspend | PowerManager::Hibernate |
+                PowerManager::HybridSleep;
+        const quint64 blocking = DBusCallCounter::count(power, DBusCallCounter::BlockingCall);
+
+        // From the moment services are looked up to when all
+        // the backends have answered
+        QBENCHMARK {
+            PowerManager manager;
+            QVERIFY(TestUtils::waitFor([&manager, expected] {
+                return manager.capabilities() == expected;
+            }));
+        }
+
+        QCOMPARE(DBusCallCounter::count(power, DBusCallCounter::BlockingCall), blocking);
+    }
+
+    void idleHint_data()
+    {
+        latencyData();
+    }
+
+    void idleHint()
+    {
+        QFETCH(int, latency);
+        m_bus.setLatency(latency);
+
+        const quint64 blocking = DBusCallCounter::count(logind, DBusCallCounter::BlockingCall);
+
+        QBENCHMARK {
+            const int count = m_bus.events(QStringLiteral("SetIdleHint"));
+            m_sessionManager->setIdle(!m_sessionManager->isIdle());
+            QVERIFY(m_bus.waitForEvents(QStringLiteral("SetIdleHint"), count + 1));
+        }
+
+        QCOMPARE(DBusCallCounter::count(logind, DBusCallCounter::BlockingCall), blocking);
+    }
+
+    void lockUnlock_data()
+    {
+        latencyData();
+    }
+
+    void lockUnlock()
+    {
+        QFETCH(int, latency);
+        m_bus.setLatency(latency);
+
+        SessionManager *sm = m_sessionManager;
+        QVERIFY(!sm->isLocked());
+
+        // Lock and unlock requested to logind, for example by loginctl,
+        // until the session manager changes state
+        QBENCHMARK {
+            m_bus.callSession(1, QStringLiteral("Lock"));
+            QVERIFY(TestUtils::waitFor([sm] { return sm->isLocked(); }));
+            m_bus.callSession(1, QStringLiteral("Unlock"));
+            QVERIFY(TestUtils::waitFor([sm] { return !sm->isLocked(); }));
+        }
+    }
+
+    void vtSwitch_data()
+    {
+        latencyData();
+    }
+
+    void vtSwitch()
+    {
+        QFETCH(int, latency);
+        m_bus.setLatency(latency);
+
+        // Sessions are loaded asynchronously, wait until
+        // switching to the other session works
+        QVERIFY(TestUtils::waitFor([this] {
+            const int count = m_bus.events(QStringLiteral("ActivateSession"));
+            m_sessionManager->activateSession(2);
+            return m_bus.waitForEvents(QStringLiteral("ActivateSession"), count + 1, 100 + latency);
+        }));
+
+        const quint64 blocking = DBusCallCounter::count(logind, DBusCallCounter::BlockingCall);
+
+        QBENCHMARK {
+            const int count = m_bus.events(QStringLiteral("ActivateSession"));
+            m_sessionManager->activateSession(2);
+            QVERIFY(m_bus.waitForEvents(QStringLiteral("ActivateSession"), count + 1));
+        }
+
+        QCOMPARE(DBusCallCounter::count(logind, DBusCallCounter::BlockingCall), blocking);
+    }
+
+    void sleepInhibitor_data()
+    {
+        latencyData();
+    }
+
+    void sleepInhibitor()
+    {
+        QFETCH(int, latency);
+        m_bus.setLatency(latency);
+
+        SessionManager *sm = m_sessionManager;
+        QVERIFY(!sm->isLocked());
+
+        int inhibits = m_bus.events(QStringLiteral("Inhibit"));
+        int releases = m_bus.events(QStringLiteral("InhibitorReleased"));
+
+        // Play the shell, which renders the lock screen on the next frame
+        QMetaObject::Connection connection =
+                connect(sm, &SessionManager::lockScreenFrameRequested,
+                        sm, &SessionManager::lockScreenRendered, Qt::QueuedConnection);
+
+        const quint64 blocking = DBusCallCounter::count(logind, DBusCallCounter::BlockingCall);
+
+        // Suspend: lock and release the delay inhibitor once the lock
+        // screen is rendered; resume: unlock and take the inhibitor again
+        QBENCHMARK {
+            m_bus.emitManagerSignal(QStringLiteral("PrepareForSleep"), QVariantList() << true);
+            QVERIFY(m_bus.waitForEvents(QStringLiteral("InhibitorReleased"), ++releases));
+            QVERIFY(sm->isLocked());
+
+            m_bus.emitManagerSignal(QStringLiteral("PrepareForSleep"), QVariantList() << false);
+            m_bus.callSession(1, QStringLiteral("Unlock"));
+            QVERIFY(m_bus.waitForEvents(QStringLiteral("Inhibit"), ++inhibits));
+            QVERIFY(!sm->isLocked());
+            m_bus.flush();
+        }
+
+        disconnect(connection);
+
+        QCOMPARE(DBusCallCounter::count(logind, DBusCallCounter::BlockingCall), blocking);
+
+        const QVariantMap timings = sm->sleepTimings();
+        QVERIFY(timings.value(QStringLiteral("suspendPrepare")).toLongLong() >= 0);
+        qDebug() << "Last sleep timings:" << timings;
+    }
+
+    void shutdownRequest()
+    {
+        QScopedPointer<LogindBackend> backend(LogindBackend::create(m_sessionManager));
+        QVERIFY(backend);
+
+        int requests = 0;
+        connect(backend.data(), &LogindBackend::logOutRequested, this, [&requests] {
+            requests++;
+        });
+
+        // The session manager quits the application when asked
+        // to log out, which is harmless without an event loop
+        QBENCHMARK {
+            const int count = requests;
+            m_bus.emitManagerSignal(QStringLiteral("PrepareForShutdown"), QVariantList() << true);
+            QVERIFY(TestUtils::waitFor([&requests, count] { return requests > count; }));
+        }
+    }
+
+private:
+    MockSystemBus m_bus;
+    SessionManager *m_sessionManager;
+
+    void latencyData()
+    {
+        QTest::addColumn<int>("latency");
+
+        QTest::newRow("0ms") << 0;
+        QTest::newRow("1ms") << 1;
+        QTest::newRow("10ms") << 10;
+    }
+};
+
+QTEST_GUILESS_MAIN(TestSessionBenchmark)
+
+#include "tst_sessionbenchmark.moc"